@@ -1,147 +1,434 @@
-// cloned from: https://qiita.com/y-tsutsu/items/1e88212b8532fc693c3c
-
 #include <GLES2/gl2.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
-#include <math.h>
-#include <unistd.h>
+#include <memory>
 #include <vector>
-#define degree2radian(degree) ((degree * M_PI) / 180.0F)
 
 #include <EGL/egl.h>
 #include <X11/Xlib.h>
 #include <iostream>
 
+#include "app/app.h"
+#include "app/demo_scene.h"
+#include "app/event_loop.h"
+#include "app/frame_capture.h"
+#include "app/frame_pipeline.h"
+#include "app/frame_recorder.h"
+#include "app/frame_scheduler.h"
+#include "app/hud.h"
+#include "app/resource_loader.h"
+#include "base/clock.h"
+#include "base/frame_arena.h"
+#include "base/trace.h"
 #include "egl/aegl.h"
-#include "gles2/shader.h"
-#include "gles2/texture.h"
+#include "gles2/program_cache.h"
+#include "gles2/state.h"
 #include "gles2/utils.h"
 #include "window/awindow_x11.h"
 
 namespace App {
 
-void mainloop(EGLDisplay display, EGLSurface surface) {
-  const char *vshader = R"(
-        attribute vec4 vPosition;
-        uniform mediump mat4 mRotation;
-        void main() {
-            gl_Position = mRotation * vPosition;
-        }
-    )";
+namespace {
 
-  const char *fshader = R"(
-        precision mediump float;
-        void main() {
-            gl_FragColor = vec4(0.3, 0.8, 0.3, 1.0);
-        }
-    )";
-
-  const char *texture_vshader = R"(
-        attribute vec4 a_position;
-        attribute vec2 a_uv;
-        varying mediump vec2 v_uv;
-        void main() {
-            gl_Position = a_position;
-            v_uv = a_uv;
-        }
-    )";
+// resource loading steps, in order
+enum Task { kSceneTask, kQuadTextureTask, kMeshTask, kHudTask, kTaskCount };
 
-  const char *texture_fshader = R"(
-        uniform sampler2D u_texture;
-        varying mediump vec2 v_uv;
-        void main() {
-            gl_FragColor = texture2D(u_texture, v_uv);
-        }
-    )";
+// placeholders are redrawn at most this often, whatever the mode, so that
+// they leave the CPU to the loader; a finished task redraws at once
+constexpr int64_t kPlaceholderIntervalNs = kNsPerSec / 60;
+
+// drawn while the scene is loading; needs no program, only scissored clears
+void drawPlaceholder(int loaded, int width, int height) {
+  GlES2State &gl = GlES2State::current();
+  gl.clearColor(0.1f, 0.1f, 0.15f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // a progress bar
+  gl.setEnabled(GL_SCISSOR_TEST, true);
+  glScissor(width / 4, height / 2 - 4, width / 2 * (loaded + 1) / kTaskCount,
+            8);
+  gl.clearColor(0.25f, 0.25f, 0.5f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  gl.setEnabled(GL_SCISSOR_TEST, false);
+}
+
+void printTextureInfo(const Etc1LoadInfo &info) {
+  std::cout << "texture: " << info.width << "x" << info.height << " "
+            << info.levels << " level(s) "
+            << (info.compressed ? "ETC1" : "decoded to RGBA")
+            << " load_ms=" << info.load_ns / 1e6
+            << " gpu_KiB=" << info.gpu_bytes / 1024
+            << " rgba_KiB=" << info.rgba_bytes / 1024 << std::endl;
+}
+
+void printMeshInfo(const MeshLoadInfo &info) {
+  std::cout << "mesh: " << info.triangles << " triangles, " << info.vertices
+            << " vertices in " << info.chunks
+            << " chunk(s) load_ms=" << info.load_ns / 1e6
+            << " file_KiB=" << info.file_bytes / 1024
+            << " float_KiB=" << info.float_bytes / 1024 << std::endl;
+}
+
+} // namespace
 
-  GlES2ShaderProgram shader_program;
-  if (!shader_program.initialize(vshader, fshader)) {
+void mainloop(const AEgl &egl, AWindow *window, const Config &config) {
+  const int64_t start_ns = monotonicNowNs();
+  const EGLDisplay display = egl.getDisplay();
+  const EGLSurface surface = egl.getSurface();
+  EGLint surface_width = 0, surface_height = 0;
+  eglQuerySurface(display, surface, EGL_WIDTH, &surface_width);
+  eglQuerySurface(display, surface, EGL_HEIGHT, &surface_height);
+  // follows resizes
+  int width = surface_width, height = surface_height;
+
+  // built by the loader thread unless |config.sync_load|; the render thread
+  // touches them only once their task is ready
+  GlES2ProgramCache program_cache(config.shader_cache_dir);
+  DemoScene scene;
+  Etc1LoadInfo texture_info;
+  MeshLoadInfo mesh_info;
+  Hud hud;
+  scene.setCulling(config.cull, config.cull_threads);
+  std::vector<ResourceLoader::Task> tasks(kTaskCount);
+  tasks[kSceneTask] = [&] {
+    return scene.initialize(&program_cache, config.entities, surface_width,
+                            surface_height);
+  };
+  tasks[kQuadTextureTask] = [&] {
+    if (!config.texture.empty())
+      return scene.loadTexture(config.texture, &texture_info);
+    if (config.pipeline.producers > 0)
+      return true; // filled by the pipeline
+    // a single still frame
+    std::vector<unsigned char> image_buffer(DemoScene::kFrameWidth *
+                                            DemoScene::kFrameHeight * 4);
+    PipelineFrame frame;
+    frame.data = image_buffer.data();
+    DemoScene::fillFrame(&frame);
+    scene.texture().update(image_buffer.data());
+    return true;
+  };
+  tasks[kMeshTask] = [&] {
+    return config.mesh.empty() ||
+           scene.loadMesh(&program_cache, config.mesh, &mesh_info);
+  };
+  tasks[kHudTask] = [&] {
+    return !config.hud || hud.initialize(&program_cache);
+  };
+
+  // before the loader and the pipeline, whose threads wake it
+  EventLoop events;
+  if (!events.initialize(window))
     return;
+
+  ResourceLoader loader;
+  int loaded = 0;
+  if (config.sync_load) {
+    for (; loaded < kTaskCount; ++loaded) {
+      if (!tasks[loaded]())
+        return;
+    }
+    if (!config.texture.empty())
+      printTextureInfo(texture_info);
+    if (!config.mesh.empty())
+      printMeshInfo(mesh_info);
+  } else {
+    loader.setReadyCallback([&events] { events.wake(); });
+    loader.start(egl, tasks);
   }
-  GLuint program = shader_program.program();
+  GlES2State &gl = GlES2State::current();
 
-  GlES2ShaderProgram texture_shader_program;
-  if (!texture_shader_program.initialize(texture_vshader, texture_fshader)) {
-    return;
+  // while loading, frames follow the loader (and a slow placeholder clock)
+  events.setAnimating(!config.on_demand && loaded == kTaskCount);
+  if (loaded < kTaskCount)
+    events.markDirty();
+
+  FramePipelineConfig pipeline_config = config.pipeline;
+  pipeline_config.width = DemoScene::kFrameWidth;
+  pipeline_config.height = DemoScene::kFrameHeight;
+  pipeline_config.bytes_per_pixel = 4;
+
+  std::unique_ptr<FramePipeline> pipeline;
+  if (pipeline_config.producers > 0) {
+    pipeline = std::make_unique<FramePipeline>(pipeline_config,
+                                               &DemoScene::fillFrame);
+    if (config.on_demand)
+      pipeline->setReadyCallback([&events] { events.wake(); });
+    if (!pipeline->start())
+      return;
+  }
+
+  std::unique_ptr<FrameCapture> capture;
+  if (!config.capture.path.empty()) {
+    FrameCaptureConfig capture_config = config.capture;
+    capture_config.fps = config.scheduler.fps;
+    capture = std::make_unique<FrameCapture>(capture_config);
+    if (!capture->start(surface_width, surface_height))
+      return;
+  }
+
+  // the scene is recorded one frame ahead on its own thread
+  std::unique_ptr<FrameRecorder> recorder;
+  if (config.command_buffers) {
+    recorder = std::make_unique<FrameRecorder>(
+        [&scene](GlES2CommandBuffer *commands, double time) {
+          scene.record(commands, time, true);
+        });
   }
-  GLuint texture_program = texture_shader_program.program();
-
-  const GLfloat vertices[] = {0.0f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f};
-  GLint gvPositionHandle = glGetAttribLocation(program, "vPosition");
-  glEnableVertexAttribArray(gvPositionHandle);
-  GLint gmRotationHandle = glGetUniformLocation(program, "mRotation");
-
-  GLint a_position_handle = glGetAttribLocation(texture_program, "a_position");
-  glEnableVertexAttribArray(a_position_handle);
-  GLint a_uv_handle = glGetAttribLocation(texture_program, "a_uv");
-  glEnableVertexAttribArray(a_uv_handle);
-  GLint u_texture_handle = glGetUniformLocation(texture_program, "u_texture");
-
-  std::vector<unsigned char> image_buffer(256 * 256 * 4);
-  std::fill(image_buffer.begin(), image_buffer.end(), 0x80);
-  for (int y = 0; y < 16; ++y) {
-    for (int x = 0; x < 64; ++x) {
-      int p = y * 256 * 4 + x * 4;
-      image_buffer[p] = 0xff;
-      image_buffer[p + 1] = 0;
-      image_buffer[p + 2] = 0;
+  bool recording = false;
+  uint64_t replayed = 0, packets = 0;
+  int64_t sort_ns = 0, replay_ns = 0;
+  GlES2CommandBuffer::Stats command_totals;
+
+  FrameSchedulerConfig scheduler_config = config.scheduler;
+  // frames follow events, not a clock
+  if (config.on_demand)
+    scheduler_config.mode = FrameMode::kUnlimited;
+  FrameScheduler scheduler(scheduler_config);
+  scheduler.start(display);
+  GlES2State::Counters gl_totals;
+  int64_t deadline_ns = 0;
+  int64_t hud_status_ns = 0, hud_ns = 0;
+  uint64_t hud_frames = 0, hud_drawn = 0;
+  int64_t first_frame_ns = 0, complete_frame_ns = 0;
+  // on demand, a wait is only bounded by the time limit
+  while (events.wait(config.on_demand && loaded == kTaskCount
+                         ? scheduler.limitDeadline()
+                         : deadline_ns) &&
+         scheduler.beginFrame()) {
+    if (loaded < kTaskCount) {
+      const int was_loaded = loaded;
+      loaded = loader.ready();
+      if (loader.failed())
+        break;
+      if (was_loaded <= kSceneTask && loaded > kSceneTask)
+        scene.resize(width, height);
+      if (was_loaded <= kQuadTextureTask && loaded > kQuadTextureTask &&
+          !config.texture.empty())
+        printTextureInfo(texture_info);
+      if (was_loaded <= kMeshTask && loaded > kMeshTask &&
+          !config.mesh.empty())
+        printMeshInfo(mesh_info);
+      if (loaded == kTaskCount)
+        events.setAnimating(!config.on_demand);
+    }
+    if (events.takeResize(&width, &height) && loaded > kSceneTask) {
+      // not while the recorder reads the scene
+      if (recording)
+        recorder->finish();
+      scene.resize(width, height);
+    }
+    const double time = config.on_demand ? 0 : scheduler.animationTime();
+    gl.resetCounters();
+    const int64_t frame_begin_ns = Trace::enabled() ? monotonicNowNs() : 0;
+
+    if (loaded <= kSceneTask) {
+      drawPlaceholder(loaded, width, height);
+    } else {
+      scene.clear();
+      if (pipeline) {
+        TRACE_SCOPE("upload");
+        if (const PipelineFrame *frame = pipeline->acquire()) {
+          scene.texture().update(frame->data);
+          pipeline->release();
+        }
+      }
+      if (recorder && loaded == kTaskCount) {
+        if (!recording) {
+          recorder->start();
+          recorder->begin(time);
+          recording = true;
+        }
+        GlES2CommandBuffer *commands = recorder->finish();
+        // the next frame, recorded while this one is replayed, at the time
+        // it is meant to be shown
+        recorder->begin(config.on_demand ? 0 : scheduler.nextAnimationTime());
+        const int64_t sort_begin = monotonicNowNs();
+        commands->sort();
+        const int64_t replay_begin = monotonicNowNs();
+        commands->replay();
+        replay_ns += monotonicNowNs() - replay_begin;
+        sort_ns += replay_begin - sort_begin;
+        ++replayed;
+        packets += commands->packets();
+        const GlES2CommandBuffer::Stats &stats = commands->stats();
+        command_totals.program_switches += stats.program_switches;
+        command_totals.texture_switches += stats.texture_switches;
+        commands->resetStats();
+      } else {
+        // the quad waits for its texture
+        if (loaded > kQuadTextureTask)
+          scene.drawQuad();
+        scene.drawTriangle(time);
+        scene.drawEntities(time);
+        scene.drawMesh(time);
+      }
     }
+    if (config.hud && loaded == kTaskCount) {
+      const int64_t hud_begin = monotonicNowNs();
+      // other frames draw the status laid out last time
+      if (hud_begin - hud_status_ns >= kNsPerSec) {
+        double fps = 0;
+        if (hud_status_ns)
+          fps = (scheduler.frames() - hud_frames) * 1e9 /
+                (hud_begin - hud_status_ns);
+        char status[64];
+        snprintf(status, sizeof(status), "%.1f fps  frame %llu", fps,
+                 static_cast<unsigned long long>(scheduler.frames()));
+        hud.setStatus(status);
+        hud_status_ns = hud_begin;
+        hud_frames = scheduler.frames();
+      }
+      hud.draw(width, height);
+      hud_ns += monotonicNowNs() - hud_begin;
+      ++hud_drawn;
+    }
+
+    if (capture)
+      capture->capture();
+
+    {
+      TRACE_SCOPE("eglSwapBuffers");
+      eglSwapBuffers(display, surface);
+    }
+    FrameArena::current().reset();
+    if (!first_frame_ns)
+      first_frame_ns = monotonicNowNs() - start_ns;
+    if (!complete_frame_ns && loaded == kTaskCount)
+      complete_frame_ns = monotonicNowNs() - start_ns;
+    if (frame_begin_ns)
+      Trace::recordFrame(frame_begin_ns, monotonicNowNs());
+    gl_totals.issued += gl.counters().issued;
+    gl_totals.elided += gl.counters().elided;
+    deadline_ns = scheduler.finishFrame();
+    if (loaded < kTaskCount)
+      deadline_ns =
+          std::max(deadline_ns, monotonicNowNs() + kPlaceholderIntervalNs);
+  }
+
+  const double elapsed = scheduler.elapsed();
+  std::cout << "frames=" << scheduler.frames() << " elapsed=" << elapsed
+            << "s fps=" << (elapsed > 0 ? scheduler.frames() / elapsed : 0)
+            << " skipped=" << scheduler.skipped() << std::endl;
+  std::cout << "startup: first_frame_ms=" << first_frame_ns / 1e6
+            << " complete_frame_ms=";
+  if (complete_frame_ns)
+    std::cout << complete_frame_ns / 1e6;
+  else
+    std::cout << "none";
+  if (config.sync_load) {
+    std::cout << " loader=none";
+  } else if (loaded == kTaskCount) {
+    const ResourceLoader::Stats &load_stats = loader.stats();
+    std::cout << " loader=" << (load_stats.fence_sync ? "fence" : "glFinish")
+              << " context_ms=" << load_stats.context_ns / 1e6
+              << " tasks_ms=" << load_stats.tasks_ns / 1e6;
+  }
+  std::cout << std::endl;
+  const EventLoop::Stats &event_stats = events.stats();
+  std::cout << "events: waits=" << event_stats.waits
+            << " window=" << event_stats.window_events
+            << " wakeups=" << event_stats.wakeups
+            << " ticks=" << event_stats.ticks
+            << " blocked_ms=" << event_stats.blocked_ns / 1e6 << std::endl;
+  if (scheduler.frames()) {
+    std::cout << "gl state: issued/frame="
+              << static_cast<double>(gl_totals.issued) / scheduler.frames()
+              << " elided/frame="
+              << static_cast<double>(gl_totals.elided) / scheduler.frames()
+              << std::endl;
+  }
+  const FrameArena::Stats &arena_stats = FrameArena::current().stats();
+  if (arena_stats.frames) {
+    std::cout << "alloc: arena_peak_KiB=" << arena_stats.peak / 1024.0
+              << " mallocs_avoided/frame="
+              << static_cast<double>(arena_stats.total_allocations) /
+                     arena_stats.frames
+              << " overflows=" << arena_stats.total_overflows << std::endl;
   }
 
-  GlES2Texture texture_holder = *GlES2Texture::create(); // unwrap
-  texture_holder.setBuffer(image_buffer.data());
-
-  int degree = 0;
-  while (true) {
-    const GLfloat matrix[] = {static_cast<GLfloat>(cos(degree2radian(degree))),
-                              0.0f,
-                              static_cast<GLfloat>(sin(degree2radian(degree))),
-                              0.0f,
-                              0.0f,
-                              1.0f,
-                              0.0f,
-                              0.0f,
-                              static_cast<GLfloat>(-sin(degree2radian(degree))),
-                              0.0f,
-                              static_cast<GLfloat>(cos(degree2radian(degree))),
-                              0.0f,
-                              0.0f,
-                              0.0f,
-                              0.0f,
-                              1.0f};
-
-    glClearColor(0.25f, 0.25f, 0.5f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    const GLfloat aa_position[] = {
-        -0.75f, 0.75f,  //
-        -0.75f, -0.75f, //
-        0.75f,  0.75f,  //
-        0.75f,  -0.75f, //
+  if (recording) {
+    recorder->stop();
+    const FrameRecorder::Stats &stats = recorder->stats();
+    auto per_frame = [](double value, uint64_t frames) {
+      return frames ? value / frames : 0;
     };
-    const GLfloat aa_uv[] = {
-        0.0f, 0.0f, //
-        0.0f, 1.0f, //
-        1.0f, 0.0f, //
-        1.0f, 1.0f, //
+    std::cout << "commands: record_ms="
+              << per_frame(stats.record_ns / 1e6, stats.frames)
+              << " sort_ms=" << per_frame(sort_ns / 1e6, replayed)
+              << " replay_ms=" << per_frame(replay_ns / 1e6, replayed)
+              << " wait_ms=" << per_frame(stats.wait_ns / 1e6, replayed)
+              << " packets/frame=" << per_frame(packets, replayed)
+              << " program_switches/frame="
+              << per_frame(command_totals.program_switches, replayed)
+              << " texture_switches/frame="
+              << per_frame(command_totals.texture_switches, replayed)
+              << std::endl;
+  }
+
+  if (config.entities > 0 && scheduler.frames()) {
+    const GlES2MeshRenderer::Stats &stats = scene.entityStats();
+    std::cout << "entities: " << config.entities << " draws/frame="
+              << static_cast<double>(stats.draw_calls) / scheduler.frames()
+              << std::endl;
+    const DemoScene::CullTotals &cull = scene.cullTotals();
+    if (cull.frames) {
+      const EntityBvh::Stats &bvh = scene.bvhStats();
+      const double frames = cull.frames;
+      std::cout << "culling: visible/frame=" << cull.visible / frames
+                << " culled/frame=" << cull.culled / frames
+                << " update_ms/frame=" << cull.update_ns / 1e6 / frames
+                << " cull_ms/frame=" << cull.cull_ns / 1e6 / frames
+                << " builds=" << bvh.builds << " refits=" << bvh.refits
+                << " linear_updates=" << bvh.linear_updates
+                << " nodes=" << bvh.nodes << std::endl;
+    }
+  }
+
+  if (hud_drawn) {
+    const GlES2TextRenderer::Stats &text = hud.textStats();
+    const GlES2GlyphCache::Stats &glyphs = hud.glyphStats();
+    std::cout << "text: hud_us/frame=" << hud_ns / 1e3 / hud_drawn
+              << " runs_built=" << text.runs_built
+              << " glyphs_laid_out=" << text.glyphs_laid_out
+              << " draws/frame="
+              << static_cast<double>(text.draw_calls) / hud_drawn
+              << " rasterized=" << glyphs.rasterized
+              << " uploads=" << glyphs.uploads << std::endl;
+  }
+
+  if (capture) {
+    capture->stop();
+    const FrameCapture::Stats stats = capture->stats();
+    const double seconds = stats.elapsed_ns / 1e9;
+    auto per_frame_ms = [](int64_t ns, uint64_t frames) {
+      return frames ? ns / 1e6 / frames : 0;
     };
+    std::cout << "capture: written=" << stats.written
+              << " dropped=" << stats.dropped << " fps="
+              << (seconds > 0 ? stats.written / seconds : 0)
+              << " MB/s=" << (seconds > 0 ? stats.bytes / 1e6 / seconds : 0)
+              << " readback_ms="
+              << per_frame_ms(stats.readback_ns, stats.captured)
+              << " convert_ms=" << per_frame_ms(stats.convert_ns, stats.written)
+              << " write_ms=" << per_frame_ms(stats.write_ns, stats.written)
+              << std::endl;
+  }
 
-    glUseProgram(texture_program);
-    glUniform1i(u_texture_handle, 0);
-    glVertexAttribPointer(a_position_handle, 2, GL_FLOAT, GL_FALSE, 0,
-                          aa_position);
-    glVertexAttribPointer(a_uv_handle, 2, GL_FLOAT, GL_FALSE, 0, aa_uv);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-    glUseProgram(program);
-    glVertexAttribPointer(gvPositionHandle, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glUniformMatrix4fv(gmRotationHandle, 1, GL_FALSE, matrix);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-
-    eglSwapBuffers(display, surface);
-    degree = (degree + 1) % 360;
-    usleep(16600);
+  if (pipeline) {
+    pipeline->stop();
+    const FramePipeline::Stats stats = pipeline->stats();
+    std::cout << "pipeline: produced=" << stats.produced
+              << " displayed=" << stats.displayed
+              << " dropped=" << stats.dropped
+              << " producer_stalls=" << stats.producer_stalls
+              << " queue_depth_avg="
+              << (stats.depth_samples
+                      ? static_cast<double>(stats.depth_sum) /
+                            stats.depth_samples
+                      : 0)
+              << " queue_depth_max=" << stats.max_depth << std::endl;
   }
 }
 
@@ -1,11 +1,48 @@
 #ifndef EGL_SRC_APP_APP_H_
 #define EGL_SRC_APP_APP_H_
 
-#include <EGL/egl.h>
+#include <string>
+
+#include "app/frame_capture.h"
+#include "app/frame_pipeline.h"
+#include "app/frame_scheduler.h"
+#include "egl/aegl.h"
+#include "window/awindow.h"
 
 namespace App {
 
-void mainloop(EGLDisplay display, EGLSurface surface);
-}
+struct Config {
+  FrameSchedulerConfig scheduler;
+  // producers = 0 generates one still frame on the render thread
+  FramePipelineConfig pipeline;
+  // program binaries are kept here across runs when not empty
+  std::string shader_cache_dir;
+  // the cubes of webgl sample2, drawn over the rest when not 0
+  int entities = 0;
+  // frustum-cull the cubes through a BVH, on |cull_threads| threads
+  bool cull = false;
+  int cull_threads = 1;
+  // records the rendered frames when |capture.path| is set
+  FrameCaptureConfig capture;
+  // .ktx/.pkm ETC1 image shown on the quad instead of the generated frames
+  std::string texture;
+  // .mesh model (mesh-import) drawn turning in front of the rest
+  std::string mesh;
+  // draw only when something changed (window events, pipeline frames)
+  // instead of animating every frame
+  bool on_demand = false;
+  // compile and upload everything before the first frame on the render
+  // thread, instead of on a loader thread while placeholders are drawn
+  bool sync_load = false;
+  // record the scene into command buffers on a second thread, one frame
+  // ahead, and sort and replay them on the render thread
+  bool command_buffers = false;
+  // a title and a once a second status line over the scene
+  bool hud = false;
+};
+
+// |egl| is current on the calling thread. |window| is null when headless.
+void mainloop(const AEgl &egl, AWindow *window, const Config &config);
+} // namespace App
 
-#endif // EGL_SRC_APP_APP_H_
\ No newline at end of file
+#endif // EGL_SRC_APP_APP_H_
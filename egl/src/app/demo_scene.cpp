@@ -0,0 +1,304 @@
+// cloned from: https://qiita.com/y-tsutsu/items/1e88212b8532fc693c3c
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <GLES2/gl2.h>
+
+#include "app/demo_scene.h"
+#include "base/clock.h"
+#include "base/trace.h"
+#include "gles2/state.h"
+#include "math/mat4.h"
+
+namespace {
+
+// the quad drawQuad() draws: corners and texture coordinates
+constexpr float kQuadX0 = -0.75f, kQuadY0 = 0.75f;
+constexpr float kQuadX1 = 0.75f, kQuadY1 = -0.75f;
+
+struct QuadVertex {
+  GLfloat x, y, u, v;
+  uint32_t color;
+};
+
+// the triangle turns at the rate the old fixed 16.6ms loop had
+constexpr double kDegreesPerSecond = 60.0;
+
+const char *kTriangleVertexShader = R"(
+        attribute vec4 vPosition;
+        uniform mediump mat4 mRotation;
+        void main() {
+            gl_Position = mRotation * vPosition;
+        }
+    )";
+
+const char *kTriangleFragmentShader = R"(
+        precision mediump float;
+        void main() {
+            gl_FragColor = vec4(0.3, 0.8, 0.3, 1.0);
+        }
+    )";
+
+} // namespace
+
+void DemoScene::fillFrame(PipelineFrame *frame) {
+  unsigned char *image = frame->data;
+  std::fill(image, image + kFrameWidth * kFrameHeight * 4, 0x80);
+  const int top = frame->sequence % (kFrameHeight - 16);
+  for (int y = top; y < top + 16; ++y) {
+    for (int x = 0; x < 64; ++x) {
+      int p = y * kFrameWidth * 4 + x * 4;
+      image[p] = 0xff;
+      image[p + 1] = 0;
+      image[p + 2] = 0;
+    }
+  }
+}
+
+bool DemoScene::initialize(GlES2ProgramCache *cache, int entities, int width,
+                           int height) {
+  triangle_program_ = cache->get(kTriangleVertexShader, kTriangleFragmentShader);
+  if (!triangle_program_)
+    return false;
+  a_position_ = triangle_program_->attribute("vPosition");
+  u_rotation_ = triangle_program_->uniform("mRotation");
+
+  auto texture_program = cache->get(GlES2SpriteBatch::kVertexShader,
+                                    GlES2SpriteBatch::kFragmentShader);
+  if (!texture_program)
+    return false;
+  // the stream buffer is orphaned every frame; keep it small
+  if (!sprite_batch_.initialize(texture_program, 256))
+    return false;
+  quad_program_ = texture_program;
+  quad_a_position_ = quad_program_->attribute("a_position");
+  quad_a_uv_ = quad_program_->attribute("a_uv");
+  quad_a_color_ = quad_program_->attribute("a_color");
+  quad_u_texture_ = quad_program_->uniform("u_texture");
+  const QuadVertex quad[] = {{kQuadX0, kQuadY0, 0, 0, 0xffffffff},
+                             {kQuadX0, kQuadY1, 0, 1, 0xffffffff},
+                             {kQuadX1, kQuadY0, 1, 0, 0xffffffff},
+                             {kQuadX1, kQuadY1, 1, 1, 0xffffffff}};
+  if (!quad_buffer_.initialize(sizeof(quad), quad))
+    return false;
+
+  const GLfloat vertices[] = {0.0f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f};
+  if (!triangle_buffer_.initialize(sizeof(vertices), vertices))
+    return false;
+
+  texture_ = GlES2Texture::create();
+  if (!texture_ || !texture_->allocate(kFrameWidth, kFrameHeight, GL_RGBA))
+    return false;
+
+  entities_ = entities;
+  if (entities_ > 0) {
+    scene_.build(entities_);
+    if (!mesh_renderer_.initialize(cache, scene_.shapes()))
+      return false;
+  }
+  resize(width, height);
+  return true;
+}
+
+void DemoScene::resize(int width, int height) {
+  aspect_ = static_cast<float>(width) / std::max(height, 1);
+  GlES2State::current().viewport(0, 0, width, height);
+}
+
+bool DemoScene::loadMesh(GlES2ProgramCache *cache, const std::string &path,
+                         MeshLoadInfo *info) {
+  mesh_program_ = cache->get(GlES2Mesh::kVertexShader,
+                             GlES2Mesh::kFragmentShader);
+  if (!mesh_program_ || !mesh_.load(path, info))
+    return false;
+  mesh_attributes_.position = mesh_program_->attribute("a_position");
+  mesh_attributes_.normal = mesh_program_->attribute("a_normal");
+  u_mesh_model_ = mesh_program_->uniform("u_model");
+  u_mesh_view_projection_ = mesh_program_->uniform("u_view_projection");
+  u_mesh_position_offset_ = mesh_program_->uniform("u_position_offset");
+  u_mesh_position_scale_ = mesh_program_->uniform("u_position_scale");
+  return true;
+}
+
+bool DemoScene::loadTexture(const std::string &path, Etc1LoadInfo *info) {
+  loaded_texture_ = GlES2Texture::create();
+  if (!loadEtc1Texture(path, &*loaded_texture_, info)) {
+    loaded_texture_.reset();
+    return false;
+  }
+  quad_texture_ = loaded_texture_->texture();
+  return true;
+}
+
+void DemoScene::clear() {
+  TRACE_SCOPE("clear");
+  GlES2State::current().clearColor(0.25f, 0.25f, 0.5f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DemoScene::drawQuad() {
+  TRACE_SCOPE("texture pass");
+  sprite_batch_.begin();
+  sprite_batch_.draw({kQuadX0, kQuadY0, kQuadX1, kQuadY1, 0.0f, 0.0f, 1.0f,
+                      1.0f, 0xffffffff,
+                      quad_texture_ ? quad_texture_ : texture_->texture()});
+  sprite_batch_.end();
+}
+
+Math::Mat4 DemoScene::triangleRotation(double time_sec) const {
+  const double degree = fmod(time_sec * kDegreesPerSecond, 360.0);
+  // negated: the triangle has always turned clockwise seen from +y
+  return Math::Mat4::rotationY(-Math::radians(static_cast<float>(degree)));
+}
+
+void DemoScene::drawTriangle(double time_sec) {
+  TRACE_SCOPE("triangle pass");
+  const Math::Mat4 rotation = triangleRotation(time_sec);
+
+  GlES2State &gl = GlES2State::current();
+  gl.useProgram(triangle_program_->program());
+  triangle_buffer_.bind();
+  gl.enableVertexAttribArray(a_position_);
+  gl.vertexAttribPointer(a_position_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  gl.uniformMatrix4fv(u_rotation_, rotation.data());
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void DemoScene::setCulling(bool enabled, int threads) {
+  culling_ = enabled;
+  bvh_.setThreads(threads);
+}
+
+const uint8_t *DemoScene::cullEntities(const float view_projection[16]) {
+  if (!culling_)
+    return nullptr;
+  // sorted first: the visibility is per slot
+  EntityList *entities = scene_.entities();
+  entities->sort();
+  const int64_t begin = monotonicNowNs();
+  bvh_.update(entities, scene_.shapes());
+  cull_totals_.update_ns += monotonicNowNs() - begin;
+  EntityBvh::CullStats stats;
+  bvh_.cull(Math::Frustum::fromViewProjection(view_projection), *entities,
+            &visible_, &stats);
+  ++cull_totals_.frames;
+  cull_totals_.visible += stats.visible;
+  cull_totals_.culled += stats.culled;
+  cull_totals_.cull_ns += stats.ns;
+  return visible_.data();
+}
+
+void DemoScene::drawEntities(double time_sec) {
+  if (entities_ == 0)
+    return;
+  TRACE_SCOPE("entity pass");
+  float view_projection[16];
+  scene_.animate(time_sec);
+  scene_.viewProjection(time_sec, aspect_, view_projection);
+  mesh_renderer_.draw(view_projection, scene_.entities(),
+                      cullEntities(view_projection));
+}
+
+Math::Mat4 DemoScene::meshModel(double time_sec) const {
+  const GLfloat *offset = mesh_.positionOffset();
+  const GLfloat *scale = mesh_.positionScale();
+  const float size = std::max({scale[0], scale[1], scale[2], 1e-6f});
+  const Math::Vec3 center(offset[0] + scale[0] / 2, offset[1] + scale[1] / 2,
+                          offset[2] + scale[2] / 2);
+  const double degree = fmod(time_sec * kDegreesPerSecond / 2, 360.0);
+  return Math::Mat4::rotationY(Math::radians(static_cast<float>(degree))) *
+         Math::Mat4::scale(Math::Vec3(1, 1, 1) * (1.2f / size)) *
+         Math::Mat4::translation(center * -1.0f);
+}
+
+Math::Mat4 DemoScene::meshViewProjection() const {
+  return Math::Mat4::perspective(Math::radians(45), aspect_, 0.1f, 10.0f) *
+         Math::Mat4::translation(Math::Vec3(0, 0, -3));
+}
+
+void DemoScene::drawMesh(double time_sec) {
+  if (!mesh_.loaded())
+    return;
+  TRACE_SCOPE("mesh pass");
+  GlES2State &gl = GlES2State::current();
+  gl.setEnabled(GL_DEPTH_TEST, true);
+  gl.depthFunc(GL_LEQUAL);
+  gl.useProgram(mesh_program_->program());
+  gl.uniformMatrix4fv(u_mesh_model_, meshModel(time_sec).data());
+  gl.uniformMatrix4fv(u_mesh_view_projection_, meshViewProjection().data());
+  glUniform4fv(u_mesh_position_offset_, 1, mesh_.positionOffset());
+  glUniform4fv(u_mesh_position_scale_, 1, mesh_.positionScale());
+  mesh_.draw(mesh_attributes_);
+  gl.setEnabled(GL_DEPTH_TEST, false);
+}
+
+void DemoScene::record(GlES2CommandBuffer *commands, double time_sec,
+                       bool quad) {
+  TRACE_SCOPE("DemoScene::record");
+  if (quad) {
+    const GLuint texture = quad_texture_ ? quad_texture_ : texture_->texture();
+    const GLuint program = quad_program_->program();
+    commands->setEnabled(GL_DEPTH_TEST, false);
+    commands->useProgram(program);
+    commands->uniform1i(quad_u_texture_, 0);
+    commands->bindTexture(0, texture);
+    commands->bindBuffer(GL_ARRAY_BUFFER, quad_buffer_.buffer());
+    commands->enableVertexAttribArray(quad_a_position_);
+    commands->enableVertexAttribArray(quad_a_uv_);
+    commands->enableVertexAttribArray(quad_a_color_);
+    commands->vertexAttribPointer(quad_a_position_, 2, GL_FLOAT, GL_FALSE,
+                                  sizeof(QuadVertex), offsetof(QuadVertex, x));
+    commands->vertexAttribPointer(quad_a_uv_, 2, GL_FLOAT, GL_FALSE,
+                                  sizeof(QuadVertex), offsetof(QuadVertex, u));
+    commands->vertexAttribPointer(quad_a_color_, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                                  sizeof(QuadVertex),
+                                  offsetof(QuadVertex, color));
+    commands->drawArrays(
+        GlES2CommandBuffer::sortKey(kQuadLayer, program, texture, 0),
+        GL_TRIANGLE_STRIP, 0, 4);
+  }
+
+  const GLuint program = triangle_program_->program();
+  commands->setEnabled(GL_DEPTH_TEST, false);
+  commands->useProgram(program);
+  commands->bindBuffer(GL_ARRAY_BUFFER, triangle_buffer_.buffer());
+  commands->enableVertexAttribArray(a_position_);
+  commands->vertexAttribPointer(a_position_, 2, GL_FLOAT, GL_FALSE, 0, 0);
+  commands->uniformMatrix4fv(u_rotation_, triangleRotation(time_sec).data());
+  commands->drawArrays(
+      GlES2CommandBuffer::sortKey(kTriangleLayer, program, 0, 0),
+      GL_TRIANGLES, 0, 3);
+
+  if (entities_ > 0) {
+    float view_projection[16];
+    scene_.animate(time_sec);
+    scene_.viewProjection(time_sec, aspect_, view_projection);
+    mesh_renderer_.record(commands, kEntityLayer, view_projection,
+                          scene_.entities(), cullEntities(view_projection));
+  }
+
+  if (!mesh_.loaded())
+    return;
+  const GLuint mesh_program = mesh_program_->program();
+  const Math::Mat4 model = meshModel(time_sec);
+  const Math::Mat4 mesh_view_projection = meshViewProjection();
+  for (size_t c = 0; c < mesh_.chunks(); ++c) {
+    commands->setEnabled(GL_DEPTH_TEST, true);
+    commands->depthFunc(GL_LEQUAL);
+    commands->useProgram(mesh_program);
+    commands->uniformMatrix4fv(u_mesh_model_, model.data());
+    commands->uniformMatrix4fv(u_mesh_view_projection_,
+                               mesh_view_projection.data());
+    std::copy_n(mesh_.positionOffset(), 4,
+                commands->uniform4fv(u_mesh_position_offset_, 1));
+    std::copy_n(mesh_.positionScale(), 4,
+                commands->uniform4fv(u_mesh_position_scale_, 1));
+    mesh_.recordChunk(commands, c,
+                      GlES2CommandBuffer::sortKey(kMeshLayer, mesh_program,
+                                                  0, 0),
+                      mesh_attributes_);
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef EGL_SRC_APP_DEMO_SCENE_H_
+#define EGL_SRC_APP_DEMO_SCENE_H_
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "app/frame_pipeline.h"
+#include "gles2/buffer.h"
+#include "gles2/command_buffer.h"
+#include "gles2/mesh.h"
+#include "gles2/mesh_renderer.h"
+#include "gles2/program_cache.h"
+#include "gles2/shader.h"
+#include "gles2/sprite_batch.h"
+#include "gles2/texture.h"
+#include "gles2/texture_loader.h"
+#include "math/mat4.h"
+#include "scene/entity_bvh.h"
+#include "scene/sample_scene.h"
+
+// The passes App::mainloop draws every frame: a textured quad, the rotating
+// triangle and optionally the sample2 cubes and a loaded mesh. Kept apart
+// from the loop so that the regression run renders exactly the same frames.
+class DemoScene {
+public:
+  static constexpr int kFrameWidth = 256;
+  static constexpr int kFrameHeight = 256;
+
+  // gray with a red bar that moves down one row per frame
+  static void fillFrame(PipelineFrame *frame);
+
+  // |entities| 0 leaves the cubes out
+  bool initialize(GlES2ProgramCache *cache, int entities, int width,
+                  int height);
+
+  // kFrameWidth x kFrameHeight RGBA, shown by drawQuad()
+  GlES2Texture &texture() { return *texture_; }
+  // shows the ETC1 file at |path| on the quad from now on
+  bool loadTexture(const std::string &path, Etc1LoadInfo *info);
+  // the .mesh model at |path|, turning in front of the rest from now on
+  bool loadMesh(GlES2ProgramCache *cache, const std::string &path,
+                MeshLoadInfo *info);
+  // shows |texture|, owned elsewhere in the share group, on the quad
+  void shareTexture(GLuint texture) { quad_texture_ = texture; }
+
+  // viewport and projection for a |width| x |height| surface
+  void resize(int width, int height);
+
+  void clear();
+  void drawQuad();
+  void drawTriangle(double time_sec);
+  void drawEntities(double time_sec);
+  // nothing until loadMesh()
+  void drawMesh(double time_sec);
+  // the passes as packets, the quad only with |quad|. Makes no GL
+  // calls: it may run on another thread than the context's, as long as
+  // nothing else draws the scene meanwhile.
+  void record(GlES2CommandBuffer *commands, double time_sec, bool quad);
+
+  struct CullTotals {
+    uint64_t frames = 0;
+    uint64_t visible = 0;
+    uint64_t culled = 0;
+    int64_t update_ns = 0; // EntityBvh::update()
+    int64_t cull_ns = 0;
+  };
+
+  // draws only the cubes whose bounds reach into the view, as an
+  // EntityBvh culled on |threads| finds them
+  void setCulling(bool enabled, int threads);
+
+  int entities() const { return entities_; }
+  const GlES2MeshRenderer::Stats &entityStats() const {
+    return mesh_renderer_.stats();
+  }
+  const CullTotals &cullTotals() const { return cull_totals_; }
+  const EntityBvh::Stats &bvhStats() const { return bvh_.stats(); }
+
+private:
+  // record() draws the passes in this order; only the cubes test depth
+  enum Layer { kQuadLayer, kTriangleLayer, kEntityLayer, kMeshLayer };
+
+  Math::Mat4 triangleRotation(double time_sec) const;
+  // fits the mesh's bounds into a unit sphere at the origin and turns it
+  Math::Mat4 meshModel(double time_sec) const;
+  Math::Mat4 meshViewProjection() const;
+  // the per-slot visibility of the animated cubes, or null without culling
+  const uint8_t *cullEntities(const float view_projection[16]);
+
+  std::shared_ptr<GlES2ShaderProgram> triangle_program_;
+  GLint a_position_ = -1;
+  GLint u_rotation_ = -1;
+  GlES2Buffer triangle_buffer_;
+  GlES2SpriteBatch sprite_batch_;
+  // the quad as a static strip for record(), in the sprite batch's layout
+  std::shared_ptr<GlES2ShaderProgram> quad_program_;
+  GLint quad_a_position_ = -1;
+  GLint quad_a_uv_ = -1;
+  GLint quad_a_color_ = -1;
+  GLint quad_u_texture_ = -1;
+  GlES2Buffer quad_buffer_;
+  std::optional<GlES2Texture> texture_;
+  std::optional<GlES2Texture> loaded_texture_;
+  // 0: |texture_|
+  GLuint quad_texture_ = 0;
+  int entities_ = 0;
+  float aspect_ = 1;
+  SampleScene scene_;
+  GlES2MeshRenderer mesh_renderer_;
+  bool culling_ = false;
+  EntityBvh bvh_;
+  std::vector<uint8_t> visible_;
+  CullTotals cull_totals_;
+  std::shared_ptr<GlES2ShaderProgram> mesh_program_;
+  GlES2Mesh::Attributes mesh_attributes_;
+  GLint u_mesh_model_ = -1;
+  GLint u_mesh_view_projection_ = -1;
+  GLint u_mesh_position_offset_ = -1;
+  GLint u_mesh_position_scale_ = -1;
+  GlES2Mesh mesh_;
+};
+
+#endif // EGL_SRC_APP_DEMO_SCENE_H_
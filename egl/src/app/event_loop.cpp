@@ -0,0 +1,116 @@
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "app/event_loop.h"
+#include "base/clock.h"
+#include "base/logging.h"
+#include "base/trace.h"
+
+EventLoop::~EventLoop() {
+  if (timer_fd_ >= 0)
+    close(timer_fd_);
+  if (wake_fd_ >= 0)
+    close(wake_fd_);
+}
+
+bool EventLoop::initialize(AWindow *window) {
+  window_ = window;
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (timer_fd_ < 0 || wake_fd_ < 0) {
+    LOG_E << "timerfd/eventfd: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void EventLoop::wake() {
+  const uint64_t one = 1;
+  // only fails when the counter would overflow, i.e. a wakeup is pending
+  (void)!write(wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::armTimer(int64_t deadline_ns) {
+  itimerspec spec = {};
+  // all zero disarms
+  spec.it_value.tv_sec = deadline_ns / kNsPerSec;
+  spec.it_value.tv_nsec = deadline_ns % kNsPerSec;
+  timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::handleWindowEvents() {
+  if (!window_)
+    return;
+  WindowEvent event;
+  while (window_->pollEvent(&event)) {
+    ++stats_.window_events;
+    switch (event.type) {
+    case WindowEvent::Type::kExpose:
+      dirty_ = true;
+      break;
+    case WindowEvent::Type::kResize:
+      width_ = event.width;
+      height_ = event.height;
+      resized_ = true;
+      dirty_ = true;
+      break;
+    case WindowEvent::Type::kClose:
+      closed_ = true;
+      break;
+    }
+  }
+}
+
+bool EventLoop::wait(int64_t deadline_ns) {
+  TRACE_SCOPE("EventLoop::wait");
+  ++stats_.waits;
+  armTimer(deadline_ns);
+  const int window_fd = window_ ? window_->eventFd() : -1;
+  const int64_t begin = monotonicNowNs();
+  for (;;) {
+    handleWindowEvents();
+    if (closed_)
+      break;
+    // animating loops wait for the deadline only; the others for a change
+    // (or the deadline as a bound)
+    if (animating_ ? deadline_ns == 0 : dirty_)
+      break;
+
+    pollfd fds[3] = {{timer_fd_, POLLIN, 0},
+                     {wake_fd_, POLLIN, 0},
+                     {window_fd, POLLIN, 0}};
+    if (poll(fds, window_fd >= 0 ? 3 : 2, -1) < 0 && errno != EINTR) {
+      LOG_E << "poll: " << strerror(errno);
+      break;
+    }
+    uint64_t count;
+    if (fds[1].revents & POLLIN &&
+        read(wake_fd_, &count, sizeof(count)) > 0) {
+      stats_.wakeups += count;
+      dirty_ = true;
+    }
+    if (fds[0].revents & POLLIN &&
+        read(timer_fd_, &count, sizeof(count)) > 0) {
+      ++stats_.ticks;
+      break;
+    }
+  }
+  armTimer(0);
+  stats_.blocked_ns += monotonicNowNs() - begin;
+  dirty_ = false;
+  return !closed_;
+}
+
+bool EventLoop::takeResize(int *width, int *height) {
+  if (!resized_)
+    return false;
+  resized_ = false;
+  *width = width_;
+  *height = height_;
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef EGL_SRC_APP_EVENT_LOOP_H_
+#define EGL_SRC_APP_EVENT_LOOP_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "window/awindow.h"
+
+// Blocks the render thread in one poll() on the window's connection, a
+// timerfd for the next frame deadline and an eventfd that other threads
+// signal with wake(). Window events are handled while waiting, so a paced
+// loop stays responsive, and a loop with nothing to draw sleeps until
+// something changes.
+class EventLoop {
+public:
+  struct Stats {
+    uint64_t waits = 0;
+    uint64_t window_events = 0;
+    uint64_t wakeups = 0; // wake() calls seen
+    uint64_t ticks = 0;   // deadlines reached
+    int64_t blocked_ns = 0;
+  };
+
+  EventLoop() = default;
+  ~EventLoop();
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  // |window| may be null (headless)
+  bool initialize(AWindow *window);
+
+  // any thread
+  void wake();
+  // the next wait returns at once
+  void markDirty() { dirty_ = true; }
+  // animating loops draw at every deadline; otherwise only when dirty
+  void setAnimating(bool animating) { animating_ = animating; }
+
+  // handles window events and waits until |deadline_ns| (monotonic; 0 for
+  // none) or, when not animating, until something marks the loop dirty.
+  // False once the window has been closed.
+  bool wait(int64_t deadline_ns);
+
+  // the size from the last resize, once
+  bool takeResize(int *width, int *height);
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  void handleWindowEvents();
+  void armTimer(int64_t deadline_ns);
+
+  AWindow *window_ = nullptr;
+  int timer_fd_ = -1;
+  int wake_fd_ = -1;
+  bool animating_ = true;
+  bool dirty_ = true;
+  bool closed_ = false;
+  bool resized_ = false;
+  int width_ = 0;
+  int height_ = 0;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_APP_EVENT_LOOP_H_
@@ -0,0 +1,182 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <GLES2/gl2.h>
+
+#include "app/frame_capture.h"
+#include "app/yuv.h"
+#include "base/clock.h"
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/state.h"
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+const char kFrameHeader[] = "FRAME\n";
+
+// all of |iov|, resuming after short writes
+bool writeAll(int fd, iovec *iov, int count) {
+  while (count > 0) {
+    ssize_t n = writev(fd, iov, count);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    while (count > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+      n -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(const FrameCaptureConfig &config)
+    : config_(config), ready_(config.buffers), free_(config.buffers) {}
+
+FrameCapture::~FrameCapture() { stop(); }
+
+bool FrameCapture::start(int width, int height) {
+  width_ = width;
+  height_ = height;
+  fd_ = open(config_.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    LOG_E << "cannot open " << config_.path << ": " << strerror(errno);
+    return false;
+  }
+  if (config_.format == CaptureFormat::kY4m) {
+    char header[128];
+    const int length =
+        snprintf(header, sizeof(header),
+                 "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n", width,
+                 height, static_cast<int>(config_.fps * 1000 + 0.5));
+    iovec iov = {header, static_cast<size_t>(length)};
+    if (!writeAll(fd_, &iov, 1)) {
+      LOG_E << "cannot write " << config_.path << ": " << strerror(errno);
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+  }
+
+  // RGBA read back, then the I420 planes of the same frame behind it
+  const size_t rgba_bytes = static_cast<size_t>(width) * height * 4;
+  const size_t yuv_bytes = static_cast<size_t>(width) * height +
+                           2 * static_cast<size_t>((width + 1) / 2) *
+                               ((height + 1) / 2);
+  frame_bytes_ = rgba_bytes + yuv_bytes;
+  const size_t alloc_bytes =
+      (frame_bytes_ + kPageSize - 1) / kPageSize * kPageSize;
+  for (int b = 0; b < config_.buffers; ++b) {
+    buffers_.emplace_back(
+        static_cast<unsigned char *>(aligned_alloc(kPageSize, alloc_bytes)),
+        &free);
+    free_.push(buffers_.back().get());
+  }
+
+  start_ns_ = monotonicNowNs();
+  running_ = true;
+  thread_ = std::thread(&FrameCapture::write, this);
+  return true;
+}
+
+void FrameCapture::capture() {
+  if (!running_)
+    return;
+  unsigned char *buffer = nullptr;
+  if (!free_.pop(&buffer)) {
+    ++render_stats_.dropped;
+    return;
+  }
+  TRACE_SCOPE("capture readback");
+  const int64_t begin = monotonicNowNs();
+  GlES2State::current().pixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, buffer);
+  render_stats_.readback_ns += monotonicNowNs() - begin;
+  ++render_stats_.captured;
+  // cannot fail: the queue holds every buffer
+  ready_.push(buffer);
+}
+
+void FrameCapture::write() {
+  const size_t luma = static_cast<size_t>(width_) * height_;
+  const size_t chroma =
+      static_cast<size_t>((width_ + 1) / 2) * ((height_ + 1) / 2);
+  const size_t rgba_bytes = luma * 4;
+  bool failed = false;
+  for (;;) {
+    unsigned char *buffer = nullptr;
+    if (!ready_.pop(&buffer)) {
+      if (!running_.load(std::memory_order_acquire) && ready_.size() == 0)
+        break;
+      const timespec wait = {0, 200000};
+      nanosleep(&wait, nullptr);
+      continue;
+    }
+    unsigned char *y = buffer + rgba_bytes;
+    unsigned char *u = y + luma;
+    unsigned char *v = u + chroma;
+    const int64_t begin = monotonicNowNs();
+    {
+      TRACE_SCOPE("capture convert");
+      rgbaToI420(buffer, width_, height_, width_ * 4, true, y, u, v);
+    }
+    const int64_t converted = monotonicNowNs();
+
+    iovec iov[4];
+    int count = 0;
+    if (config_.format == CaptureFormat::kY4m)
+      iov[count++] = {const_cast<char *>(kFrameHeader),
+                      sizeof(kFrameHeader) - 1};
+    iov[count++] = {y, luma};
+    iov[count++] = {u, chroma};
+    iov[count++] = {v, chroma};
+    if (!failed) {
+      TRACE_SCOPE("capture write");
+      if (writeAll(fd_, iov, count)) {
+        written_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(luma + 2 * chroma, std::memory_order_relaxed);
+      } else {
+        LOG_E << "capture write failed: " << strerror(errno);
+        failed = true;
+      }
+    }
+    convert_ns_.fetch_add(converted - begin, std::memory_order_relaxed);
+    write_ns_.fetch_add(monotonicNowNs() - converted,
+                        std::memory_order_relaxed);
+    free_.push(buffer);
+  }
+}
+
+void FrameCapture::stop() {
+  if (!thread_.joinable())
+    return;
+  running_.store(false, std::memory_order_release);
+  thread_.join();
+  render_stats_.elapsed_ns = monotonicNowNs() - start_ns_;
+  close(fd_);
+  fd_ = -1;
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+  Stats stats = render_stats_;
+  stats.written = written_.load();
+  stats.bytes = bytes_.load();
+  stats.convert_ns = convert_ns_.load();
+  stats.write_ns = write_ns_.load();
+  return stats;
+}
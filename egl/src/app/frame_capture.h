@@ -0,0 +1,81 @@
+#ifndef EGL_SRC_APP_FRAME_CAPTURE_H_
+#define EGL_SRC_APP_FRAME_CAPTURE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/spsc_queue.h"
+
+enum class CaptureFormat {
+  kY4m,     // YUV4MPEG2 with 4:2:0 frames
+  kRawI420, // bare I420 planes, frame after frame
+};
+
+struct FrameCaptureConfig {
+  // nothing is captured when empty
+  std::string path;
+  CaptureFormat format = CaptureFormat::kY4m;
+  // read-back buffers in flight between the render thread and the writer
+  int buffers = 4;
+  // frame rate written to the Y4M header
+  double fps = 60;
+};
+
+// Reads the back buffer on the render thread and leaves the rest to a
+// writer thread: RGBA -> I420 with the vertical flip, then one writev per
+// frame. Buffers cycle over two SPSC queues; when the writer falls behind
+// and none is free, capture() drops the frame instead of waiting.
+class FrameCapture {
+public:
+  struct Stats {
+    uint64_t captured = 0;
+    uint64_t dropped = 0;
+    uint64_t written = 0;
+    uint64_t bytes = 0;
+    int64_t readback_ns = 0; // render thread, in glReadPixels
+    int64_t convert_ns = 0;  // writer thread
+    int64_t write_ns = 0;    // writer thread
+    int64_t elapsed_ns = 0;  // from start() to stop()
+  };
+
+  explicit FrameCapture(const FrameCaptureConfig &config);
+  ~FrameCapture();
+
+  // opens the output for |width| x |height| frames and starts the writer
+  bool start(int width, int height);
+  // render thread, before eglSwapBuffers
+  void capture();
+  // waits for the queued frames to be written
+  void stop();
+
+  Stats stats() const;
+
+private:
+  void write();
+
+  FrameCaptureConfig config_;
+  int width_ = 0;
+  int height_ = 0;
+  int fd_ = -1;
+  size_t frame_bytes_ = 0;
+  std::vector<std::unique_ptr<unsigned char, void (*)(void *)>> buffers_;
+  SpscQueue<unsigned char *> ready_; // render -> writer
+  SpscQueue<unsigned char *> free_;  // writer -> render
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  int64_t start_ns_ = 0;
+
+  // render thread only
+  Stats render_stats_;
+
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<int64_t> convert_ns_{0};
+  std::atomic<int64_t> write_ns_{0};
+};
+
+#endif // EGL_SRC_APP_FRAME_CAPTURE_H_
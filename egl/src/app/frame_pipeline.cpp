@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdlib>
+
+#include "app/frame_pipeline.h"
+#include "app/frame_scheduler.h"
+#include "base/logging.h"
+#include "base/trace.h"
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+// a producer waiting for a buffer also looks at running_ this often
+constexpr std::chrono::milliseconds kStallWait{100};
+
+} // namespace
+
+FramePipeline::FramePipeline(const FramePipelineConfig &config,
+                             Generator generator)
+    : config_(config), generator_(std::move(generator)),
+      frame_bytes_(static_cast<size_t>(config.width) * config.height *
+                   config.bytes_per_pixel) {
+  for (int p = 0; p < config_.producers; ++p) {
+    channels_.push_back(
+        std::make_unique<Channel>(config_.buffers_per_producer));
+  }
+}
+
+FramePipeline::~FramePipeline() { stop(); }
+
+bool FramePipeline::start() {
+  const size_t alloc_bytes =
+      (frame_bytes_ + kPageSize - 1) / kPageSize * kPageSize;
+  if (buffers_.empty()) {
+    for (int p = 0; p < config_.producers; ++p) {
+      for (int b = 0; b < config_.buffers_per_producer; ++b) {
+        buffers_.emplace_back(static_cast<unsigned char *>(
+                                  aligned_alloc(kPageSize, alloc_bytes)),
+                              &free);
+        if (!buffers_.back()) {
+          LOG_E << "cannot allocate " << alloc_bytes
+                << " bytes for a pipeline frame";
+          return false;
+        }
+        PipelineFrame frame;
+        frame.data = buffers_.back().get();
+        frame.producer = p;
+        channels_[p]->free.push(frame);
+      }
+    }
+  }
+  running_ = true;
+  for (int p = 0; p < config_.producers; ++p)
+    channels_[p]->thread = std::thread(&FramePipeline::produce, this, p);
+  return true;
+}
+
+void FramePipeline::stop() {
+  running_ = false;
+  for (auto &channel : channels_) {
+    {
+      std::lock_guard<std::mutex> lock(channel->mutex);
+      channel->returned.notify_one();
+    }
+    if (channel->thread.joinable())
+      channel->thread.join();
+  }
+}
+
+bool FramePipeline::waitForBuffer(Channel *channel, PipelineFrame *frame) {
+  std::unique_lock<std::mutex> lock(channel->mutex);
+  channel->waiting.store(true, std::memory_order_seq_cst);
+  // pairs with the fence in recycle(): either this pop sees the buffer or
+  // the render thread sees |waiting| and notifies under the lock
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool found = channel->free.pop(frame);
+  if (!found && running_.load(std::memory_order_relaxed)) {
+    channel->returned.wait_for(lock, kStallWait);
+    found = channel->free.pop(frame);
+  }
+  channel->waiting.store(false, std::memory_order_relaxed);
+  return found;
+}
+
+void FramePipeline::produce(int index) {
+  Channel &channel = *channels_[index];
+  FrameSchedulerConfig pacing;
+  pacing.mode = config_.producer_fps > 0 ? FrameMode::kFixedRate
+                                         : FrameMode::kUnlimited;
+  pacing.fps = config_.producer_fps;
+  FrameScheduler scheduler(pacing);
+  scheduler.start(EGL_NO_DISPLAY);
+
+  uint64_t sequence = index;
+  bool stalled = false;
+  while (running_.load(std::memory_order_relaxed)) {
+    PipelineFrame frame;
+    if (!channel.free.pop(&frame)) {
+      // every buffer is queued or on screen
+      if (!stalled)
+        producer_stalls_.fetch_add(1, std::memory_order_relaxed);
+      stalled = true;
+      if (!waitForBuffer(&channel, &frame))
+        continue;
+    }
+    stalled = false;
+    frame.sequence = sequence;
+    {
+      TRACE_SCOPE("produce frame");
+      generator_(&frame);
+    }
+    // cannot fail: the queue holds every buffer of this producer
+    channel.ready.push(frame);
+    produced_.fetch_add(1, std::memory_order_relaxed);
+    if (ready_callback_)
+      ready_callback_();
+    sequence += config_.producers;
+    scheduler.endFrame();
+  }
+}
+
+void FramePipeline::recycle(const PipelineFrame &frame) {
+  Channel &channel = *channels_[frame.producer];
+  channel.free.push(frame);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (channel.waiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(channel.mutex);
+    channel.returned.notify_one();
+  }
+}
+
+const PipelineFrame *FramePipeline::acquire() {
+  uint64_t depth = 0;
+  for (const auto &channel : channels_)
+    depth += channel->ready.size();
+  ++render_stats_.depth_samples;
+  render_stats_.depth_sum += depth;
+  render_stats_.max_depth = std::max(render_stats_.max_depth, depth);
+
+  PipelineFrame next;
+  bool found = false;
+  if (config_.policy == FramePolicy::kBackpressure) {
+    Channel &channel = *channels_[next_sequence_ % channels_.size()];
+    found = channel.ready.pop(&next);
+  } else {
+    PipelineFrame frame;
+    for (auto &channel : channels_) {
+      while (channel->ready.pop(&frame)) {
+        if (!found || frame.sequence > next.sequence) {
+          if (found) {
+            recycle(next);
+            ++render_stats_.dropped;
+          }
+          next = frame;
+          found = true;
+        } else {
+          recycle(frame);
+          ++render_stats_.dropped;
+        }
+      }
+    }
+    // a slow producer's frame that is older than what is on screen
+    if (found && next.sequence < next_sequence_) {
+      recycle(next);
+      ++render_stats_.dropped;
+      found = false;
+    }
+  }
+  if (!found)
+    return nullptr;
+
+  if (holding_)
+    release();
+  current_ = next;
+  holding_ = true;
+  next_sequence_ = current_.sequence + 1;
+  ++render_stats_.displayed;
+  return &current_;
+}
+
+void FramePipeline::release() {
+  if (!holding_)
+    return;
+  recycle(current_);
+  holding_ = false;
+}
+
+FramePipeline::Stats FramePipeline::stats() const {
+  Stats stats = render_stats_;
+  stats.produced = produced_.load();
+  stats.producer_stalls = producer_stalls_.load();
+  return stats;
+}
@@ -0,0 +1,120 @@
+#ifndef EGL_SRC_APP_FRAME_PIPELINE_H_
+#define EGL_SRC_APP_FRAME_PIPELINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/spsc_queue.h"
+
+// what the render thread does when producers are ahead of it
+enum class FramePolicy {
+  kBackpressure, // show every frame in order; producers wait for buffers
+  kDropOldest,   // show the newest ready frame, recycle the older ones
+};
+
+struct FramePipelineConfig {
+  int width = 256;
+  int height = 256;
+  int bytes_per_pixel = 4;
+  int producers = 1;
+  // buffers owned by each producer, in flight or free
+  int buffers_per_producer = 3;
+  FramePolicy policy = FramePolicy::kBackpressure;
+  // producer pacing; 0 produces as fast as buffers come back
+  double producer_fps = 0;
+};
+
+struct PipelineFrame {
+  unsigned char *data = nullptr;
+  uint64_t sequence = 0;
+  int producer = 0;
+};
+
+// Producer threads fill frames into a fixed pool of page-aligned buffers and
+// hand them to the render thread over per-producer SPSC queues. Buffers come
+// back over a second SPSC queue per producer, so nothing is allocated after
+// start(); a producer with no free buffer sleeps until one comes back, and
+// only then does returning it take a lock. Producer k makes frames k,
+// k + N, k + 2N, ...
+class FramePipeline {
+public:
+  // called on a producer thread; fills |frame->data|
+  using Generator = std::function<void(PipelineFrame *frame)>;
+
+  struct Stats {
+    uint64_t produced = 0;
+    uint64_t displayed = 0;
+    uint64_t dropped = 0;
+    uint64_t producer_stalls = 0; // waits for a free buffer
+    uint64_t depth_samples = 0;
+    uint64_t depth_sum = 0;
+    uint64_t max_depth = 0;
+  };
+
+  FramePipeline(const FramePipelineConfig &config, Generator generator);
+  ~FramePipeline();
+
+  // |callback| runs on a producer thread after each frame it queues. Set
+  // it before start().
+  void setReadyCallback(std::function<void()> callback) {
+    ready_callback_ = std::move(callback);
+  }
+
+  // allocates the buffers and starts the producers; false if a buffer
+  // could not be allocated
+  bool start();
+  void stop();
+
+  // render thread. Returns the next frame to upload, or nullptr when none
+  // is ready (keep showing the previous one); never blocks.
+  const PipelineFrame *acquire();
+  // render thread. Gives the last acquired frame back once uploaded.
+  void release();
+
+  Stats stats() const;
+  size_t frameBytes() const { return frame_bytes_; }
+
+private:
+  struct Channel {
+    explicit Channel(size_t capacity) : ready(capacity), free(capacity) {}
+    SpscQueue<PipelineFrame> ready; // producer -> render
+    SpscQueue<PipelineFrame> free;  // render -> producer
+    std::thread thread;
+    // the producer sleeps on |returned| while |waiting| for a free buffer
+    std::mutex mutex;
+    std::condition_variable returned;
+    std::atomic<bool> waiting{false};
+  };
+
+  void produce(int index);
+  // sleeps until the render thread returns a buffer to |channel|, or for
+  // a bounded time so that stop() is noticed; false if none came back
+  bool waitForBuffer(Channel *channel, PipelineFrame *frame);
+  void recycle(const PipelineFrame &frame);
+
+  FramePipelineConfig config_;
+  Generator generator_;
+  std::function<void()> ready_callback_;
+  size_t frame_bytes_;
+  std::vector<std::unique_ptr<unsigned char, void (*)(void *)>> buffers_;
+  std::vector<std::unique_ptr<Channel>> channels_;
+  std::atomic<bool> running_{false};
+
+  // render thread only
+  PipelineFrame current_;
+  bool holding_ = false;
+  uint64_t next_sequence_ = 0;
+  Stats render_stats_;
+
+  std::atomic<uint64_t> produced_{0};
+  std::atomic<uint64_t> producer_stalls_{0};
+};
+
+#endif // EGL_SRC_APP_FRAME_PIPELINE_H_
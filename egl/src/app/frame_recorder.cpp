@@ -0,0 +1,61 @@
+#include "app/frame_recorder.h"
+#include "base/clock.h"
+#include "base/trace.h"
+
+void FrameRecorder::start() {
+  stop_ = false;
+  thread_ = std::thread(&FrameRecorder::run, this);
+}
+
+void FrameRecorder::stop() {
+  if (!thread_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void FrameRecorder::begin(double time_sec) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    time_sec_ = time_sec;
+    ++requested_;
+  }
+  cv_.notify_all();
+}
+
+GlES2CommandBuffer *FrameRecorder::finish() {
+  TRACE_SCOPE("FrameRecorder::finish");
+  const int64_t begin = monotonicNowNs();
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return recorded_ == requested_; });
+  stats_.wait_ns += monotonicNowNs() - begin;
+  return &buffers_[recorded_ % 2];
+}
+
+void FrameRecorder::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    cv_.wait(lock, [this] { return stop_ || requested_ != recorded_; });
+    if (stop_)
+      return;
+    const uint64_t frame = requested_;
+    const double time_sec = time_sec_;
+    lock.unlock();
+
+    const int64_t begin = monotonicNowNs();
+    GlES2CommandBuffer *commands = &buffers_[frame % 2];
+    commands->clear();
+    record_(commands, time_sec);
+    const int64_t record_ns = monotonicNowNs() - begin;
+
+    lock.lock();
+    stats_.record_ns += record_ns;
+    ++stats_.frames;
+    recorded_ = frame;
+    cv_.notify_all();
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef EGL_SRC_APP_FRAME_RECORDER_H_
+#define EGL_SRC_APP_FRAME_RECORDER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "gles2/command_buffer.h"
+
+// Records frames into command buffers on a thread of its own, double
+// buffered: while the render thread sorts and replays one frame, the next
+// is recorded into the other buffer.
+class FrameRecorder {
+public:
+  // fills a cleared |commands|; runs on the recorder thread
+  using Record =
+      std::function<void(GlES2CommandBuffer *commands, double time_sec)>;
+
+  struct Stats {
+    uint64_t frames = 0;
+    int64_t record_ns = 0;
+    // the render thread waiting in finish()
+    int64_t wait_ns = 0;
+  };
+
+  explicit FrameRecorder(Record record) : record_(std::move(record)) {}
+  ~FrameRecorder() { stop(); }
+
+  void start();
+  void stop();
+
+  // records the frame at |time_sec| into the buffer finish() did not
+  // return last. Call finish() before the next begin().
+  void begin(double time_sec);
+  // waits for the frame begun last. Its buffer is the caller's until the
+  // next finish(); calling finish() again only waits.
+  GlES2CommandBuffer *finish();
+
+  // read after stop() or between finish() and begin()
+  const Stats &stats() const { return stats_; }
+
+private:
+  void run();
+
+  Record record_;
+  GlES2CommandBuffer buffers_[2];
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // frames begun and recorded; frame n goes into buffers_[n % 2]
+  uint64_t requested_ = 0;
+  uint64_t recorded_ = 0;
+  double time_sec_ = 0;
+  bool stop_ = false;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_APP_FRAME_RECORDER_H_
@@ -0,0 +1,95 @@
+#include <cerrno>
+#include <ctime>
+
+#include "app/frame_scheduler.h"
+#include "base/clock.h"
+#include "base/logging.h"
+
+FrameScheduler::FrameScheduler(const FrameSchedulerConfig &config)
+    : config_(config) {
+  if (config_.fps > 0)
+    period_ns_ = static_cast<int64_t>(kNsPerSec / config_.fps);
+}
+
+void FrameScheduler::start(EGLDisplay display) {
+  const EGLint interval = config_.mode == FrameMode::kVsync ? 1 : 0;
+  if (display != EGL_NO_DISPLAY && !eglSwapInterval(display, interval)) {
+    LOG_W << "eglSwapInterval(" << interval << ") error=" << eglGetError();
+  }
+  start_ns_ = monotonicNowNs();
+  deadline_ns_ = start_ns_;
+  frames_ = 0;
+  skipped_ = 0;
+}
+
+bool FrameScheduler::beginFrame() {
+  if (config_.max_frames && frames_ >= config_.max_frames)
+    return false;
+  const int64_t now = monotonicNowNs();
+  if (config_.time_limit_sec > 0 &&
+      now - start_ns_ >= static_cast<int64_t>(config_.time_limit_sec *
+                                              kNsPerSec))
+    return false;
+  // a paced frame is shown at its deadline, whenever it actually starts
+  frame_time_ns_ = config_.mode == FrameMode::kFixedRate && period_ns_
+                       ? deadline_ns_ - start_ns_
+                       : now - start_ns_;
+  return true;
+}
+
+void FrameScheduler::endFrame() {
+  const int64_t deadline = finishFrame();
+  if (deadline)
+    sleepUntil(deadline);
+}
+
+int64_t FrameScheduler::finishFrame() {
+  ++frames_;
+  if (config_.mode != FrameMode::kFixedRate || period_ns_ == 0)
+    return 0;
+
+  deadline_ns_ += period_ns_;
+  const int64_t now = monotonicNowNs();
+  if (now < deadline_ns_)
+    return deadline_ns_;
+
+  const int64_t behind = (now - deadline_ns_) / period_ns_;
+  if (config_.late_policy == LatePolicy::kSkip) {
+    skipped_ += behind + 1;
+    deadline_ns_ += (behind + 1) * period_ns_;
+    return deadline_ns_;
+  }
+  if (behind >= config_.max_catch_up) {
+    skipped_ += behind;
+    deadline_ns_ = now;
+  }
+  // start the next frame immediately
+  return 0;
+}
+
+int64_t FrameScheduler::limitDeadline() const {
+  if (config_.time_limit_sec <= 0)
+    return 0;
+  return start_ns_ + static_cast<int64_t>(config_.time_limit_sec * kNsPerSec);
+}
+
+double FrameScheduler::animationTime() const {
+  return static_cast<double>(frame_time_ns_) / kNsPerSec;
+}
+
+double FrameScheduler::nextAnimationTime() const {
+  return static_cast<double>(frame_time_ns_ + period_ns_) / kNsPerSec;
+}
+
+double FrameScheduler::elapsed() const {
+  return static_cast<double>(monotonicNowNs() - start_ns_) / kNsPerSec;
+}
+
+void FrameScheduler::sleepUntil(int64_t deadline_ns) {
+  timespec ts;
+  ts.tv_sec = deadline_ns / kNsPerSec;
+  ts.tv_nsec = deadline_ns % kNsPerSec;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
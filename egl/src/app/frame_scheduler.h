@@ -0,0 +1,68 @@
+#ifndef EGL_SRC_APP_FRAME_SCHEDULER_H_
+#define EGL_SRC_APP_FRAME_SCHEDULER_H_
+
+#include <cstdint>
+
+#include <EGL/egl.h>
+
+enum class FrameMode {
+  kVsync,     // eglSwapInterval(1), the swap paces the loop
+  kFixedRate, // eglSwapInterval(0), sleep to absolute deadlines
+  kUnlimited, // eglSwapInterval(0), no pacing (benchmarking)
+};
+
+// what kFixedRate does when a frame overruns its deadline
+enum class LatePolicy {
+  kSkip,    // drop the missed slots and wait for the next one
+  kCatchUp, // render the missed slots back-to-back until on time again
+};
+
+struct FrameSchedulerConfig {
+  FrameMode mode = FrameMode::kFixedRate;
+  LatePolicy late_policy = LatePolicy::kSkip;
+  double fps = 60.0;
+  // catch-up gives up and re-anchors when this many slots behind
+  int max_catch_up = 4;
+  // 0: unlimited
+  uint64_t max_frames = 0;
+  double time_limit_sec = 0.0;
+};
+
+class FrameScheduler {
+public:
+  explicit FrameScheduler(const FrameSchedulerConfig &config);
+
+  // sets the swap interval (unless EGL_NO_DISPLAY) and anchors the clock
+  void start(EGLDisplay display);
+  // false when the frame or time limit has been reached
+  bool beginFrame();
+  // call after eglSwapBuffers; waits for the next deadline if any
+  void endFrame();
+  // endFrame() without the wait: the monotonic deadline to wait for, or 0
+  int64_t finishFrame();
+  // when the time limit runs out (monotonic), or 0
+  int64_t limitDeadline() const;
+
+  // seconds since start() at which the current frame is meant to be shown
+  double animationTime() const;
+  // animationTime() of the frame after this one if it is on time: one
+  // period later, or the same time with no fps to go by
+  double nextAnimationTime() const;
+
+  uint64_t frames() const { return frames_; }
+  uint64_t skipped() const { return skipped_; }
+  double elapsed() const;
+
+private:
+  void sleepUntil(int64_t deadline_ns);
+
+  FrameSchedulerConfig config_;
+  int64_t period_ns_ = 0;
+  int64_t start_ns_ = 0;
+  int64_t frame_time_ns_ = 0;
+  int64_t deadline_ns_ = 0;
+  uint64_t frames_ = 0;
+  uint64_t skipped_ = 0;
+};
+
+#endif // EGL_SRC_APP_FRAME_SCHEDULER_H_
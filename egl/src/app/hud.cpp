@@ -0,0 +1,31 @@
+#include "app/hud.h"
+
+namespace {
+
+constexpr char kTitle[] = "practice-egl";
+constexpr float kMargin = 8;
+constexpr uint32_t kTitleColor = 0xffffffff;
+constexpr uint32_t kStatusColor = 0xff80ffc0;
+
+} // namespace
+
+bool Hud::initialize(GlES2ProgramCache *cache) {
+  if (!glyphs_.initialize(GlES2GlyphCache::Config()) ||
+      !text_.initialize(cache, &glyphs_))
+    return false;
+  title_ = text_.layout(kTitle, kTitleSize);
+  return title_ != nullptr;
+}
+
+void Hud::setStatus(const std::string &status) {
+  if (status == status_text_)
+    return;
+  status_text_ = status;
+  status_ = text_.layout(status, kStatusSize);
+}
+
+void Hud::draw(int width, int height) {
+  text_.draw(title_, kMargin, kMargin, kTitleColor);
+  text_.draw(status_, kMargin, kMargin + title_->height(), kStatusColor);
+  text_.flush(width, height);
+}
@@ -0,0 +1,37 @@
+#ifndef EGL_SRC_APP_HUD_H_
+#define EGL_SRC_APP_HUD_H_
+
+#include <memory>
+#include <string>
+
+#include "gles2/glyph_cache.h"
+#include "gles2/program_cache.h"
+#include "gles2/text_renderer.h"
+
+// The text App::mainloop draws over the scene with --hud: a fixed title
+// and a status line. Both are kept as laid out runs, so a frame whose
+// status did not change only queues them and makes their draw calls.
+class Hud {
+public:
+  static constexpr float kTitleSize = 24;
+  static constexpr float kStatusSize = 16;
+
+  bool initialize(GlES2ProgramCache *cache);
+
+  // laid out again only when |status| differs from the last one
+  void setStatus(const std::string &status);
+  // over a |width| x |height| viewport
+  void draw(int width, int height);
+
+  const GlES2TextRenderer::Stats &textStats() const { return text_.stats(); }
+  const GlES2GlyphCache::Stats &glyphStats() const { return glyphs_.stats(); }
+
+private:
+  GlES2GlyphCache glyphs_;
+  GlES2TextRenderer text_;
+  std::shared_ptr<GlES2TextRun> title_;
+  std::string status_text_;
+  std::shared_ptr<GlES2TextRun> status_;
+};
+
+#endif // EGL_SRC_APP_HUD_H_
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <fstream>
+
+#include <GLES2/gl2.h>
+
+#include "app/ppm.h"
+#include "base/logging.h"
+#include "gles2/state.h"
+
+RgbImage readBackRgb(int width, int height) {
+  RgbImage image;
+  readBackRgb(width, height, nullptr, &image);
+  return image;
+}
+
+void readBackRgb(int width, int height, BlockPool *pool, RgbImage *image) {
+  std::vector<unsigned char, PoolAllocator<unsigned char>> rgba(
+      static_cast<size_t>(width) * height * 4,
+      PoolAllocator<unsigned char>(pool));
+  GlES2State::current().pixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+  image->width = width;
+  image->height = height;
+  image->rgb.resize(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; ++y) {
+    const unsigned char *src = &rgba[(height - 1 - y) * width * 4];
+    unsigned char *dst = &image->rgb[y * width * 3];
+    for (int x = 0; x < width; ++x)
+      std::copy_n(src + x * 4, 3, dst + x * 3);
+  }
+}
+
+bool writePpm(const std::string &path, const RgbImage &image) {
+  std::ofstream out(path, std::ios::binary);
+  out << "P6\n" << image.width << " " << image.height << "\n255\n";
+  out.write(reinterpret_cast<const char *>(image.rgb.data()),
+            image.rgb.size());
+  if (!out) {
+    LOG_E << "cannot write " << path;
+    return false;
+  }
+  return true;
+}
+
+bool readPpm(const std::string &path, RgbImage *image) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  int max_value = 0;
+  in >> magic >> image->width >> image->height >> max_value;
+  in.get();
+  if (!in || magic != "P6" || max_value != 255) {
+    LOG_E << "cannot read " << path;
+    return false;
+  }
+  image->rgb.resize(static_cast<size_t>(image->width) * image->height * 3);
+  in.read(reinterpret_cast<char *>(image->rgb.data()), image->rgb.size());
+  return static_cast<bool>(in);
+}
@@ -0,0 +1,25 @@
+#ifndef EGL_SRC_APP_PPM_H_
+#define EGL_SRC_APP_PPM_H_
+
+#include <string>
+#include <vector>
+
+#include "base/block_pool.h"
+
+// 8-bit RGB kept top row first, as binary PPM (P6) stores it
+struct RgbImage {
+  int width = 0;
+  int height = 0;
+  std::vector<unsigned char> rgb;
+};
+
+// the current read surface; GL rows come bottom up and are flipped
+RgbImage readBackRgb(int width, int height);
+// the same into |image|, reusing its storage, with the RGBA read-back in a
+// block of |pool| when one is given and large enough
+void readBackRgb(int width, int height, BlockPool *pool, RgbImage *image);
+
+bool writePpm(const std::string &path, const RgbImage &image);
+bool readPpm(const std::string &path, RgbImage *image);
+
+#endif // EGL_SRC_APP_PPM_H_
@@ -0,0 +1,267 @@
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "app/demo_scene.h"
+#include "app/ppm.h"
+#include "app/regression.h"
+#include "base/clock.h"
+#include "base/frame_arena.h"
+#include "base/logging.h"
+#include "gles2/program_cache.h"
+#include "gles2/state.h"
+
+namespace Regression {
+
+namespace {
+
+constexpr double kFrameStep = 1.0 / 60;
+// drawn untimed before each scene, so that a scene run on its own is
+// measured as warm as one run after the others
+constexpr int kWarmupFrames = 60;
+
+struct Scene {
+  const char *name;
+  std::function<void(DemoScene *, double)> draw;
+};
+
+struct FrameTimes {
+  double mean_ms = 0;
+  double p50_ms = 0;
+  double p95_ms = 0;
+  double max_ms = 0;
+};
+
+// fraction of pixels with a channel further than |tolerance| off
+double mismatch(const RgbImage &a, const RgbImage &b, int tolerance) {
+  size_t bad = 0;
+  for (size_t p = 0; p < a.rgb.size(); p += 3) {
+    for (int c = 0; c < 3; ++c) {
+      if (std::abs(a.rgb[p + c] - b.rgb[p + c]) > tolerance) {
+        ++bad;
+        break;
+      }
+    }
+  }
+  return static_cast<double>(bad) / (a.rgb.size() / 3);
+}
+
+FrameTimes summarize(std::vector<int64_t> ns) {
+  FrameTimes t;
+  if (ns.empty())
+    return t;
+  std::sort(ns.begin(), ns.end());
+  int64_t sum = 0;
+  for (int64_t v : ns)
+    sum += v;
+  t.mean_ms = sum / 1e6 / ns.size();
+  t.p50_ms = ns[ns.size() / 2] / 1e6;
+  t.p95_ms = ns[std::min(ns.size() - 1, ns.size() * 95 / 100)] / 1e6;
+  t.max_ms = ns.back() / 1e6;
+  return t;
+}
+
+bool writeJson(const std::string &path, int width, int height,
+               const std::vector<std::pair<std::string, FrameTimes>> &times) {
+  std::ofstream out(path);
+  out << "{\n  \"size\": \"" << width << "x" << height << "\",\n"
+      << "  \"scenes\": {\n";
+  for (size_t i = 0; i < times.size(); ++i) {
+    const FrameTimes &t = times[i].second;
+    out << "    \"" << times[i].first << "\": {\"mean_ms\": " << t.mean_ms
+        << ", \"p50_ms\": " << t.p50_ms << ", \"p95_ms\": " << t.p95_ms
+        << ", \"max_ms\": " << t.max_ms << "}"
+        << (i + 1 < times.size() ? ",\n" : "\n");
+  }
+  out << "  }\n}\n";
+  if (!out) {
+    LOG_E << "cannot write " << path;
+    return false;
+  }
+  return true;
+}
+
+// "p50_ms" of |scene| in a file written by writeJson(), or -1
+double baselineMedian(const std::string &json, const std::string &scene) {
+  const size_t at = json.find("\"" + scene + "\"");
+  if (at == std::string::npos)
+    return -1;
+  const size_t key = json.find("\"p50_ms\":", at);
+  if (key == std::string::npos)
+    return -1;
+  return strtod(json.c_str() + key + 9, nullptr);
+}
+
+} // namespace
+
+Result run(const Options &options) {
+  const bool recording = options.update || options.update_baseline;
+  if (recording && !options.scene.empty()) {
+    LOG_E << "--regress-update records every scene";
+    return Result::kFailed;
+  }
+  const std::string out_dir =
+      options.baseline_dir.empty() ? options.dir : options.baseline_dir;
+  EGLint width = 0, height = 0;
+  eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                  EGL_WIDTH, &width);
+  eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                  EGL_HEIGHT, &height);
+
+  GlES2ProgramCache cache;
+  DemoScene demo;
+  if (!demo.initialize(&cache, 4, width, height))
+    return Result::kFailed;
+  // the still frame of a run without producers
+  std::vector<unsigned char> image(DemoScene::kFrameWidth *
+                                   DemoScene::kFrameHeight * 4);
+  PipelineFrame frame;
+  frame.data = image.data();
+  DemoScene::fillFrame(&frame);
+  demo.texture().update(image.data());
+
+  const Scene scenes[] = {
+      {"quad", [](DemoScene *d, double) { d->drawQuad(); }},
+      {"triangle", [](DemoScene *d, double t) { d->drawTriangle(t); }},
+      {"composite",
+       [](DemoScene *d, double t) {
+         d->drawQuad();
+         d->drawTriangle(t);
+         d->drawEntities(t);
+       }},
+  };
+  if (!options.scene.empty() &&
+      std::none_of(std::begin(scenes), std::end(scenes),
+                   [&](const Scene &s) { return options.scene == s.name; })) {
+    LOG_E << "unknown regression scene: " << options.scene;
+    return Result::kFailed;
+  }
+  const int frames = std::max(1, options.frames);
+  const int checkpoints[] = {0, frames / 2, frames - 1};
+
+  for (const std::string &dir : {options.dir, out_dir}) {
+    if ((options.update || dir == out_dir) && mkdir(dir.c_str(), 0755) != 0 &&
+        errno != EEXIST) {
+      LOG_E << "mkdir " << dir << ": " << strerror(errno);
+      return Result::kFailed;
+    }
+  }
+  // the images are still compared without one, only the times are not
+  std::string baseline;
+  if (!recording) {
+    std::ifstream in(out_dir + "/baseline.json");
+    std::stringstream ss;
+    ss << in.rdbuf();
+    baseline = ss.str();
+    if (baseline.empty()) {
+      LOG_W << "no frame-time baseline in " << out_dir
+            << "; record one with --regress-update-baseline";
+    }
+  }
+
+  bool ok = true;
+  std::vector<std::pair<std::string, FrameTimes>> times;
+  for (const Scene &scene : scenes) {
+    if (!options.scene.empty() && options.scene != scene.name)
+      continue;
+    for (int f = 0; f < kWarmupFrames; ++f) {
+      demo.clear();
+      scene.draw(&demo, f * kFrameStep);
+      glFinish();
+      FrameArena::current().reset();
+    }
+    std::vector<int64_t> frame_ns;
+    for (int f = 0; f < frames; ++f) {
+      const int64_t begin = monotonicNowNs();
+      demo.clear();
+      scene.draw(&demo, f * kFrameStep);
+      glFinish();
+      frame_ns.push_back(monotonicNowNs() - begin);
+      FrameArena::current().reset();
+
+      if (std::find(std::begin(checkpoints), std::end(checkpoints), f) ==
+          std::end(checkpoints))
+        continue;
+      const std::string path = options.dir + "/" + scene.name + "_" +
+                                std::to_string(f) + ".ppm";
+      const RgbImage actual = readBackRgb(width, height);
+      if (options.update) {
+        ok = writePpm(path, actual) && ok;
+        continue;
+      }
+      RgbImage golden;
+      if (!readPpm(path, &golden)) {
+        ok = false;
+        continue;
+      }
+      if (golden.width != width || golden.height != height) {
+        LOG_E << path << " is " << golden.width << "x" << golden.height
+              << ", the surface " << width << "x" << height;
+        ok = false;
+        continue;
+      }
+      const double bad = mismatch(actual, golden, options.tolerance);
+      if (bad > options.max_mismatch) {
+        LOG_E << scene.name << " frame " << f << ": " << bad * 100
+              << "% of pixels differ from " << path;
+        writePpm(out_dir + "/" + scene.name + "_" + std::to_string(f) +
+                     ".actual.ppm",
+                 actual);
+        ok = false;
+      }
+    }
+
+    const FrameTimes t = summarize(std::move(frame_ns));
+    times.emplace_back(scene.name, t);
+    std::cout << "  " << scene.name << ": median " << t.p50_ms << " ms, p95 "
+              << t.p95_ms << " ms";
+    if (!recording && !baseline.empty()) {
+      const double base = baselineMedian(baseline, scene.name);
+      if (base < 0) {
+        std::cout << ", not in the baseline";
+        ok = false;
+      } else {
+        std::cout << ", baseline " << base << " ms";
+        if (t.p50_ms > base * (1 + options.threshold)) {
+          std::cout << " -> SLOWER by more than "
+                    << options.threshold * 100 << "%";
+          ok = false;
+        }
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  // one file per scene when the scenes run as separate, parallel tests
+  std::string json = "/last_run.json";
+  if (recording)
+    json = "/baseline.json";
+  else if (!options.scene.empty())
+    json = "/last_run_" + options.scene + ".json";
+  ok = writeJson(out_dir + json, width, height, times) && ok;
+  const bool untimed = !recording && baseline.empty();
+  std::cout << "regression: "
+            << (recording ? (ok ? "recorded" : "NOT RECORDED")
+                : !ok     ? "FAILED"
+                : untimed ? "images passed, frame times not checked"
+                          : "passed")
+            << std::endl;
+  if (!ok)
+    return Result::kFailed;
+  return untimed ? Result::kNoBaseline : Result::kPassed;
+}
+
+} // namespace Regression
@@ -0,0 +1,52 @@
+#ifndef EGL_SRC_APP_REGRESSION_H_
+#define EGL_SRC_APP_REGRESSION_H_
+
+#include <string>
+
+// Renders the demo scenes offscreen at fixed animation times, compares
+// read-back frames against golden images and frame times against a JSON
+// baseline. The golden images are checked in; the baseline belongs to the
+// machine that recorded it. Run by app-main --regress=DIR with a current
+// context (--headless on software Mesa keeps it reproducible).
+namespace Regression {
+
+struct Options {
+  // <scene>_<frame>.ppm golden images
+  std::string dir;
+  // baseline.json, and what a run writes: last_run.json and *.actual.ppm
+  // for mismatches. Empty: |dir|.
+  std::string baseline_dir;
+  // store this run as the new goldens and baseline instead of comparing
+  bool update = false;
+  // compare the images, but store the frame times as the new baseline
+  bool update_baseline = false;
+  // per scene, one animation step of 1/60 s each
+  int frames = 120;
+  // allowed growth of the median frame time over the baseline (0.25 =
+  // 25%); the median keeps warm-up frames out
+  double threshold = 0.25;
+  // per channel difference still counted as equal
+  int tolerance = 2;
+  // fraction of pixels allowed beyond |tolerance|
+  double max_mismatch = 0.001;
+  // only this scene (quad, triangle or composite) when not empty; its
+  // results go to last_run_<scene>.json. Not with |update| or
+  // |update_baseline|.
+  std::string scene;
+};
+
+enum class Result {
+  kPassed, // or recorded
+  kFailed, // a regression, or golden images missing, or files unwritable
+  // the images matched, but there is no baseline to time against
+  kNoBaseline,
+};
+
+// app-main's exit code for kNoBaseline, which CTest reports as skipped
+constexpr int kSkipExitCode = 77;
+
+Result run(const Options &options);
+
+} // namespace Regression
+
+#endif // EGL_SRC_APP_REGRESSION_H_
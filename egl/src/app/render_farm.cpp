@@ -0,0 +1,317 @@
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "app/demo_scene.h"
+#include "app/ppm.h"
+#include "app/render_farm.h"
+#include "base/block_pool.h"
+#include "base/clock.h"
+#include "base/frame_arena.h"
+#include "base/logging.h"
+#include "base/work_queue.h"
+#include "egl/aegl.h"
+#include "gles2/program_cache.h"
+#include "gles2/texture_loader.h"
+
+namespace RenderFarm {
+
+namespace {
+
+// the animation step of the regression run
+constexpr double kFrameStep = 1.0 / 60;
+
+enum class SceneKind { kQuad, kTriangle, kComposite };
+
+const char *const kSceneNames[] = {"quad", "triangle", "composite"};
+
+struct Job {
+  int index = 0;
+  SceneKind scene = SceneKind::kQuad;
+  int first_frame = 0;
+  int frames = 1;
+};
+
+// what every worker of one pass reads, and what they add up
+struct Shared {
+  const AEgl *root = nullptr;
+  const Options *options = nullptr;
+  int width = 0;
+  int height = 0;
+  GLuint texture = 0;
+  std::shared_ptr<GlES2ProgramBinaryStore> programs;
+  WorkStealingQueue<Job> *queue = nullptr;
+
+  std::atomic<uint64_t> jobs{0};
+  std::atomic<uint64_t> frames{0};
+  std::atomic<uint64_t> steals{0};
+  std::atomic<uint64_t> compiles{0};
+  std::atomic<uint64_t> shared_hits{0};
+  std::atomic<bool> failed{false};
+
+  // the workers set up their contexts before the clock starts and wait
+  // there for |go|
+  std::mutex mutex;
+  std::condition_variable cv;
+  int ready = 0;
+  bool go = false;
+};
+
+bool parseScene(const std::string &name, SceneKind *scene) {
+  for (int i = 0; i < 3; ++i) {
+    if (name == kSceneNames[i]) {
+      *scene = static_cast<SceneKind>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool loadJobs(const Options &options, std::vector<Job> *jobs) {
+  if (options.jobs_path.empty()) {
+    for (int i = 0; i < options.jobs; ++i) {
+      Job job;
+      job.index = i;
+      job.scene = static_cast<SceneKind>(i % 3);
+      job.first_frame = i * options.frames_per_job;
+      job.frames = std::max(1, options.frames_per_job);
+      jobs->push_back(job);
+    }
+    return true;
+  }
+
+  std::ifstream in(options.jobs_path);
+  if (!in) {
+    LOG_E << "cannot open " << options.jobs_path;
+    return false;
+  }
+  std::string line;
+  for (int line_no = 1; std::getline(in, line); ++line_no) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream fields(line);
+    std::string scene;
+    Job job;
+    job.index = jobs->size();
+    if (!(fields >> scene >> job.first_frame >> job.frames) ||
+        !parseScene(scene, &job.scene) || job.first_frame < 0 ||
+        job.frames <= 0) {
+      LOG_E << options.jobs_path << ":" << line_no << ": bad job: " << line;
+      return false;
+    }
+    jobs->push_back(job);
+  }
+  return true;
+}
+
+void draw(DemoScene *demo, SceneKind scene, double time) {
+  demo->clear();
+  if (scene != SceneKind::kTriangle)
+    demo->drawQuad();
+  if (scene != SceneKind::kQuad)
+    demo->drawTriangle(time);
+  if (scene == SceneKind::kComposite)
+    demo->drawEntities(time);
+}
+
+// counts the worker in and blocks until every worker is; false if one of
+// them failed to set up
+bool waitForStart(Shared *shared, bool ok) {
+  std::unique_lock<std::mutex> lock(shared->mutex);
+  if (!ok)
+    shared->failed = true;
+  ++shared->ready;
+  shared->cv.notify_all();
+  shared->cv.wait(lock, [shared] { return shared->go; });
+  return !shared->failed;
+}
+
+void work(int id, Shared *shared) {
+  const Options &options = *shared->options;
+  AEgl egl;
+  GlES2ProgramCache cache;
+  cache.setSharedStore(shared->programs);
+  DemoScene demo;
+  const bool ok =
+      egl.initializeShared(*shared->root, shared->width, shared->height) &&
+      demo.initialize(&cache, options.entities, shared->width,
+                      shared->height);
+  if (ok) {
+    demo.shareTexture(shared->texture);
+    // the program binaries are loaded before the clock starts
+    glFinish();
+  }
+  if (!waitForStart(shared, ok))
+    return;
+  // every frame is read back into the same two buffers
+  BlockPool readback_pool(static_cast<size_t>(shared->width) *
+                              shared->height * 4,
+                          1);
+  RgbImage image;
+
+  Job job;
+  bool stolen = false;
+  while (shared->queue->pop(id, &job, &stolen)) {
+    for (int f = job.first_frame; f < job.first_frame + job.frames; ++f) {
+      draw(&demo, job.scene, f * kFrameStep);
+      FrameArena::current().reset();
+      if (options.output_dir.empty()) {
+        glFinish();
+        continue;
+      }
+      const std::string path =
+          options.output_dir + "/" + std::to_string(job.index) + "_" +
+          kSceneNames[static_cast<int>(job.scene)] + "_" + std::to_string(f) +
+          ".ppm";
+      readBackRgb(shared->width, shared->height, &readback_pool, &image);
+      if (!writePpm(path, image))
+        shared->failed = true;
+    }
+    shared->frames += job.frames;
+    ++shared->jobs;
+    if (stolen)
+      ++shared->steals;
+  }
+  shared->compiles += cache.stats().compiles;
+  shared->shared_hits += cache.stats().shared_hits;
+}
+
+// seconds for all of |jobs| on |workers| threads, from when the last of
+// them has its context and scene; the time until then in |startup|
+double runPass(Shared *shared, const std::vector<Job> &jobs, int workers,
+               double *startup) {
+  WorkStealingQueue<Job> queue(workers);
+  // contiguous runs per worker, so that an uneven mix of scenes leaves
+  // someone to steal from
+  for (size_t i = 0; i < jobs.size(); ++i)
+    queue.push(i * workers / jobs.size(), jobs[i]);
+  shared->queue = &queue;
+
+  shared->ready = 0;
+  shared->go = false;
+  const int64_t spawn = monotonicNowNs();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < workers; ++i)
+    threads.emplace_back(work, i, shared);
+  int64_t begin;
+  {
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->cv.wait(lock, [&] { return shared->ready == workers; });
+    begin = monotonicNowNs();
+    shared->go = true;
+    shared->cv.notify_all();
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+  shared->queue = nullptr;
+  *startup = (begin - spawn) / 1e9;
+  return (monotonicNowNs() - begin) / 1e9;
+}
+
+} // namespace
+
+bool run(const AEgl &root, const Options &options) {
+  std::vector<Job> jobs;
+  if (!loadJobs(options, &jobs))
+    return false;
+  if (jobs.empty()) {
+    LOG_E << "no jobs";
+    return false;
+  }
+  if (!options.output_dir.empty() &&
+      mkdir(options.output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    LOG_E << "mkdir " << options.output_dir << ": " << strerror(errno);
+    return false;
+  }
+
+  Shared shared;
+  shared.root = &root;
+  shared.options = &options;
+  eglQuerySurface(root.getDisplay(), root.getSurface(), EGL_WIDTH,
+                  &shared.width);
+  eglQuerySurface(root.getDisplay(), root.getSurface(), EGL_HEIGHT,
+                  &shared.height);
+
+  // decoded and uploaded once here; the workers only sample it
+  std::optional<GlES2Texture> texture = GlES2Texture::create();
+  if (options.texture.empty()) {
+    std::vector<unsigned char> image(DemoScene::kFrameWidth *
+                                     DemoScene::kFrameHeight * 4);
+    PipelineFrame frame;
+    frame.data = image.data();
+    DemoScene::fillFrame(&frame);
+    if (!texture->allocate(DemoScene::kFrameWidth, DemoScene::kFrameHeight,
+                           GL_RGBA))
+      return false;
+    texture->update(image.data());
+  } else {
+    if (!loadEtc1Texture(options.texture, &*texture))
+      return false;
+  }
+  shared.texture = texture->texture();
+
+  // the root compiles every program once, and the workers load the binaries
+  shared.programs = std::make_shared<GlES2ProgramBinaryStore>();
+  GlES2ProgramCache root_cache;
+  root_cache.setSharedStore(shared.programs);
+  DemoScene root_scene;
+  if (!root_scene.initialize(&root_cache, options.entities, shared.width,
+                             shared.height))
+    return false;
+  // complete before another context samples or links them
+  glFinish();
+
+  const int max_workers =
+      options.workers > 0
+          ? options.workers
+          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  std::vector<int> passes;
+  if (options.scaling) {
+    for (int n = 1; n < max_workers; n *= 2)
+      passes.push_back(n);
+  }
+  passes.push_back(max_workers);
+
+  std::cout << "farm: " << jobs.size() << " jobs, " << shared.width << "x"
+            << shared.height << ", " << root_cache.stats().compiles
+            << " programs compiled" << std::endl;
+  double base_rate = 0;
+  for (int workers : passes) {
+    shared.jobs = shared.frames = shared.steals = 0;
+    shared.compiles = shared.shared_hits = 0;
+    double startup = 0;
+    const double seconds = runPass(&shared, jobs, workers, &startup);
+    if (shared.failed)
+      break;
+    const double rate = seconds > 0 ? shared.jobs / seconds : 0;
+    if (base_rate == 0)
+      base_rate = rate;
+    std::cout << "  workers=" << workers << ": jobs/s=" << rate
+              << " frames/s=" << (seconds > 0 ? shared.frames / seconds : 0)
+              << " speedup=" << (base_rate > 0 ? rate / base_rate : 0)
+              << " startup_ms=" << startup * 1e3
+              << " steals=" << shared.steals
+              << " compiles=" << shared.compiles
+              << " shared_programs=" << shared.shared_hits << std::endl;
+  }
+  std::cout << "farm: " << (shared.failed ? "FAILED" : "done") << std::endl;
+  return !shared.failed;
+}
+
+} // namespace RenderFarm
@@ -0,0 +1,40 @@
+#ifndef EGL_SRC_APP_RENDER_FARM_H_
+#define EGL_SRC_APP_RENDER_FARM_H_
+
+#include <string>
+
+class AEgl;
+
+// Batch rendering of the demo scenes offscreen. A pool of workers, each
+// with its own pbuffer and context in the share group of the root context,
+// pulls jobs (a scene and a frame range) from a work-stealing queue and
+// writes the frames as PPM. The quad texture is decoded and uploaded once
+// by the root context and shared; programs are compiled once and handed to
+// the other workers as binaries. Run by app-main --farm --headless.
+namespace RenderFarm {
+
+struct Options {
+  // one job per line: "<quad|triangle|composite> <first_frame> <frames>";
+  // empty: |jobs| generated jobs cycling through the scenes
+  std::string jobs_path;
+  int jobs = 48;
+  int frames_per_job = 8;
+  // <dir>/<job>_<scene>_<frame>.ppm; empty renders without writing
+  std::string output_dir;
+  // 0: one per core
+  int workers = 0;
+  // also run with 1, 2, 4, ... workers up to |workers| and compare
+  bool scaling = false;
+  // cubes in the composite scene; 0 leaves them out
+  int entities = 0;
+  // ETC1 .ktx/.pkm for the quad instead of the still pipeline frame
+  std::string texture;
+};
+
+// |root| is current on the calling thread and stays so. false if a job
+// file, a worker context or an output file failed.
+bool run(const AEgl &root, const Options &options);
+
+} // namespace RenderFarm
+
+#endif // EGL_SRC_APP_RENDER_FARM_H_
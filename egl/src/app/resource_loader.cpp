@@ -0,0 +1,100 @@
+#include <GLES2/gl2.h>
+
+#include "app/resource_loader.h"
+#include "base/clock.h"
+#include "base/logging.h"
+#include "egl/aegl.h"
+
+namespace {
+
+PFNEGLCREATESYNCKHRPROC createSync = nullptr;
+PFNEGLDESTROYSYNCKHRPROC destroySync = nullptr;
+PFNEGLCLIENTWAITSYNCKHRPROC clientWaitSync = nullptr;
+
+bool loadFenceSync(const AEgl &egl) {
+  if (!egl.hasExtension("EGL_KHR_fence_sync"))
+    return false;
+  createSync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+      eglGetProcAddress("eglCreateSyncKHR"));
+  destroySync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+      eglGetProcAddress("eglDestroySyncKHR"));
+  clientWaitSync = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+      eglGetProcAddress("eglClientWaitSyncKHR"));
+  return createSync && destroySync && clientWaitSync;
+}
+
+} // namespace
+
+ResourceLoader::~ResourceLoader() {
+  if (thread_.joinable())
+    thread_.join();
+  for (size_t i = ready_; i < fences_.size(); ++i) {
+    if (fences_[i] != EGL_NO_SYNC_KHR)
+      destroySync(display_, fences_[i]);
+  }
+}
+
+bool ResourceLoader::start(const AEgl &share, std::vector<Task> tasks) {
+  display_ = share.getDisplay();
+  tasks_ = std::move(tasks);
+  stats_.fence_sync = loadFenceSync(share);
+  thread_ = std::thread(&ResourceLoader::run, this, &share);
+  return true;
+}
+
+void ResourceLoader::run(const AEgl *share) {
+  const int64_t begin = monotonicNowNs();
+  AEgl egl;
+  if (!egl.initializeShared(*share, 0, 0)) {
+    failed_ = true;
+    if (ready_callback_)
+      ready_callback_();
+    return;
+  }
+  const int64_t tasks_begin = monotonicNowNs();
+  stats_.context_ns = tasks_begin - begin;
+
+  for (const Task &task : tasks_) {
+    if (!task()) {
+      failed_ = true;
+      if (ready_callback_)
+        ready_callback_();
+      break;
+    }
+    EGLSyncKHR fence = EGL_NO_SYNC_KHR;
+    if (stats_.fence_sync) {
+      fence = createSync(display_, EGL_SYNC_FENCE_KHR, nullptr);
+      // or the render thread could wait for a fence never submitted
+      glFlush();
+    }
+    if (fence == EGL_NO_SYNC_KHR)
+      glFinish();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fences_.push_back(fence);
+    }
+    if (ready_callback_)
+      ready_callback_();
+  }
+  stats_.tasks_ns = monotonicNowNs() - tasks_begin;
+}
+
+int ResourceLoader::ready() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (ready_ < static_cast<int>(fences_.size())) {
+    EGLSyncKHR fence = fences_[ready_];
+    if (fence != EGL_NO_SYNC_KHR) {
+      if (clientWaitSync(display_, fence, 0, 0) != EGL_CONDITION_SATISFIED_KHR)
+        break;
+      destroySync(display_, fence);
+    }
+    ++ready_;
+  }
+  return ready_;
+}
+
+const ResourceLoader::Stats &ResourceLoader::stats() {
+  if (thread_.joinable())
+    thread_.join();
+  return stats_;
+}
@@ -0,0 +1,69 @@
+#ifndef EGL_SRC_APP_RESOURCE_LOADER_H_
+#define EGL_SRC_APP_RESOURCE_LOADER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+class AEgl;
+
+// Runs GL work (shader compiles, texture uploads) on a thread of its own
+// with a second context in the share group of the render context, so that
+// the render thread can draw from the first frame on. Every task is
+// followed by an EGL fence (or glFinish without EGL_KHR_fence_sync); the
+// render thread polls ready() and uses what a task created only once its
+// fence has signalled.
+class ResourceLoader {
+public:
+  // false stops the loader; later tasks do not run
+  using Task = std::function<bool()>;
+
+  struct Stats {
+    bool fence_sync = false;
+    // creating the loader context
+    int64_t context_ns = 0;
+    // running the tasks, fences included
+    int64_t tasks_ns = 0;
+  };
+
+  ~ResourceLoader();
+
+  // |share| is the current context of the calling thread. Tasks run in
+  // order.
+  bool start(const AEgl &share, std::vector<Task> tasks);
+  // |callback| runs on the loader thread after each task is fenced. Set it
+  // before start().
+  void setReadyCallback(std::function<void()> callback) {
+    ready_callback_ = std::move(callback);
+  }
+  // tasks done and signalled, in order; never blocks. Render thread only.
+  int ready();
+  int tasks() const { return tasks_.size(); }
+  bool failed() const { return failed_; }
+  // waits for the thread; valid after the last task is ready()
+  const Stats &stats();
+
+private:
+  void run(const AEgl *share);
+
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  std::vector<Task> tasks_;
+  std::function<void()> ready_callback_;
+  std::thread thread_;
+  std::atomic<bool> failed_{false};
+  std::mutex mutex_;
+  // one per finished task, guarded by |mutex_|; EGL_NO_SYNC_KHR after a
+  // glFinish
+  std::vector<EGLSyncKHR> fences_;
+  // touched by the render thread only
+  int ready_ = 0;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_APP_RESOURCE_LOADER_H_
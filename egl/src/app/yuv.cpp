@@ -0,0 +1,192 @@
+#include <cstddef>
+#include <cstring>
+
+#include "app/yuv.h"
+#include "math/simd.h"
+
+namespace {
+
+inline uint8_t lumaOf(int r, int g, int b) {
+  return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+// from sums over up to four texels, |n| of them
+inline void chromaOf(int r, int g, int b, int n, uint8_t *u, uint8_t *v) {
+  r = (r + n / 2) / n;
+  g = (g + n / 2) / n;
+  b = (b + n / 2) / n;
+  *u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+  *v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+// columns [x_begin, width) of the row pair |row0|, |row1| (equal when the
+// image has an odd last row)
+void convertScalar(const uint8_t *row0, const uint8_t *row1, int x_begin,
+                   int width, uint8_t *y0, uint8_t *y1, uint8_t *u,
+                   uint8_t *v) {
+  for (int x = x_begin; x < width; x += 2) {
+    int r = 0, g = 0, b = 0, n = 0;
+    for (int dx = 0; dx < 2 && x + dx < width; ++dx) {
+      const uint8_t *p0 = row0 + (x + dx) * 4;
+      const uint8_t *p1 = row1 + (x + dx) * 4;
+      y0[x + dx] = lumaOf(p0[0], p0[1], p0[2]);
+      y1[x + dx] = lumaOf(p1[0], p1[1], p1[2]);
+      r += p0[0] + p1[0];
+      g += p0[1] + p1[1];
+      b += p0[2] + p1[2];
+      n += 2;
+    }
+    chromaOf(r, g, b, n, u + x / 2, v + x / 2);
+  }
+}
+
+#if defined(MATH_SSE2)
+// 16-bit lanes; the sums stay below 2^16 with the +128 biases folded in, so
+// wrapping adds and logical shifts give the exact integer formulas above
+struct Rgb8 {
+  __m128i r, g, b;
+};
+
+Rgb8 load8(const uint8_t *p) {
+  const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  const __m128i hi =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+  const __m128i mask = _mm_set1_epi32(0xff);
+  auto channel = [&](int shift) {
+    return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, shift), mask),
+                           _mm_and_si128(_mm_srli_epi32(hi, shift), mask));
+  };
+  return {channel(0), channel(8), channel(16)};
+}
+
+__m128i luma8(const Rgb8 &c) {
+  __m128i y = _mm_mullo_epi16(c.r, _mm_set1_epi16(66));
+  y = _mm_add_epi16(y, _mm_mullo_epi16(c.g, _mm_set1_epi16(129)));
+  y = _mm_add_epi16(y, _mm_mullo_epi16(c.b, _mm_set1_epi16(25)));
+  y = _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+  return _mm_add_epi16(y, _mm_set1_epi16(16));
+}
+
+// rounded means of horizontal pairs of a + b, in the low four lanes
+__m128i average2x2(__m128i a, __m128i b) {
+  const __m128i sums = _mm_madd_epi16(_mm_add_epi16(a, b), _mm_set1_epi16(1));
+  const __m128i mean =
+      _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(2)), 2);
+  return _mm_packs_epi32(mean, mean);
+}
+
+void convert8(const uint8_t *row0, const uint8_t *row1, uint8_t *y0,
+              uint8_t *y1, uint8_t *u, uint8_t *v) {
+  const Rgb8 a = load8(row0);
+  const Rgb8 b = load8(row1);
+  const __m128i ya = luma8(a), yb = luma8(b);
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(y0), _mm_packus_epi16(ya, ya));
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(y1), _mm_packus_epi16(yb, yb));
+
+  const __m128i r = average2x2(a.r, b.r);
+  const __m128i g = average2x2(a.g, b.g);
+  const __m128i bl = average2x2(a.b, b.b);
+  // -38r - 74g + 112b + 128 + (128 << 8), then >> 8
+  __m128i cu = _mm_mullo_epi16(bl, _mm_set1_epi16(112));
+  cu = _mm_sub_epi16(cu, _mm_mullo_epi16(r, _mm_set1_epi16(38)));
+  cu = _mm_sub_epi16(cu, _mm_mullo_epi16(g, _mm_set1_epi16(74)));
+  cu = _mm_srli_epi16(_mm_add_epi16(cu, _mm_set1_epi16(-32640)), 8);
+  __m128i cv = _mm_mullo_epi16(r, _mm_set1_epi16(112));
+  cv = _mm_sub_epi16(cv, _mm_mullo_epi16(g, _mm_set1_epi16(94)));
+  cv = _mm_sub_epi16(cv, _mm_mullo_epi16(bl, _mm_set1_epi16(18)));
+  cv = _mm_srli_epi16(_mm_add_epi16(cv, _mm_set1_epi16(-32640)), 8);
+  const int pu = _mm_cvtsi128_si32(_mm_packus_epi16(cu, cu));
+  const int pv = _mm_cvtsi128_si32(_mm_packus_epi16(cv, cv));
+  memcpy(u, &pu, 4);
+  memcpy(v, &pv, 4);
+}
+#elif defined(MATH_NEON)
+uint16x8_t luma8(uint16x8_t r, uint16x8_t g, uint16x8_t b) {
+  uint16x8_t y = vmulq_n_u16(r, 66);
+  y = vmlaq_n_u16(y, g, 129);
+  y = vmlaq_n_u16(y, b, 25);
+  return vaddq_u16(vshrq_n_u16(vaddq_u16(y, vdupq_n_u16(128)), 8),
+                   vdupq_n_u16(16));
+}
+
+void convert8(const uint8_t *row0, const uint8_t *row1, uint8_t *y0,
+              uint8_t *y1, uint8_t *u, uint8_t *v) {
+  const uint8x8x4_t a = vld4_u8(row0);
+  const uint8x8x4_t b = vld4_u8(row1);
+  const uint16x8_t ar = vmovl_u8(a.val[0]), ag = vmovl_u8(a.val[1]),
+                   ab = vmovl_u8(a.val[2]);
+  const uint16x8_t br = vmovl_u8(b.val[0]), bg = vmovl_u8(b.val[1]),
+                   bb = vmovl_u8(b.val[2]);
+  vst1_u8(y0, vmovn_u16(luma8(ar, ag, ab)));
+  vst1_u8(y1, vmovn_u16(luma8(br, bg, bb)));
+
+  // rounded 2x2 means in the low four lanes
+  auto average = [](uint16x8_t p, uint16x8_t q) {
+    const uint16x4_t s = vpadd_u16(vget_low_u16(vaddq_u16(p, q)),
+                                   vget_high_u16(vaddq_u16(p, q)));
+    const uint16x4_t m = vshr_n_u16(vadd_u16(s, vdup_n_u16(2)), 2);
+    return vcombine_u16(m, m);
+  };
+  const uint16x8_t r = average(ar, br), g = average(ag, bg),
+                   bl = average(ab, bb);
+  uint16x8_t cu = vmulq_n_u16(bl, 112);
+  cu = vmlsq_n_u16(cu, r, 38);
+  cu = vmlsq_n_u16(cu, g, 74);
+  cu = vshrq_n_u16(vaddq_u16(cu, vdupq_n_u16(32896)), 8);
+  uint16x8_t cv = vmulq_n_u16(r, 112);
+  cv = vmlsq_n_u16(cv, g, 94);
+  cv = vmlsq_n_u16(cv, bl, 18);
+  cv = vshrq_n_u16(vaddq_u16(cv, vdupq_n_u16(32896)), 8);
+  const uint8x8_t pu = vmovn_u16(cu), pv = vmovn_u16(cv);
+  vst1_lane_u32(reinterpret_cast<uint32_t *>(u),
+                vreinterpret_u32_u8(pu), 0);
+  vst1_lane_u32(reinterpret_cast<uint32_t *>(v),
+                vreinterpret_u32_u8(pv), 0);
+}
+#endif
+
+template <bool kSimd>
+void convert(const uint8_t *rgba, int width, int height, int stride, bool flip,
+             uint8_t *y, uint8_t *u, uint8_t *v) {
+  const int chroma_width = (width + 1) / 2;
+  auto row = [&](int r) {
+    return rgba + static_cast<ptrdiff_t>(flip ? height - 1 - r : r) * stride;
+  };
+  for (int r = 0; r < height; r += 2) {
+    const int r1 = r + 1 < height ? r + 1 : r;
+    uint8_t *y0 = y + static_cast<size_t>(r) * width;
+    uint8_t *y1 = y + static_cast<size_t>(r1) * width;
+    uint8_t *cu = u + static_cast<size_t>(r / 2) * chroma_width;
+    uint8_t *cv = v + static_cast<size_t>(r / 2) * chroma_width;
+    int x = 0;
+#if !defined(MATH_SCALAR)
+    if (kSimd) {
+      for (; x + 8 <= width; x += 8)
+        convert8(row(r) + x * 4, row(r1) + x * 4, y0 + x, y1 + x, cu + x / 2,
+                 cv + x / 2);
+    }
+#endif
+    convertScalar(row(r), row(r1), x, width, y0, y1, cu, cv);
+  }
+}
+
+} // namespace
+
+void rgbaToI420(const uint8_t *rgba, int width, int height, int stride,
+                bool flip, uint8_t *y, uint8_t *u, uint8_t *v) {
+  convert<true>(rgba, width, height, stride, flip, y, u, v);
+}
+
+void rgbaToI420Scalar(const uint8_t *rgba, int width, int height, int stride,
+                      bool flip, uint8_t *y, uint8_t *u, uint8_t *v) {
+  convert<false>(rgba, width, height, stride, flip, y, u, v);
+}
+
+const char *yuvSimdPath() {
+#if defined(MATH_SSE2)
+  return "sse2";
+#elif defined(MATH_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
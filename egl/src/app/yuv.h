@@ -0,0 +1,19 @@
+#ifndef EGL_SRC_APP_YUV_H_
+#define EGL_SRC_APP_YUV_H_
+
+#include <cstdint>
+
+// RGBA8 to I420 (BT.601, limited range), chroma averaged over 2x2 blocks.
+// |stride| is the row pitch of |rgba| in bytes; |flip| reads the rows
+// bottom-up, as glReadPixels returns them. The planes are tightly packed:
+// |y| is width x height, |u| and |v| are ceil(width / 2) x ceil(height / 2).
+void rgbaToI420(const uint8_t *rgba, int width, int height, int stride,
+                bool flip, uint8_t *y, uint8_t *u, uint8_t *v);
+// the same without SIMD
+void rgbaToI420Scalar(const uint8_t *rgba, int width, int height, int stride,
+                      bool flip, uint8_t *y, uint8_t *u, uint8_t *v);
+
+// "sse2", "neon" or "scalar"
+const char *yuvSimdPath();
+
+#endif // EGL_SRC_APP_YUV_H_
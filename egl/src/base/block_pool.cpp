@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "base/block_pool.h"
+#include "base/logging.h"
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+#if ALLOC_DEBUG
+constexpr size_t kGuardBytes = 16;
+constexpr unsigned char kGuard = 0xfd;
+constexpr unsigned char kFreed = 0xdd;
+#else
+constexpr size_t kGuardBytes = 0;
+#endif
+
+} // namespace
+
+BlockPool::BlockPool(size_t block_bytes, size_t max_free)
+    : block_bytes_(block_bytes), max_free_(max_free) {}
+
+BlockPool::~BlockPool() {
+  for (unsigned char *block : free_)
+    free(block);
+  if (stats_.outstanding)
+    LOG_W << "block pool destroyed with " << stats_.outstanding
+          << " blocks out";
+}
+
+unsigned char *BlockPool::acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.acquired;
+    ++stats_.outstanding;
+    if (stats_.outstanding > stats_.peak_outstanding)
+      stats_.peak_outstanding = stats_.outstanding;
+    if (!free_.empty()) {
+      unsigned char *block = free_.back();
+      free_.pop_back();
+      ++stats_.reused;
+      return block;
+    }
+  }
+  const size_t bytes = block_bytes_ + kGuardBytes;
+  auto *block = static_cast<unsigned char *>(
+      aligned_alloc(kAlignment, (bytes + kAlignment - 1) & ~(kAlignment - 1)));
+  if (!block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --stats_.outstanding;
+    return nullptr;
+  }
+#if ALLOC_DEBUG
+  memset(block + block_bytes_, kGuard, kGuardBytes);
+#endif
+  return block;
+}
+
+void BlockPool::release(unsigned char *block) {
+  if (!block)
+    return;
+  checkGuard(block);
+  std::lock_guard<std::mutex> lock(mutex_);
+  --stats_.outstanding;
+  if (free_.size() < max_free_) {
+#if ALLOC_DEBUG
+    // a use after release reads the pattern, not the old pixels
+    memset(block, kFreed, block_bytes_);
+#endif
+    free_.push_back(block);
+  } else {
+    free(block);
+  }
+}
+
+BlockPool::Stats BlockPool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.free_blocks = free_.size();
+  return stats;
+}
+
+void BlockPool::checkGuard(const unsigned char *block) const {
+#if ALLOC_DEBUG
+  for (size_t i = 0; i < kGuardBytes; ++i) {
+    if (block[block_bytes_ + i] != kGuard) {
+      LOG_E << "block pool: write past a " << block_bytes_ << " byte block";
+      Logging::stop(); // flush the message
+      abort();
+    }
+  }
+#else
+  (void)block;
+#endif
+}
@@ -0,0 +1,101 @@
+#ifndef BASE_BLOCK_POOL_H_
+#define BASE_BLOCK_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "base/frame_arena.h"
+
+// Recycles blocks of one size (pixel buffers of a given image size): a
+// released block goes on a free list and the next acquire() takes it back
+// instead of calling malloc. Up to |max_free| blocks are kept; the rest
+// are freed. Thread-safe, so blocks may be released on another thread.
+class BlockPool {
+public:
+  struct Stats {
+    uint64_t acquired = 0;
+    // acquired from the free list: the malloc calls avoided
+    uint64_t reused = 0;
+    size_t outstanding = 0;
+    size_t peak_outstanding = 0;
+    size_t free_blocks = 0;
+  };
+
+  struct Releaser {
+    BlockPool *pool;
+    void operator()(unsigned char *block) const { pool->release(block); }
+  };
+  using Block = std::unique_ptr<unsigned char, Releaser>;
+
+  explicit BlockPool(size_t block_bytes, size_t max_free = 8);
+  ~BlockPool();
+  BlockPool(const BlockPool &) = delete;
+  BlockPool &operator=(const BlockPool &) = delete;
+
+  size_t blockBytes() const { return block_bytes_; }
+
+  // blockBytes() bytes, 64-byte aligned; nullptr if malloc fails
+  unsigned char *acquire();
+  void release(unsigned char *block);
+  Block acquireBlock() { return Block(acquire(), Releaser{this}); }
+
+  Stats stats() const;
+
+private:
+  void checkGuard(const unsigned char *block) const;
+
+  const size_t block_bytes_;
+  const size_t max_free_;
+  mutable std::mutex mutex_;
+  std::vector<unsigned char *> free_;
+  Stats stats_;
+};
+
+// std::allocator stand-in that serves requests of up to one block from a
+// BlockPool and larger ones (or all, without a pool) from the heap: for
+// vectors of pixels whose size is usually, but not always, the pool's.
+template <typename T> class PoolAllocator {
+public:
+  using value_type = T;
+
+  explicit PoolAllocator(BlockPool *pool = nullptr) : pool_(pool) {}
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &other) : pool_(other.pool()) {}
+
+  T *allocate(size_t n) {
+    if (pooled(n)) {
+      unsigned char *block = pool_->acquire();
+      if (!block)
+        throw std::bad_alloc();
+      return reinterpret_cast<T *>(block);
+    }
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *p, size_t n) {
+    if (pooled(n))
+      pool_->release(reinterpret_cast<unsigned char *>(p));
+    else
+      ::operator delete(p);
+  }
+
+  BlockPool *pool() const { return pool_; }
+  template <typename U> bool operator==(const PoolAllocator<U> &o) const {
+    return pool_ == o.pool();
+  }
+  template <typename U> bool operator!=(const PoolAllocator<U> &o) const {
+    return pool_ != o.pool();
+  }
+
+private:
+  bool pooled(size_t n) const {
+    return pool_ && n * sizeof(T) <= pool_->blockBytes() && alignof(T) <= 64;
+  }
+
+  BlockPool *pool_;
+};
+
+#endif // BASE_BLOCK_POOL_H_
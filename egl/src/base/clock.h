@@ -0,0 +1,15 @@
+#ifndef BASE_CLOCK_H_
+#define BASE_CLOCK_H_
+
+#include <cstdint>
+#include <ctime>
+
+constexpr int64_t kNsPerSec = 1000000000;
+
+inline int64_t monotonicNowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * kNsPerSec + ts.tv_nsec;
+}
+
+#endif // BASE_CLOCK_H_
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "base/frame_arena.h"
+#include "base/logging.h"
+
+namespace {
+
+#if ALLOC_DEBUG
+constexpr size_t kGuardBytes = 16;
+constexpr unsigned char kGuard = 0xfd;
+constexpr unsigned char kFresh = 0xcd;
+constexpr unsigned char kFreed = 0xdd;
+#else
+constexpr size_t kGuardBytes = 0;
+#endif
+
+} // namespace
+
+FrameArena::FrameArena(size_t capacity)
+    : block_(new unsigned char[capacity]), capacity_(capacity) {
+#if ALLOC_DEBUG
+  memset(block_.get(), kFreed, capacity_);
+#endif
+}
+
+FrameArena::~FrameArena() { reset(); }
+
+FrameArena &FrameArena::current() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+void *FrameArena::allocate(size_t bytes, size_t align) {
+  ++stats_.allocations;
+  ++stats_.total_allocations;
+  const uintptr_t base = reinterpret_cast<uintptr_t>(block_.get());
+  const size_t begin = ((base + offset_ + align - 1) & ~(align - 1)) - base;
+  // written so that a huge |bytes| cannot wrap around
+  if (begin + kGuardBytes > capacity_ ||
+      bytes > capacity_ - begin - kGuardBytes) {
+    ++stats_.overflows;
+    ++stats_.total_overflows;
+    if (stats_.total_overflows == 1) {
+      LOG_W << "frame arena of " << capacity_ << " bytes full; " << bytes
+            << " bytes from malloc";
+    }
+    // aligned_alloc wants a size that is a multiple of the alignment, and
+    // some libcs an alignment of at least a pointer
+    const size_t alignment = std::max(align, sizeof(void *));
+    if (bytes > SIZE_MAX - alignment) {
+      LOG_E << "frame arena: " << bytes << " bytes is too large";
+      return nullptr;
+    }
+    const size_t size =
+        (std::max<size_t>(bytes, 1) + alignment - 1) & ~(alignment - 1);
+    void *p = aligned_alloc(alignment, size);
+    if (!p) {
+      LOG_E << "frame arena: aligned_alloc of " << size << " bytes failed";
+      return nullptr;
+    }
+    overflow_.push_back(p);
+    return p;
+  }
+  offset_ = begin + bytes + kGuardBytes;
+  stats_.used = offset_;
+  if (offset_ > stats_.peak)
+    stats_.peak = offset_;
+#if ALLOC_DEBUG
+  memset(block_.get() + begin, kFresh, bytes);
+  memset(block_.get() + begin + bytes, kGuard, kGuardBytes);
+  guards_.push_back(begin + bytes);
+#endif
+  return block_.get() + begin;
+}
+
+void FrameArena::reset() {
+  checkGuards();
+#if ALLOC_DEBUG
+  // stale pointers read the pattern instead of last frame's data
+  memset(block_.get(), kFreed, offset_);
+  guards_.clear();
+#endif
+  for (void *p : overflow_)
+    free(p);
+  overflow_.clear();
+  offset_ = 0;
+  stats_.used = 0;
+  stats_.allocations = 0;
+  stats_.overflows = 0;
+  ++stats_.frames;
+}
+
+void FrameArena::checkGuards() const {
+#if ALLOC_DEBUG
+  for (size_t at : guards_) {
+    for (size_t i = 0; i < kGuardBytes; ++i) {
+      if (block_[at + i] != kGuard) {
+        LOG_E << "frame arena: write past the allocation ending at offset "
+              << at;
+        Logging::stop(); // flush the message
+        abort();
+      }
+    }
+  }
+#endif
+}
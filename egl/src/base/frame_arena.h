@@ -0,0 +1,110 @@
+#ifndef BASE_FRAME_ARENA_H_
+#define BASE_FRAME_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Guard bytes after every arena allocation and block, checked on reset and
+// release, and poison patterns over freed and fresh memory. Set by the
+// ALLOC_DEBUG CMake option.
+#ifndef ALLOC_DEBUG
+#define ALLOC_DEBUG 0
+#endif
+
+// Bump allocator for data that lives until the end of a frame: allocate()
+// moves a pointer through one preallocated block and reset() takes it all
+// back at once. Requests the block cannot hold go to malloc (counted as
+// overflows) and are freed on reset(); size the arena from the peak.
+// Not thread-safe: one per thread, see current().
+class FrameArena {
+public:
+  struct Stats {
+    uint64_t frames = 0;
+    // since the last reset()
+    size_t used = 0;
+    uint64_t allocations = 0;
+    uint64_t overflows = 0;
+    // over all frames; allocations are the malloc calls avoided
+    size_t peak = 0;
+    uint64_t total_allocations = 0;
+    uint64_t total_overflows = 0;
+  };
+
+  static constexpr size_t kDefaultCapacity = 1 << 20;
+
+  explicit FrameArena(size_t capacity = kDefaultCapacity);
+  ~FrameArena();
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // the calling thread's arena; the render thread resets it after
+  // eglSwapBuffers
+  static FrameArena &current();
+
+  // |align| is a power of two. Null only when an overflow cannot be
+  // served by malloc either.
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+  template <typename T> T *allocateArray(size_t n) {
+    if (n > SIZE_MAX / sizeof(T))
+      return nullptr;
+    return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+  }
+  // everything allocated since the last reset() becomes invalid
+  void reset();
+
+  size_t capacity() const { return capacity_; }
+  const Stats &stats() const { return stats_; }
+
+private:
+  void checkGuards() const;
+
+  std::unique_ptr<unsigned char[]> block_;
+  size_t capacity_;
+  size_t offset_ = 0;
+  std::vector<void *> overflow_;
+#if ALLOC_DEBUG
+  // end of each allocation, where its guard bytes start
+  std::vector<size_t> guards_;
+#endif
+  Stats stats_;
+};
+
+// std::allocator stand-in over a FrameArena: deallocate() is a no-op, so a
+// container must not outlive the frame. Growing containers leave their old
+// storage in the arena; reserve() up front.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena *arena = &FrameArena::current())
+      : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena()) {}
+
+  T *allocate(size_t n) {
+    T *p = arena_->allocateArray<T>(n);
+    if (!p)
+      throw std::bad_alloc();
+    return p;
+  }
+  void deallocate(T *, size_t) {}
+
+  FrameArena *arena() const { return arena_; }
+  template <typename U> bool operator==(const ArenaAllocator<U> &o) const {
+    return arena_ == o.arena();
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &o) const {
+    return arena_ != o.arena();
+  }
+
+private:
+  FrameArena *arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // BASE_FRAME_ARENA_H_
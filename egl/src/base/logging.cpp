@@ -0,0 +1,402 @@
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "base/clock.h"
+#include "base/logging.h"
+
+namespace Logging {
+
+std::atomic<int> g_verbosity{0};
+
+namespace {
+
+struct RecordHeader {
+  int64_t time_ns;
+  uint32_t length;
+};
+
+// bytes a record of |length| takes in a ring; records stay 8-byte aligned
+constexpr size_t footprint(size_t length) {
+  return (sizeof(RecordHeader) + length + 7) & ~size_t(7);
+}
+
+// single-producer single-consumer byte ring of variable-length records, so
+// a push copies only the bytes the message uses. A record may wrap around
+// the end of the buffer.
+class RecordRing {
+public:
+  explicit RecordRing(size_t bytes) {
+    size_t n = 64;
+    while (n < bytes)
+      n *= 2;
+    buffer_.reset(new char[n]);
+    mask_ = n - 1;
+  }
+
+  // producer side. false when full.
+  bool push(int64_t time_ns, const char *text, size_t length) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t size = footprint(length);
+    if (size > mask_ + 1 - (tail - head_.load(std::memory_order_acquire)))
+      return false;
+    const RecordHeader header = {time_ns, static_cast<uint32_t>(length)};
+    copyIn(tail, &header, sizeof(header));
+    copyIn(tail + sizeof(header), text, length);
+    tail_.store(tail + size, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side. Appends the record's text to |text|; false when empty.
+  bool pop(RecordHeader *header, std::string *text) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    copyOut(head, header, sizeof(*header));
+    const size_t at = text->size();
+    text->resize(at + header->length);
+    copyOut(head + sizeof(*header), &(*text)[at], header->length);
+    head_.store(head + footprint(header->length), std::memory_order_release);
+    return true;
+  }
+
+  // bytes not yet popped; exact only on the calling side
+  size_t used() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  void copyIn(size_t at, const void *data, size_t size) {
+    const size_t offset = at & mask_;
+    const size_t first = std::min(size, mask_ + 1 - offset);
+    memcpy(&buffer_[offset], data, first);
+    memcpy(&buffer_[0], static_cast<const char *>(data) + first, size - first);
+  }
+  void copyOut(size_t at, void *data, size_t size) const {
+    const size_t offset = at & mask_;
+    const size_t first = std::min(size, mask_ + 1 - offset);
+    memcpy(data, &buffer_[offset], first);
+    memcpy(static_cast<char *>(data) + first, &buffer_[0], size - first);
+  }
+
+  std::unique_ptr<char[]> buffer_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+struct ThreadRing {
+  explicit ThreadRing(size_t records)
+      : queue(records * footprint(kMaxMessage + 1)) {}
+  RecordRing queue;
+  // set when the thread exits; the writer frees the ring once drained
+  std::atomic<bool> orphaned{false};
+};
+
+// writer states
+enum : int {
+  kAwake,
+  // between drains that found records; woken only by a ring filling up
+  kNapping,
+  // nothing queued anywhere; woken by the first message
+  kIdle,
+};
+
+struct Backend {
+  Config config;
+  std::atomic<bool> running{false};
+  std::thread writer;
+  // guards |rings| (taken once per thread and by the writer, never per
+  // message)
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadRing>> rings;
+  // the writer sleeps on |wake| unless kAwake; ~Message() and stop() bump
+  // |wake| to wake it
+  std::atomic<uint32_t> wake{0};
+  std::atomic<int> state{kAwake};
+  std::atomic<uint64_t> written{0};
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<uint64_t> truncated{0};
+};
+
+// never destroyed: threads may log during exit
+Backend &backend() {
+  static Backend *b = new Backend;
+  return *b;
+}
+
+// trivially destructible, so still readable from thread_local destructors
+// that run after the ring's holder is gone
+thread_local ThreadRing *t_ring = nullptr;
+thread_local bool t_exited = false;
+
+// registers the calling thread's ring on its first message; null once the
+// thread is exiting and its ring has been handed to the writer
+ThreadRing *threadRing() {
+  struct Holder {
+    ~Holder() {
+      if (t_ring)
+        t_ring->orphaned.store(true, std::memory_order_release);
+      t_ring = nullptr;
+      t_exited = true;
+    }
+  };
+  if (t_ring || t_exited)
+    return t_ring;
+  thread_local Holder holder;
+  Backend &b = backend();
+  auto ring = std::make_unique<ThreadRing>(b.config.ring_records);
+  t_ring = ring.get();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  b.rings.push_back(std::move(ring));
+  return t_ring;
+}
+
+void writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    const ssize_t n = write(fd, data, size);
+    if (n <= 0)
+      return; // nowhere to report it
+    data += n;
+    size -= n;
+  }
+}
+
+// a popped record; its text is in the drain's text buffer
+struct Entry {
+  int64_t time_ns;
+  size_t offset;
+  size_t length;
+};
+
+// writes everything queued so far, oldest first across threads. Only the
+// writer thread (or stop() after joining it) calls this.
+bool drain(std::vector<Entry> *batch, std::string *texts,
+           std::string *out) {
+  Backend &b = backend();
+  std::vector<ThreadRing *> rings;
+  {
+    std::lock_guard<std::mutex> lock(b.mutex);
+    for (auto &ring : b.rings)
+      rings.push_back(ring.get());
+  }
+  batch->clear();
+  texts->clear();
+  for (ThreadRing *ring : rings) {
+    RecordHeader header;
+    size_t offset = texts->size();
+    while (ring->queue.pop(&header, texts)) {
+      batch->push_back({header.time_ns, offset, header.length});
+      offset += header.length;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.rings.erase(std::remove_if(b.rings.begin(), b.rings.end(),
+                                 [](const std::unique_ptr<ThreadRing> &r) {
+                                   return r->orphaned.load(
+                                              std::memory_order_acquire) &&
+                                          r->queue.used() == 0;
+                                 }),
+                  b.rings.end());
+  }
+  if (batch->empty())
+    return false;
+
+  std::stable_sort(batch->begin(), batch->end(),
+                   [](const Entry &a, const Entry &c) {
+                     return a.time_ns < c.time_ns;
+                   });
+  out->clear();
+  for (const Entry &entry : *batch)
+    out->append(*texts, entry.offset, entry.length);
+  writeAll(b.config.fd, out->data(), out->size());
+  b.written.fetch_add(batch->size(), std::memory_order_relaxed);
+  return true;
+}
+
+// while messages keep coming the writer drains on this period, so callers
+// do not pay a futex wake per message
+constexpr timespec kNapWait = {0, 2000000};
+// the timed wait is only a fallback; the first message wakes the writer
+constexpr timespec kIdleWait = {0, 100000000};
+
+void wakeWriter(Backend *b) {
+  b->wake.fetch_add(1, std::memory_order_release);
+  syscall(SYS_futex, &b->wake, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+void writerLoop() {
+  Backend &b = backend();
+  std::vector<Entry> batch;
+  std::string texts;
+  std::string out;
+  while (b.running.load(std::memory_order_acquire)) {
+    const uint32_t wake = b.wake.load(std::memory_order_acquire);
+    if (drain(&batch, &texts, &out)) {
+      // a caller filling its ring past half may miss this store and not
+      // wake us; the nap is short enough for that
+      b.state.store(kNapping, std::memory_order_seq_cst);
+      if (b.running.load(std::memory_order_acquire))
+        syscall(SYS_futex, &b.wake, FUTEX_WAIT_PRIVATE, wake, &kNapWait,
+                nullptr, 0);
+      b.state.store(kAwake, std::memory_order_relaxed);
+      continue;
+    }
+    b.state.store(kIdle, std::memory_order_seq_cst);
+    // pairs with the fence in ~Message(): either this drain sees the
+    // record or the caller sees kIdle and bumps |wake|
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (b.running.load(std::memory_order_acquire) &&
+        !drain(&batch, &texts, &out))
+      syscall(SYS_futex, &b.wake, FUTEX_WAIT_PRIVATE, wake, &kIdleWait,
+              nullptr, 0);
+    b.state.store(kAwake, std::memory_order_relaxed);
+  }
+}
+
+const char *prefix(Level level) {
+  switch (level) {
+  case Level::kError:
+    return "Error: ";
+  case Level::kWarning:
+    return "Warning: ";
+  case Level::kVerbose:
+    return "F: ";
+  }
+  return "";
+}
+
+} // namespace
+
+void start(const Config &config) {
+  static std::once_flag at_exit;
+  std::call_once(at_exit, [] { std::atexit(&stop); });
+  stop();
+  Backend &b = backend();
+  b.config = config;
+  b.config.ring_records = std::max<size_t>(b.config.ring_records, 2);
+  b.running.store(true, std::memory_order_release);
+  b.writer = std::thread(&writerLoop);
+}
+
+void stop() {
+  Backend &b = backend();
+  if (!b.running.exchange(false, std::memory_order_acq_rel))
+    return;
+  wakeWriter(&b);
+  b.writer.join();
+  std::vector<Entry> batch;
+  std::string texts;
+  std::string out;
+  drain(&batch, &texts, &out);
+}
+
+bool running() {
+  return backend().running.load(std::memory_order_acquire);
+}
+
+const Config &config() { return backend().config; }
+
+Stats stats() {
+  Backend &b = backend();
+  Stats s;
+  s.written = b.written.load(std::memory_order_relaxed);
+  s.dropped = b.dropped.load(std::memory_order_relaxed);
+  s.truncated = b.truncated.load(std::memory_order_relaxed);
+  return s;
+}
+
+void MessageStream::reset() {
+  buffer_.reset();
+  stream_.clear();
+  stream_.flags(std::ios_base::dec | std::ios_base::skipws);
+  stream_.precision(6);
+  stream_.width(0);
+  stream_.fill(' ');
+}
+
+const char *MessageStream::finish(size_t *length) {
+  *length = buffer_.size() + 1;
+  text_[buffer_.size()] = '\n';
+  return text_;
+}
+
+Message::Message(Level level, const char *file, int line) {
+  thread_local MessageStream stream;
+  if (stream.busy) {
+    nested_.emplace();
+    stream_ = &*nested_;
+  } else {
+    stream_ = &stream;
+    stream.reset();
+  }
+  stream_->busy = true;
+  std::ostream &o = stream_->stream();
+  o << prefix(level);
+  if (level == Level::kVerbose)
+    o << file << 'L' << line << ": ";
+}
+
+Message::~Message() {
+  Backend &b = backend();
+  if (stream_->truncated())
+    b.truncated.fetch_add(1, std::memory_order_relaxed);
+  size_t length = 0;
+  const char *text = stream_->finish(&length);
+  stream_->busy = false;
+
+  ThreadRing *ring = nullptr;
+  if (b.running.load(std::memory_order_acquire))
+    ring = threadRing();
+  if (!ring) {
+    writeAll(b.config.fd, text, length);
+    b.written.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const int64_t time_ns = monotonicNowNs();
+  RecordRing &queue = ring->queue;
+  bool woke = false;
+  while (!queue.push(time_ns, text, length)) {
+    if (b.config.overflow == OverflowPolicy::kDrop ||
+        !b.running.load(std::memory_order_acquire)) {
+      b.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (!woke) {
+      wakeWriter(&b);
+      woke = true;
+    }
+    const timespec wait = {0, 50000};
+    nanosleep(&wait, nullptr);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // one caller wakes an idle writer; a napping one is woken only when a
+  // ring crosses half full, and otherwise picks the record up after its nap
+  int state = b.state.load(std::memory_order_relaxed);
+  if (state == kIdle) {
+    if (b.state.compare_exchange_strong(state, kAwake,
+                                        std::memory_order_relaxed))
+      wakeWriter(&b);
+    return;
+  }
+  if (state == kNapping) {
+    const size_t used = queue.used();
+    const size_t half = queue.capacity() / 2;
+    if (used >= half && used - footprint(length) < half)
+      wakeWriter(&b);
+  }
+}
+
+} // namespace Logging
@@ -1,19 +1,149 @@
 #ifndef BASE_LOGGING_H_
 #define BASE_LOGGING_H_
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <streambuf>
 #include <vector>
 
-// #define __FILENAME__                                                           \
-//   (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
+// Stream-style logging:
+//
+//   LOG_E << "cannot open " << path;
+//   VLOG(1) << "uploaded " << bytes << " bytes";
+//
+// A message is formatted into a fixed buffer on the caller's stack. After
+// Logging::start() it is copied as one record, only as long as the text,
+// into a lock-free ring owned by the calling thread, and a background
+// thread writes the rings out every few milliseconds while messages keep
+// coming; the caller takes no lock, does no I/O, does not allocate and
+// does not usually wake the writer. Before start() and after stop()
+// messages are written synchronously.
+//
+// VLOG(v) is compiled out when v > LOG_MAX_VERBOSITY and costs one relaxed
+// load when v > Logging::verbosity().
 
-struct LOG_t {
-  ~LOG_t() { std::cerr << std::endl; }
+#ifndef LOG_MAX_VERBOSITY
+#define LOG_MAX_VERBOSITY 2
+#endif
+
+namespace Logging {
+
+enum class Level : uint8_t { kError, kWarning, kVerbose };
+
+enum class OverflowPolicy {
+  kDrop,  // a full ring drops the new message and counts it
+  kBlock, // the caller waits for the writer thread
+};
+
+struct Config {
+  int fd = 2;
+  // ring size per thread, in full-length messages; shorter ones pack
+  // tighter
+  size_t ring_records = 1024;
+  OverflowPolicy overflow = OverflowPolicy::kDrop;
+};
+
+struct Stats {
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  uint64_t truncated = 0;
 };
+
+// longer messages are cut (and counted)
+constexpr size_t kMaxMessage = 240;
+
+// also registers stop() with atexit
+void start(const Config &config = {});
+// writes out what is queued and joins the writer thread
+void stop();
+bool running();
+// what the last start() got
+const Config &config();
+Stats stats();
+
+extern std::atomic<int> g_verbosity;
+inline int verbosity() { return g_verbosity.load(std::memory_order_relaxed); }
+inline void setVerbosity(int v) {
+  g_verbosity.store(v, std::memory_order_relaxed);
+}
+
+// formatting state for one message at a time; each thread reuses one,
+// since constructing a std::ostream costs more than the formatting
+class MessageStream {
+public:
+  MessageStream() : buffer_(text_, text_ + kMaxMessage), stream_(&buffer_) {}
+  MessageStream(const MessageStream &) = delete;
+  MessageStream &operator=(const MessageStream &) = delete;
+
+  // empties the buffer and restores the default formatting
+  void reset();
+  std::ostream &stream() { return stream_; }
+  // the message with a newline appended
+  const char *finish(size_t *length);
+  bool truncated() const { return buffer_.truncated(); }
+
+  bool busy = false;
+
+private:
+  // writes into |text_|, counting what does not fit
+  class Buffer : public std::streambuf {
+  public:
+    Buffer(char *begin, char *end) { setp(begin, end); }
+    void reset() {
+      setp(pbase(), epptr());
+      truncated_ = false;
+    }
+    size_t size() const { return pptr() - pbase(); }
+    bool truncated() const { return truncated_; }
+
+  protected:
+    int_type overflow(int_type c) override {
+      truncated_ = true;
+      return traits_type::not_eof(c);
+    }
+
+  private:
+    bool truncated_ = false;
+  };
+
+  char text_[kMaxMessage + 1]; // room for the newline
+  Buffer buffer_;
+  std::ostream stream_;
+};
+
+// one message; handed over to the backend when destroyed
+class Message {
+public:
+  Message(Level level, const char *file, int line);
+  ~Message();
+  Message(const Message &) = delete;
+  Message &operator=(const Message &) = delete;
+
+  std::ostream &stream() { return stream_->stream(); }
+
+private:
+  MessageStream *stream_;
+  // only for a message logged while formatting another one
+  std::optional<MessageStream> nested_;
+};
+
+// turns the stream expression into void for the ?: in the macros
+struct Voidify {
+  void operator&(std::ostream &) {}
+};
+
+} // namespace Logging
+
+#define LOG_MESSAGE_(level)                                                    \
+  Logging::Voidify() & Logging::Message(level, __FILE__, __LINE__).stream()
 #define VLOG(_verbose)                                                         \
-  (LOG_t(), std::cerr << "F: " << __FILE__ << 'L' << __LINE__ << ": ")
-#define LOG_E (LOG_t(), std::cerr << "Error: ")
-#define LOG_W (LOG_t(), std::cerr << "Warning: ")
+  ((_verbose) > LOG_MAX_VERBOSITY || (_verbose) > Logging::verbosity())        \
+      ? (void)0                                                                \
+      : LOG_MESSAGE_(Logging::Level::kVerbose)
+#define LOG_E LOG_MESSAGE_(Logging::Level::kError)
+#define LOG_W LOG_MESSAGE_(Logging::Level::kWarning)
 
 template <typename T>
 static std::ostream &operator<<(std::ostream &o, const std::vector<T> &v) {
@@ -0,0 +1,147 @@
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/trace.h"
+
+namespace Trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+struct Event {
+  const char *name;
+  int64_t begin_ns;
+  int64_t duration_ns;
+  uint32_t tid;
+};
+
+struct Ring {
+  std::vector<Event> events;
+  std::vector<int64_t> frames;
+  std::atomic<uint64_t> event_head{0};
+  std::atomic<uint64_t> frame_head{0};
+  int64_t origin_ns = 0;
+} g_ring;
+
+uint32_t currentTid() {
+  thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+  return tid;
+}
+
+// oldest-first view of the valid part of a ring
+template <typename T>
+std::vector<T> snapshot(const std::vector<T> &ring, uint64_t head) {
+  std::vector<T> out;
+  const uint64_t n = std::min<uint64_t>(head, ring.size());
+  out.reserve(n);
+  for (uint64_t i = head - n; i < head; ++i)
+    out.push_back(ring[i % ring.size()]);
+  return out;
+}
+
+double percentile(const std::vector<int64_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  const size_t i = std::min(sorted.size() - 1,
+                            static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+  return sorted[i] / 1e6;
+}
+
+} // namespace
+
+void start(size_t capacity) {
+  if (capacity == 0)
+    return;
+  g_ring.events.assign(capacity, Event{});
+  g_ring.frames.assign(capacity, 0);
+  g_ring.event_head = 0;
+  g_ring.frame_head = 0;
+  g_ring.origin_ns = monotonicNowNs();
+  g_enabled.store(true, std::memory_order_release);
+}
+
+void stop() { g_enabled.store(false, std::memory_order_release); }
+
+void record(const char *name, int64_t begin_ns, int64_t end_ns) {
+  if (!enabled())
+    return;
+  const uint64_t i = g_ring.event_head.fetch_add(1, std::memory_order_relaxed);
+  g_ring.events[i % g_ring.events.size()] =
+      Event{name, begin_ns, end_ns - begin_ns, currentTid()};
+}
+
+void recordFrame(int64_t begin_ns, int64_t end_ns) {
+  if (!enabled())
+    return;
+  record("frame", begin_ns, end_ns);
+  const uint64_t i = g_ring.frame_head.fetch_add(1, std::memory_order_relaxed);
+  g_ring.frames[i % g_ring.frames.size()] = end_ns - begin_ns;
+}
+
+bool writeChromeTrace(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    LOG_E << "fopen " << path;
+    return false;
+  }
+  const auto events = snapshot(g_ring.events, g_ring.event_head.load());
+  const pid_t pid = getpid();
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (size_t i = 0; i < events.size(); ++i) {
+    const Event &e = events[i];
+    fprintf(fp,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%d,\"tid\":%u}%s\n",
+            e.name, (e.begin_ns - g_ring.origin_ns) / 1e3,
+            e.duration_ns / 1e3, pid, e.tid,
+            i + 1 < events.size() ? "," : "");
+  }
+  fprintf(fp, "]}\n");
+  const bool ok = !ferror(fp);
+  fclose(fp);
+  return ok;
+}
+
+void printSummary(std::ostream &o) {
+  auto frames = snapshot(g_ring.frames, g_ring.frame_head.load());
+  std::sort(frames.begin(), frames.end());
+  o << "trace: frames=" << frames.size()
+    << " p50=" << percentile(frames, 0.50)
+    << "ms p95=" << percentile(frames, 0.95)
+    << "ms p99=" << percentile(frames, 0.99) << "ms" << std::endl;
+
+  // power-of-two microsecond buckets: bucket b holds frames < 2^b us
+  constexpr int kBuckets = 24;
+  int histogram[kBuckets] = {};
+  for (int64_t f : frames) {
+    int b = 0;
+    while (b + 1 < kBuckets && (int64_t{1} << b) * 1000 <= f)
+      ++b;
+    ++histogram[b];
+  }
+  for (int b = 0; b < kBuckets; ++b) {
+    if (histogram[b])
+      o << "  <" << (1 << b) << "us: " << histogram[b] << std::endl;
+  }
+
+  std::map<std::string, std::pair<int64_t, int64_t>> scopes; // sum, count
+  for (const Event &e : snapshot(g_ring.events, g_ring.event_head.load())) {
+    auto &s = scopes[e.name];
+    s.first += e.duration_ns;
+    ++s.second;
+  }
+  for (const auto &[name, s] : scopes) {
+    o << "  " << name << ": n=" << s.second
+      << " avg=" << s.first / 1e3 / s.second << "us" << std::endl;
+  }
+}
+
+} // namespace Trace
@@ -0,0 +1,67 @@
+#ifndef BASE_TRACE_H_
+#define BASE_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "base/clock.h"
+
+// Scoped-timer tracing into a preallocated ring buffer.
+//
+//   Trace::start(1 << 16);
+//   { TRACE_SCOPE("draw"); ... }
+//   Trace::writeChromeTrace("trace.json");
+//
+// Names must be string literals (only the pointer is stored). When tracing
+// is stopped a scope costs one relaxed load; building with -DDISABLE_TRACE
+// removes it entirely.
+namespace Trace {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+// allocates the ring buffers; nothing is allocated while recording
+void start(size_t capacity);
+void stop();
+
+void record(const char *name, int64_t begin_ns, int64_t end_ns);
+// a whole frame; kept separately for the frame-time percentiles
+void recordFrame(int64_t begin_ns, int64_t end_ns);
+
+bool writeChromeTrace(const char *path);
+// p50/p95/p99, a frame-time histogram and per-scope averages
+void printSummary(std::ostream &o);
+
+class Scope {
+public:
+  explicit Scope(const char *name)
+      : name_(name), begin_ns_(enabled() ? monotonicNowNs() : 0) {}
+  ~Scope() {
+    if (begin_ns_)
+      record(name_, begin_ns_, monotonicNowNs());
+  }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  const char *name_;
+  int64_t begin_ns_;
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#ifndef DISABLE_TRACE
+#define TRACE_SCOPE(name)                                                      \
+  Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)                                                      \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#endif // BASE_TRACE_H_
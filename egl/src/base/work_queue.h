@@ -0,0 +1,64 @@
+#ifndef BASE_WORK_QUEUE_H_
+#define BASE_WORK_QUEUE_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// One deque per worker: a worker takes its own items from the back (the
+// most recently pushed, still warm) and, when it runs dry, steals from the
+// front of the others, starting after itself so that thieves spread out.
+// Items are coarse jobs, so a mutex per deque is cheap; workers only meet
+// on one when stealing.
+template <typename T> class WorkStealingQueue {
+public:
+  explicit WorkStealingQueue(int workers) {
+    for (int i = 0; i < workers; ++i)
+      deques_.push_back(std::make_unique<Deque>());
+  }
+
+  int workers() const { return deques_.size(); }
+
+  void push(int worker, T item) {
+    Deque &d = *deques_[worker];
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.items.push_back(std::move(item));
+  }
+
+  // false once every deque is empty. |stolen| tells where the item came
+  // from.
+  bool pop(int worker, T *item, bool *stolen) {
+    {
+      Deque &own = *deques_[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.items.empty()) {
+        *item = std::move(own.items.back());
+        own.items.pop_back();
+        *stolen = false;
+        return true;
+      }
+    }
+    for (size_t i = 1; i < deques_.size(); ++i) {
+      Deque &victim = *deques_[(worker + i) % deques_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.items.empty()) {
+        *item = std::move(victim.items.front());
+        victim.items.pop_front();
+        *stolen = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Deque {
+    std::mutex mutex;
+    std::deque<T> items;
+  };
+  std::vector<std::unique_ptr<Deque>> deques_;
+};
+
+#endif // BASE_WORK_QUEUE_H_
@@ -0,0 +1,133 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "base/frame_arena.h"
+#include "bench/bench.h"
+#include "gles2/program_cache.h"
+#include "gles2/sprite_batch.h"
+#include "gles2/state.h"
+#include "gles2/texture.h"
+#include "gles2/texture_atlas.h"
+
+namespace Bench {
+
+namespace {
+
+struct Image {
+  int width, height;
+  std::vector<unsigned char> pixels;
+};
+
+struct Placed {
+  float x, y, w, h;
+  int image;
+};
+
+} // namespace
+
+bool atlas(const Options &options) {
+  const int count = options.count > 0 ? options.count : 1000;
+  const int frames = options.iterations;
+
+  srand(1);
+  std::vector<Image> images(count);
+  for (Image &image : images) {
+    image.width = 8 + rand() % 57;
+    image.height = 8 + rand() % 57;
+    image.pixels.assign(image.width * image.height * 4, 0xff);
+    for (size_t i = 0; i < image.pixels.size(); i += 4)
+      image.pixels[i + rand() % 3] = rand() & 0xff;
+  }
+  // each image drawn a few times, in random order
+  std::vector<Placed> placed(count * 4);
+  for (Placed &p : placed) {
+    p.image = rand() % count;
+    p.x = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    p.y = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    p.w = images[p.image].width / 512.0f;
+    p.h = images[p.image].height / 512.0f;
+  }
+
+  GlES2ProgramCache cache;
+  auto program = cache.get(GlES2SpriteBatch::kVertexShader,
+                           GlES2SpriteBatch::kFragmentShader);
+  if (!program)
+    return false;
+  GlES2SpriteBatch batch;
+  if (!batch.initialize(program))
+    return false;
+
+  std::vector<GlES2Texture> textures;
+  const int64_t texture_ns = measureNs([&] {
+    for (const Image &image : images) {
+      textures.push_back(*GlES2Texture::create()); // unwrap
+      textures.back().allocate(image.width, image.height, GL_RGBA);
+      textures.back().update(image.pixels.data());
+    }
+    glFinish();
+  });
+
+  GlES2TextureAtlas atlas;
+  GlES2TextureAtlas::Config config;
+  config.max_pages = 16;
+  if (!atlas.initialize(config))
+    return false;
+  std::vector<GlES2TextureAtlas::Handle> handles;
+  const int64_t atlas_ns = measureNs([&] {
+    for (const Image &image : images)
+      handles.push_back(
+          atlas.insert(image.pixels.data(), image.width, image.height));
+    glFinish();
+  });
+  const GlES2TextureAtlas::Stats &stats = atlas.stats();
+
+  std::cout << "atlas: " << count << " images, " << placed.size()
+            << " sprites, " << frames << " frames" << std::endl;
+  std::cout << "  upload: " << texture_ns / 1e6 << " ms as textures, "
+            << atlas_ns / 1e6 << " ms into " << stats.pages << " pages of "
+            << config.page_size << "^2" << std::endl;
+  std::cout << "  packing: " << stats.efficiency() * 100
+            << "% of page texels hold images, "
+            << 100.0 * stats.allocated_area / stats.page_area
+            << "% allocated with padding" << std::endl;
+
+  GlES2State &gl = GlES2State::current();
+  auto run = [&](const char *label, bool use_atlas, bool sorted) {
+    batch.setSortByTexture(sorted);
+    batch.resetStats();
+    gl.resetCounters();
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        batch.begin();
+        for (const Placed &p : placed) {
+          if (use_atlas) {
+            const GlES2TextureAtlas::Region &r = atlas.region(handles[p.image]);
+            batch.draw({p.x, p.y, p.x + p.w, p.y - p.h, r.u0, r.v0, r.u1,
+                        r.v1, 0xffffffff, r.texture});
+          } else {
+            batch.draw({p.x, p.y, p.x + p.w, p.y - p.h, 0, 0, 1, 1,
+                        0xffffffff, textures[p.image].texture()});
+          }
+        }
+        batch.end();
+        FrameArena::current().reset();
+      }
+      glFinish();
+    });
+    std::cout << "  " << label << ": " << ns / 1e6 / frames << " ms/frame, "
+              << batch.stats().draw_calls / frames << " draws/frame, "
+              << gl.counters().texture_binds / frames << " binds/frame"
+              << std::endl;
+  };
+  run("textures, in order", false, false);
+  run("textures, sorted", false, true);
+  run("atlas, in order", true, false);
+  run("atlas, sorted", true, true);
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,63 @@
+#include "base/logging.h"
+#include "bench/bench.h"
+
+namespace Bench {
+
+namespace {
+
+struct Entry {
+  const char *name;
+  const char *description;
+  bool (*fn)(const Options &);
+};
+
+const Entry kEntries[] = {
+    {"atlas", "small images as textures vs packed atlas pages (default 1k)",
+     &atlas},
+    {"buffer", "client arrays vs static VBO vs stream ring, per draw",
+     &buffer},
+    {"commands", "recorded draws (default 2k), replayed in order vs sorted",
+     &commands},
+    {"culling", "frustum culling (default 100k), spheres vs BVH on 1 and N "
+                "threads",
+     &culling},
+    {"entities", "pseudo-instanced cubes (default 10k) vs one draw per entity",
+     &entities},
+    {"etc1", "RGBA upload vs mmapped KTX ETC1 vs CPU decode (default 1024^2)",
+     &etc1},
+    {"logging", "caller cost of cerr vs sync vs async logging, 1 and 4 threads",
+     &logging},
+    {"math", "batched mat4/quat kernels vs the scalar path (default 10k)",
+     &math},
+    {"mesh", "mesh ACMR and load time, shuffled vs optimized (default 512^2)",
+     &mesh},
+    {"residency", "texture manager under memory budgets, hot + sliding set",
+     &residency},
+    {"shader", "program compile vs in-process cache vs on-disk binaries",
+     &shader},
+    {"sprites", "sprite batcher stress (default 10k sprites) vs per-quad draws",
+     &sprites},
+    {"text", "SDF glyph rasterize, run layout and cached draws, HUD label, LRU",
+     &text},
+    {"texture", "720p/1080p full respecification vs sub-image updates",
+     &texture},
+    {"yuv", "1080p RGBA to I420 conversion, SIMD vs scalar", &yuv},
+};
+
+} // namespace
+
+bool run(const std::string &name, const Options &options) {
+  for (const Entry &e : kEntries) {
+    if (name == e.name)
+      return e.fn(options);
+  }
+  LOG_E << "unknown benchmark: " << name;
+  return false;
+}
+
+void list(std::ostream &o) {
+  for (const Entry &e : kEntries)
+    o << "  " << e.name << ": " << e.description << std::endl;
+}
+
+} // namespace Bench
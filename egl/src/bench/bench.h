@@ -0,0 +1,50 @@
+#ifndef EGL_SRC_BENCH_BENCH_H_
+#define EGL_SRC_BENCH_BENCH_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// micro-benchmarks run by app-main --bench=NAME. The GL ones expect a
+// current context (run them with --headless for stable numbers).
+namespace Bench {
+
+struct Options {
+  // workload size (objects, texels...); 0 picks the benchmark's default
+  int count = 0;
+  int iterations = 100;
+};
+
+bool run(const std::string &name, const Options &options);
+void list(std::ostream &o);
+
+// wall time of |fn| in nanoseconds
+template <typename F> int64_t measureNs(F &&fn);
+
+bool atlas(const Options &options);
+bool buffer(const Options &options);
+bool commands(const Options &options);
+bool culling(const Options &options);
+bool entities(const Options &options);
+bool etc1(const Options &options);
+bool logging(const Options &options);
+bool math(const Options &options);
+bool mesh(const Options &options);
+bool residency(const Options &options);
+bool shader(const Options &options);
+bool sprites(const Options &options);
+bool text(const Options &options);
+bool texture(const Options &options);
+bool yuv(const Options &options);
+
+} // namespace Bench
+
+#include "base/clock.h"
+
+template <typename F> int64_t Bench::measureNs(F &&fn) {
+  const int64_t begin = monotonicNowNs();
+  fn();
+  return monotonicNowNs() - begin;
+}
+
+#endif // EGL_SRC_BENCH_BENCH_H_
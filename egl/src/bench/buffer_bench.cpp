@@ -0,0 +1,126 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "bench/bench.h"
+#include "gles2/buffer.h"
+#include "gles2/shader.h"
+#include "gles2/state.h"
+
+namespace Bench {
+
+namespace {
+
+const char *kVShader = R"(
+    attribute vec4 a_position;
+    void main() {
+        gl_Position = a_position;
+    }
+)";
+
+const char *kFShader = R"(
+    precision mediump float;
+    void main() {
+        gl_FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+    }
+)";
+
+constexpr int kFloatsPerQuad = 8;
+
+void report(const char *label, int64_t submit_ns, int64_t total_ns,
+            int64_t draws) {
+  std::cout << "  " << label << ": submit " << submit_ns / draws
+            << " ns/draw, with glFinish " << total_ns / draws << " ns/draw"
+            << std::endl;
+}
+
+} // namespace
+
+bool buffer(const Options &options) {
+  const int count = options.count > 0 ? options.count : 10000;
+
+  GlES2ShaderProgram shader;
+  if (!shader.initialize(kVShader, kFShader))
+    return false;
+  GlES2State &gl = GlES2State::current();
+  gl.useProgram(shader.program());
+  const GLint a_position = shader.attribute("a_position");
+  gl.enableVertexAttribArray(a_position);
+
+  // tiny quads scattered over the viewport
+  std::vector<GLfloat> quads(count * kFloatsPerQuad);
+  srand(1);
+  for (int i = 0; i < count; ++i) {
+    const float x = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    const float y = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    const float s = 0.01f;
+    const GLfloat q[] = {x, y + s, x, y, x + s, y + s, x + s, y};
+    std::copy(q, q + kFloatsPerQuad, quads.begin() + i * kFloatsPerQuad);
+  }
+  const GLsizeiptr quad_bytes = kFloatsPerQuad * sizeof(GLfloat);
+
+  GlES2Buffer static_buffer;
+  if (!static_buffer.initialize(quads.size() * sizeof(GLfloat), quads.data()))
+    return false;
+  GlES2RingBuffer ring;
+  if (!ring.initialize(quads.size() * sizeof(GLfloat)))
+    return false;
+
+  const int64_t draws = int64_t{count} * options.iterations;
+  std::cout << "buffer: " << count << " quads x " << options.iterations
+            << " frames" << std::endl;
+
+  auto runFrames = [&](auto &&draw_all) {
+    int64_t submit = 0;
+    const int64_t total = measureNs([&] {
+      for (int f = 0; f < options.iterations; ++f) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        submit += measureNs(draw_all);
+        glFinish();
+      }
+    });
+    return std::make_pair(submit, total);
+  };
+
+  gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+  auto client = runFrames([&] {
+    for (int i = 0; i < count; ++i) {
+      glVertexAttribPointer(a_position, 2, GL_FLOAT, GL_FALSE, 0,
+                            quads.data() + i * kFloatsPerQuad);
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+  });
+  report("client arrays", client.first, client.second, draws);
+
+  auto stat = runFrames([&] {
+    static_buffer.bind();
+    glVertexAttribPointer(a_position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    for (int i = 0; i < count; ++i)
+      glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+  });
+  report("static VBO", stat.first, stat.second, draws);
+
+  // per-frame data: every quad is rewritten into the ring each frame
+  std::vector<GLintptr> offsets(count);
+  auto stream = runFrames([&] {
+    ring.reset();
+    for (int i = 0; i < count; ++i)
+      offsets[i] = ring.push(quads.data() + i * kFloatsPerQuad, quad_bytes);
+    ring.flush();
+    for (int i = 0; i < count; ++i) {
+      glVertexAttribPointer(a_position, 2, GL_FLOAT, GL_FALSE, 0,
+                            reinterpret_cast<void *>(offsets[i]));
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+  });
+  report("stream ring", stream.first, stream.second, draws);
+  std::cout << "  stream ring orphaned " << ring.orphanCount() << " times"
+            << std::endl;
+
+  gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,142 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "bench/bench.h"
+#include "gles2/buffer.h"
+#include "gles2/command_buffer.h"
+#include "gles2/program_cache.h"
+#include "gles2/state.h"
+#include "gles2/texture.h"
+
+namespace Bench {
+
+namespace {
+
+constexpr int kPrograms = 4;
+constexpr int kTextures = 8;
+
+const char *kVertexShader = R"(
+        attribute vec2 a_position;
+        uniform vec4 u_rect;
+        varying vec2 v_uv;
+        void main() {
+            v_uv = a_position;
+            gl_Position = vec4(u_rect.xy + a_position * u_rect.zw, 0.0, 1.0);
+        }
+    )";
+
+// tinted differently per program
+std::string fragmentShader(int variant) {
+  return R"(
+        precision mediump float;
+        uniform sampler2D u_texture;
+        varying vec2 v_uv;
+        void main() {
+            gl_FragColor = texture2D(u_texture, v_uv) * vec4()" +
+         std::to_string(0.5 + variant * 0.1) + R"();
+        }
+    )";
+}
+
+struct Draw {
+  int program;
+  int texture;
+  float x, y;
+};
+
+} // namespace
+
+bool commands(const Options &options) {
+  const int count = options.count > 0 ? options.count : 2000;
+  const int frames = options.iterations;
+
+  GlES2ProgramCache cache;
+  std::vector<std::shared_ptr<GlES2ShaderProgram>> programs;
+  for (int p = 0; p < kPrograms; ++p) {
+    programs.push_back(cache.get(kVertexShader, fragmentShader(p).c_str()));
+    if (!programs.back())
+      return false;
+  }
+  std::vector<GlES2Texture> textures;
+  for (int t = 0; t < kTextures; ++t) {
+    textures.push_back(*GlES2Texture::create()); // unwrap
+    std::vector<unsigned char> pixels(16 * 16 * 4, 0xff);
+    for (size_t i = 0; i < pixels.size(); i += 4)
+      pixels[i + t % 3] = 0x20 * t;
+    textures.back().allocate(16, 16, GL_RGBA);
+    textures.back().update(pixels.data());
+  }
+  const GLfloat corners[] = {0, 0, 0, 1, 1, 0, 1, 1};
+  GlES2Buffer quad;
+  if (!quad.initialize(sizeof(corners), corners))
+    return false;
+
+  // unrelated draws, in an order that switches state at almost every one
+  std::vector<Draw> draws(count);
+  srand(1);
+  for (Draw &d : draws) {
+    d.program = rand() % kPrograms;
+    d.texture = rand() % kTextures;
+    d.x = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    d.y = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+  }
+
+  GlES2CommandBuffer buffer;
+  auto record = [&] {
+    buffer.clear();
+    for (const Draw &d : draws) {
+      const GlES2ShaderProgram &program = *programs[d.program];
+      const GLuint texture = textures[d.texture].texture();
+      const GLint a_position = program.attribute("a_position");
+      buffer.useProgram(program.program());
+      buffer.uniform1i(program.uniform("u_texture"), 0);
+      buffer.bindTexture(0, texture);
+      buffer.bindBuffer(GL_ARRAY_BUFFER, quad.buffer());
+      buffer.enableVertexAttribArray(a_position);
+      buffer.vertexAttribPointer(a_position, 2, GL_FLOAT, GL_FALSE, 0, 0);
+      GLfloat *rect = buffer.uniform4fv(program.uniform("u_rect"), 1);
+      rect[0] = d.x;
+      rect[1] = d.y;
+      rect[2] = rect[3] = 0.05f;
+      buffer.drawArrays(GlES2CommandBuffer::sortKey(0, program.program(),
+                                                    texture, 0),
+                        GL_TRIANGLE_STRIP, 0, 4);
+    }
+  };
+
+  std::cout << "commands: " << count << " draws over " << kPrograms
+            << " programs and " << kTextures << " textures, " << frames
+            << " frames" << std::endl;
+  GlES2State &gl = GlES2State::current();
+  for (bool sorted : {false, true}) {
+    int64_t record_ns = 0, sort_ns = 0, replay_ns = 0;
+    buffer.resetStats();
+    gl.resetCounters();
+    for (int f = 0; f < frames; ++f) {
+      record_ns += measureNs(record);
+      if (sorted)
+        sort_ns += measureNs([&] { buffer.sort(); });
+      glClear(GL_COLOR_BUFFER_BIT);
+      replay_ns += measureNs([&] {
+        buffer.replay();
+        glFinish();
+      });
+    }
+    const GlES2CommandBuffer::Stats &stats = buffer.stats();
+    std::cout << "  " << (sorted ? "sorted by key" : "recording order")
+              << ": record " << record_ns / 1e6 / frames << " ms, sort "
+              << sort_ns / 1e6 / frames << " ms, replay "
+              << replay_ns / 1e6 / frames << " ms/frame; switches/frame: "
+              << stats.program_switches / frames << " programs, "
+              << stats.texture_switches / frames << " textures; state calls "
+              << gl.counters().issued / frames << " issued, "
+              << gl.counters().elided / frames << " elided" << std::endl;
+  }
+  return true;
+}
+
+} // namespace Bench
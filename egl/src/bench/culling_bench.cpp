@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.h"
+#include "math/batch.h"
+#include "math/frustum.h"
+#include "math/mat4.h"
+#include "scene/entity_bvh.h"
+
+namespace Bench {
+
+namespace {
+
+constexpr float kVolume = 200; // edge of the cube the entities fill
+
+// the reference: every bounding sphere against every plane
+size_t cullSpheres(const Math::Frustum &frustum, const EntityList &entities,
+                   const std::vector<float> &radii,
+                   std::vector<uint8_t> *visible) {
+  const size_t n = entities.size();
+  visible->assign(n, 0);
+  size_t count = 0;
+  for (size_t slot = 0; slot < n; ++slot) {
+    const float *p = entities.positions() + slot * 3;
+    const float r = radii[entities.shapes()[slot]];
+    bool inside = true;
+    for (int i = 0; i < Math::Frustum::kPlaneCount && inside; ++i) {
+      const float *n = frustum.planes[i];
+      inside = n[0] * p[0] + n[1] * p[1] + n[2] * p[2] + n[3] >= -r;
+    }
+    (*visible)[slot] = inside;
+    count += inside;
+  }
+  return count;
+}
+
+// a camera at the center of the volume turning about y, seeing ~1/8 of it
+Math::Frustum frustumAt(int frame) {
+  const float yaw = frame * 0.02f;
+  const Math::Mat4 view_projection =
+      Math::Mat4::perspective(Math::radians(60), 16.0f / 9, 0.1f,
+                              kVolume / 2) *
+      Math::Mat4::lookAt(Math::Vec3(0, 0, 0),
+                         Math::Vec3(std::cos(yaw), 0, std::sin(yaw)),
+                         Math::Vec3(0, 1, 0));
+  return Math::Frustum::fromViewProjection(view_projection.data());
+}
+
+} // namespace
+
+bool culling(const Options &options) {
+  const size_t count = options.count > 0 ? options.count : 100000;
+  const int frames = options.iterations;
+  const int threads =
+      std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+
+  ShapeList shapes;
+  shapes.push(createCubeShape(0.5f, {}));
+  shapes.push(createCubeShape(1.0f, {}));
+  std::vector<float> radii = {shapes.radius(0), shapes.radius(1)};
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> coordinate(-kVolume / 2,
+                                                   kVolume / 2);
+  EntityList entities;
+  for (size_t i = 0; i < count; ++i) {
+    entities.add(i % 2, coordinate(random), coordinate(random),
+                 coordinate(random));
+  }
+  entities.sort();
+
+  // |count| / |divisor| of the entities drift every frame, one unit in a
+  // random direction
+  std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+  std::uniform_real_distribution<float> step(-1, 1);
+  auto drift = [&](int divisor) {
+    for (size_t i = 0; i < count / divisor; ++i) {
+      const EntityList::Handle h = pick(random);
+      const float *p = entities.positions() + entities.slot(h) * 3;
+      entities.setPosition(h, p[0] + step(random), p[1] + step(random),
+                           p[2] + step(random));
+    }
+  };
+
+  std::cout << "culling: " << count << " entities, " << frames
+            << " frames, " << Math::simdPath() << " box tests" << std::endl;
+
+  std::vector<uint8_t> reference;
+  int64_t brute_ns = 0;
+  size_t brute_visible = 0;
+  for (int f = 0; f < frames; ++f) {
+    const Math::Frustum frustum = frustumAt(f);
+    brute_ns += measureNs([&] {
+      brute_visible += cullSpheres(frustum, entities, radii, &reference);
+    });
+  }
+  std::cout << "  spheres, every entity: " << brute_ns / 1e6 / frames
+            << " ms/frame, visible/frame " << brute_visible / frames
+            << std::endl;
+
+  // the same frames each run: the drift is replayed from the same seed.
+  // update() refits only what moved, so it costs in proportion to |divisor|
+  // and the tree pays off while the moves are few; past the linear
+  // fraction every sphere is tested instead.
+  const std::vector<float> start(entities.positions(),
+                                 entities.positions() + count * 3);
+  for (int divisor : {100, 10}) {
+    for (int run_threads : {1, threads}) {
+      for (uint32_t slot = 0; slot < count; ++slot) {
+        const float *p = &start[slot * 3];
+        entities.setPosition(entities.handle(slot), p[0], p[1], p[2]);
+      }
+      random.seed(2);
+      EntityBvh bvh;
+      bvh.setThreads(run_threads);
+      std::vector<uint8_t> visible;
+      int64_t update_ns = 0, cull_ns = 0;
+      size_t visible_total = 0, culled_total = 0, missed = 0;
+      uint64_t node_tests = 0;
+      int parallel = 0, linear = 0;
+      for (int f = 0; f < frames; ++f) {
+        // the first update() builds the tree, which is not what is compared
+        if (f > 0)
+          drift(divisor);
+        const int64_t ns =
+            measureNs([&] { bvh.update(&entities, shapes); });
+        if (f > 0)
+          update_ns += ns;
+        const Math::Frustum frustum = frustumAt(f);
+        EntityBvh::CullStats stats;
+        cull_ns += measureNs(
+            [&] { bvh.cull(frustum, entities, &visible, &stats); });
+        visible_total += stats.visible;
+        culled_total += stats.culled;
+        node_tests += stats.node_tests;
+        parallel += stats.threads > 1;
+        linear += stats.linear;
+        // the boxes are looser than the spheres, never tighter
+        cullSpheres(frustum, entities, radii, &reference);
+        for (size_t slot = 0; slot < count; ++slot)
+          missed += reference[slot] && !visible[slot];
+      }
+      const EntityBvh::Stats &stats = bvh.stats();
+      const double update_ms =
+          frames > 1 ? update_ns / 1e6 / (frames - 1) : 0;
+      const double cull_ms = cull_ns / 1e6 / frames;
+      std::cout << "  bvh, 1/" << divisor << " drifting, " << run_threads
+                << " thread(s): update " << update_ms << " ms/frame, cull "
+                << cull_ms << " ms/frame, together x"
+                << (update_ms + cull_ms) / (brute_ns / 1e6 / frames)
+                << " the spheres, visible/frame " << visible_total / frames
+                << ", culled/frame " << culled_total / frames
+                << ", node tests/frame " << node_tests / frames
+                << ", linear " << linear << "/" << frames << ", parallel "
+                << parallel << "/" << frames << ", " << stats.nodes
+                << " nodes, " << stats.builds << " builds, "
+                << stats.refits << " refits, area x" << stats.area_ratio
+                << ", missed " << missed << std::endl;
+      if (missed)
+        return false;
+    }
+  }
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,61 @@
+#include <iostream>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "bench/bench.h"
+#include "gles2/mesh_renderer.h"
+#include "gles2/program_cache.h"
+#include "scene/sample_scene.h"
+
+namespace Bench {
+
+bool entities(const Options &options) {
+  const int count = options.count > 0 ? options.count : 10000;
+  const int frames = options.iterations;
+
+  SampleScene scene;
+  scene.build(count);
+  GlES2ProgramCache cache;
+  GlES2MeshRenderer renderer;
+  if (!renderer.initialize(&cache, scene.shapes()))
+    return false;
+
+  EGLint width = 1, height = 1;
+  eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                  EGL_WIDTH, &width);
+  eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                  EGL_HEIGHT, &height);
+  glViewport(0, 0, width, height);
+
+  std::cout << "entities: " << count << " entities, "
+            << scene.shapes().size() << " shapes, " << frames << " frames"
+            << std::endl;
+  for (int batch : {renderer.batchCapacity(), 1}) {
+    renderer.setBatchSize(batch);
+    renderer.resetStats();
+    int64_t animate_ns = 0;
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        const double t = f / 60.0;
+        animate_ns += measureNs([&] { scene.animate(t); });
+        float view_projection[16];
+        scene.viewProjection(t, static_cast<float>(width) / height,
+                             view_projection);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.draw(view_projection, scene.entities());
+      }
+      glFinish();
+    });
+    const double ms = ns / 1e6 / frames;
+    std::cout << "  " << batch << " per draw: " << ms << " ms/frame ("
+              << animate_ns / 1e6 / frames << " ms animate), "
+              << count / (ms / 1e3) / 1e6 << " M entities/s, "
+              << renderer.stats().draw_calls / frames << " draws/frame, "
+              << renderer.stats().uniform_vectors / frames
+              << " uniform vec4/frame" << std::endl;
+  }
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,144 @@
+#include <GLES2/gl2.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench/bench.h"
+#include "gles2/etc1.h"
+#include "gles2/texture_loader.h"
+
+namespace Bench {
+
+namespace {
+
+// smooth gradients with some detail, roughly what photos give the encoder
+std::vector<uint8_t> testImage(int size) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(size) * size * 4);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      uint8_t *p = &rgba[(static_cast<size_t>(y) * size + x) * 4];
+      const float u = static_cast<float>(x) / size;
+      const float v = static_cast<float>(y) / size;
+      p[0] = 255 * u;
+      p[1] = 255 * v;
+      p[2] = 127 + 127 * std::sin(u * 40) * std::cos(v * 30);
+      p[3] = 0xff;
+    }
+  }
+  return rgba;
+}
+
+double psnr(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+  double sum = 0;
+  for (size_t i = 0; i < a.size(); i += 4) {
+    for (int c = 0; c < 3; ++c) {
+      const double d = a[i + c] - b[i + c];
+      sum += d * d;
+    }
+  }
+  const double mse = sum / (a.size() / 4 * 3);
+  return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99;
+}
+
+} // namespace
+
+bool etc1(const Options &options) {
+  const int size = options.count > 0 ? options.count : 1024;
+  const int iterations = std::max(1, options.iterations / 10);
+  const int threads = std::max(1u, std::thread::hardware_concurrency());
+  const std::vector<uint8_t> image = testImage(size);
+
+  std::vector<uint8_t> blocks;
+  const int64_t encode_ns = measureNs(
+      [&] { blocks = Etc1::encode(image.data(), size, size, threads); });
+  std::vector<uint8_t> decoded(image.size());
+  Etc1::decode({size, size, blocks.data(), blocks.size()}, decoded.data(),
+               threads);
+
+  // the files the loaders read
+  const std::string base = "/tmp/etc1_bench_" + std::to_string(getpid());
+  const std::string rgba_path = base + ".rgba";
+  const std::string ktx_path = base + ".ktx";
+  {
+    std::ofstream out(rgba_path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(image.data()), image.size());
+  }
+  if (!Etc1::writeKtx(ktx_path, {blocks}, size, size))
+    return false;
+
+  GlES2Texture texture = *GlES2Texture::create(); // unwrap
+  int64_t rgba_ns = 0;
+  std::vector<uint8_t> pixels(image.size());
+  for (int i = 0; i < iterations; ++i) {
+    rgba_ns += measureNs([&] {
+      std::ifstream in(rgba_path, std::ios::binary);
+      in.read(reinterpret_cast<char *>(pixels.data()), pixels.size());
+      texture.uploadLevel(0, size, size, GL_RGBA, pixels.data());
+      glFinish();
+    });
+  }
+
+  bool ok = true;
+  auto load = [&](const Etc1LoadOptions &load_options, Etc1LoadInfo *info) {
+    int64_t ns = 0;
+    for (int i = 0; i < iterations && ok; ++i) {
+      ns += measureNs([&] {
+        ok = loadEtc1Texture(ktx_path, &texture, info, load_options);
+        glFinish();
+      });
+    }
+    return ns;
+  };
+  Etc1LoadInfo compressed_info, decode1_info, decoded_info;
+  const int64_t compressed_ns = hasEtc1Support()
+                                    ? load({true, 0}, &compressed_info)
+                                    : 0;
+  const int64_t decode1_ns = load({false, 1}, &decode1_info);
+  // a single core has nothing to split over
+  const int64_t decode_ns =
+      threads > 1 ? load({false, threads}, &decoded_info) : 0;
+  unlink(rgba_path.c_str());
+  unlink(ktx_path.c_str());
+  if (!ok)
+    return false;
+
+  std::cout << "etc1: " << size << "x" << size << ", " << iterations
+            << " loads each" << std::endl;
+  std::cout << "  encode: " << encode_ns / 1e6 << " ms on " << threads
+            << " thread(s), psnr " << psnr(image, decoded) << " dB"
+            << std::endl;
+  auto report = [&](const char *label, int64_t ns, size_t file_bytes,
+                    size_t gpu_bytes) {
+    std::cout << "  " << label << ": " << ns / 1e6 / iterations
+              << " ms/load, file " << file_bytes / 1024 << " KiB, texture "
+              << gpu_bytes / 1024 << " KiB" << std::endl;
+  };
+  report("rgba read + glTexImage2D", rgba_ns, image.size(), image.size());
+  if (compressed_ns) {
+    report("ktx mmap + glCompressedTexImage2D", compressed_ns,
+           compressed_info.file_bytes, compressed_info.gpu_bytes);
+    std::cout << "  texture memory saved: "
+              << (image.size() - compressed_info.gpu_bytes) / 1024 << " KiB ("
+              << static_cast<double>(image.size()) / compressed_info.gpu_bytes
+              << "x smaller)" << std::endl;
+  } else {
+    std::cout << "  GL_OES_compressed_ETC1_RGB8_texture unavailable"
+              << std::endl;
+  }
+  report("ktx mmap + decode (1 thread)", decode1_ns, decode1_info.file_bytes,
+         decode1_info.gpu_bytes);
+  if (decode_ns) {
+    const std::string label =
+        "ktx mmap + decode (" + std::to_string(threads) + " threads)";
+    report(label.c_str(), decode_ns, decoded_info.file_bytes,
+           decoded_info.gpu_bytes);
+  }
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,99 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "base/logging.h"
+#include "bench/bench.h"
+
+namespace Bench {
+
+namespace {
+
+// the old backend: std::cerr with std::endl per message
+struct StreamLog {
+  explicit StreamLog(std::ostream *o) : o(o) {}
+  ~StreamLog() { *o << std::endl; }
+  std::ostream *o;
+};
+
+// caller-side ns per message with |threads| threads logging |count| each
+template <typename F> double perMessage(int threads, int count, F &&log) {
+  const int64_t ns = measureNs([&] {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        for (int i = 0; i < count; ++i)
+          log(t, i);
+      });
+    }
+    for (std::thread &w : workers)
+      w.join();
+  });
+  return static_cast<double>(ns) / threads / count;
+}
+
+} // namespace
+
+bool logging(const Options &options) {
+  const int count = options.count > 0 ? options.count : 100000;
+  const int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (null_fd < 0)
+    return false;
+  std::ofstream null_stream("/dev/null");
+  const bool was_running = Logging::running();
+  const Logging::Config saved = Logging::config();
+
+  auto warn = [](int t, int i) { LOG_W << "thread " << t << " message " << i; };
+  std::cout << "logging: " << count << " messages per thread to /dev/null"
+            << std::endl;
+  for (int threads : {1, 4}) {
+    const double stream_ns = perMessage(threads, count, [&](int t, int i) {
+      StreamLog log(&null_stream);
+      null_stream << "Warning: thread " << t << " message " << i;
+    });
+
+    Logging::Config config;
+    config.fd = null_fd;
+    // start() + stop() only to point the synchronous path at /dev/null
+    Logging::start(config);
+    Logging::stop();
+    const double sync_ns = perMessage(threads, count, warn);
+
+    const uint64_t dropped_before = Logging::stats().dropped;
+    Logging::start(config);
+    const double drop_ns = perMessage(threads, count, warn);
+    Logging::stop();
+    const uint64_t dropped = Logging::stats().dropped - dropped_before;
+
+    config.overflow = Logging::OverflowPolicy::kBlock;
+    Logging::start(config);
+    const double block_ns = perMessage(threads, count, warn);
+    Logging::stop();
+
+    const int verbosity = Logging::verbosity();
+    Logging::setVerbosity(0);
+    const double filtered_ns = perMessage(threads, count, [](int t, int i) {
+      VLOG(1) << "thread " << t << " message " << i;
+    });
+    Logging::setVerbosity(verbosity);
+
+    std::cout << "  " << threads << " thread(s), ns/message: cerr+endl "
+              << stream_ns << ", sync " << sync_ns << ", async drop "
+              << drop_ns << " (" << dropped << " dropped), async block "
+              << block_ns << ", filtered VLOG " << filtered_ns << std::endl;
+  }
+
+  // back to where main() left it
+  Logging::start(saved);
+  if (!was_running)
+    Logging::stop();
+  close(null_fd);
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench.h"
+#include "math/batch.h"
+
+namespace Bench {
+
+namespace {
+
+float random(float scale) {
+  return (rand() / (RAND_MAX + 1.0f) * 2 - 1) * scale;
+}
+
+// best of |iterations| runs of |fn| over |n| elements, in ns per element
+template <typename F> double perElement(int iterations, size_t n, F &&fn) {
+  int64_t best = INT64_MAX;
+  for (int i = 0; i < iterations; ++i)
+    best = std::min(best, measureNs(fn));
+  return static_cast<double>(best) / n;
+}
+
+void report(const char *label, double scalar_ns, double simd_ns) {
+  std::cout << "  " << label << ": scalar " << scalar_ns << " ns, "
+            << Math::simdPath() << " " << simd_ns << " ns, x"
+            << scalar_ns / simd_ns << std::endl;
+}
+
+float maxDifference(const float *a, const float *b, size_t n) {
+  float d = 0;
+  for (size_t i = 0; i < n; ++i)
+    d = std::max(d, std::fabs(a[i] - b[i]));
+  return d;
+}
+
+} // namespace
+
+bool math(const Options &options) {
+  const size_t n = options.count > 0 ? options.count : 10000;
+  const int iterations = options.iterations;
+
+  srand(1);
+  std::vector<Math::Quat> rotations(n);
+  std::vector<Math::Vec3> translations(n);
+  std::vector<Math::Vec4> points(n);
+  for (size_t i = 0; i < n; ++i) {
+    rotations[i] = Math::Quat::fromEuler(random(180), random(180), random(180));
+    translations[i] = Math::Vec3(random(10), random(10), random(10));
+    points[i] = Math::Vec4(random(1), random(1), random(1), 1);
+  }
+  // the EntityList layout
+  std::vector<float> packed_rotations(n * 4), packed_translations(n * 3);
+  for (size_t i = 0; i < n; ++i) {
+    std::copy_n(rotations[i].data(), 4, &packed_rotations[i * 4]);
+    std::copy_n(&translations[i].x, 3, &packed_translations[i * 3]);
+  }
+  const Math::Mat4 view_projection =
+      Math::Mat4::perspective(Math::radians(45), 4.0f / 3, 0.1f, 100) *
+      Math::Mat4::lookAt({5, 2, 5}, {0, 0, 0}, {0, 1, 0});
+
+  std::vector<Math::Mat4> models(n), scalar_out(n), simd_out(n);
+  std::vector<Math::Vec4> scalar_points(n), simd_points(n);
+  std::vector<float> scalar_rows(n * 12), simd_rows(n * 12);
+
+  std::cout << "math: " << n << " elements, best of " << iterations
+            << " runs, ns per element" << std::endl;
+  const double rt_scalar = perElement(iterations, n, [&] {
+    Math::Scalar::fromRotationTranslation(rotations.data(),
+                                          translations.data(),
+                                          scalar_out.data(), n);
+  });
+  const double rt_simd = perElement(iterations, n, [&] {
+    Math::fromRotationTranslation(rotations.data(), translations.data(),
+                                  models.data(), n);
+  });
+  report("fromRotationTranslation", rt_scalar, rt_simd);
+  float error = maxDifference(models[0].m, scalar_out[0].m, n * 16);
+
+  const double rows_scalar = perElement(iterations, n, [&] {
+    Math::Scalar::affineRows(packed_rotations.data(),
+                             packed_translations.data(), scalar_rows.data(),
+                             n);
+  });
+  const double rows_simd = perElement(iterations, n, [&] {
+    Math::affineRows(packed_rotations.data(), packed_translations.data(),
+                     simd_rows.data(), n);
+  });
+  report("affineRows", rows_scalar, rows_simd);
+  error = std::max(error, maxDifference(scalar_rows.data(), simd_rows.data(),
+                                        n * 12));
+
+  const double mul_scalar = perElement(iterations, n, [&] {
+    Math::Scalar::multiply(view_projection, models.data(), scalar_out.data(),
+                           n);
+  });
+  const double mul_simd = perElement(iterations, n, [&] {
+    Math::multiply(view_projection, models.data(), simd_out.data(), n);
+  });
+  report("view-projection * model", mul_scalar, mul_simd);
+  error = std::max(error,
+                   maxDifference(scalar_out[0].m, simd_out[0].m, n * 16));
+
+  const double transform_scalar = perElement(iterations, n, [&] {
+    Math::Scalar::transform(view_projection, points.data(),
+                            scalar_points.data(), n);
+  });
+  const double transform_simd = perElement(iterations, n, [&] {
+    Math::transform(view_projection, points.data(), simd_points.data(), n);
+  });
+  report("mat4 * vec4", transform_scalar, transform_simd);
+  error = std::max(error, maxDifference(&scalar_points[0].x,
+                                        &simd_points[0].x, n * 4));
+
+  std::cout << "  max difference from scalar: " << error << std::endl;
+  return error < 1e-3f;
+}
+
+} // namespace Bench
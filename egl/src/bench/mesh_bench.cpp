@@ -0,0 +1,184 @@
+#include <GLES2/gl2.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+#include "bench/bench.h"
+#include "gles2/buffer.h"
+#include "gles2/mesh.h"
+#include "gles2/mesh_format.h"
+#include "gles2/program_cache.h"
+#include "gles2/state.h"
+#include "math/mat4.h"
+
+namespace Bench {
+
+namespace {
+
+// a (segments + 1)^2 vertex torus, triangles in row order
+MeshFormat::Source torus(int segments) {
+  MeshFormat::Source source;
+  const float kTau = 6.2831853f;
+  for (int i = 0; i <= segments; ++i) {
+    const float u = kTau * i / segments;
+    for (int j = 0; j <= segments; ++j) {
+      const float v = kTau * j / segments;
+      const float ring = 1.0f + 0.4f * std::cos(v);
+      source.positions.insert(source.positions.end(),
+                              {ring * std::cos(u), 0.4f * std::sin(v),
+                               ring * std::sin(u)});
+      source.normals.insert(source.normals.end(),
+                            {std::cos(v) * std::cos(u), std::sin(v),
+                             std::cos(v) * std::sin(u)});
+      source.uvs.insert(source.uvs.end(), {static_cast<float>(i) / segments,
+                                           static_cast<float>(j) / segments});
+    }
+  }
+  const uint32_t row = segments + 1;
+  for (int i = 0; i < segments; ++i) {
+    for (int j = 0; j < segments; ++j) {
+      const uint32_t a = i * row + j, b = a + row;
+      source.indices.insert(source.indices.end(),
+                            {a, b, a + 1, a + 1, b, b + 1});
+    }
+  }
+  return source;
+}
+
+} // namespace
+
+bool mesh(const Options &options) {
+  const int segments = options.count > 0 ? options.count : 512;
+  const int iterations = std::max(1, options.iterations / 10);
+  MeshFormat::Source source = torus(segments);
+  const double row_acmr =
+      MeshFormat::acmr(source.indices.data(), source.indices.size(), 32);
+  // triangles in no particular order, as some exporters leave them
+  {
+    std::vector<uint32_t> order(source.indices.size() / 3);
+    for (size_t t = 0; t < order.size(); ++t)
+      order[t] = t;
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+    std::vector<uint32_t> shuffled;
+    shuffled.reserve(source.indices.size());
+    for (uint32_t t : order)
+      shuffled.insert(shuffled.end(), &source.indices[t * 3],
+                      &source.indices[t * 3 + 3]);
+    source.indices.swap(shuffled);
+  }
+
+  const std::string base = "/tmp/mesh_bench_" + std::to_string(getpid());
+  const std::string paths[2] = {base + "_shuffled.mesh",
+                                base + "_optimized.mesh"};
+  MeshFormat::EncodeStats stats[2];
+  int64_t encode_ns[2];
+  for (int optimized = 0; optimized < 2; ++optimized) {
+    MeshFormat::EncodeOptions encode_options;
+    encode_options.optimize = optimized;
+    std::vector<uint8_t> data;
+    encode_ns[optimized] = measureNs([&] {
+      data = MeshFormat::encode(source, encode_options, &stats[optimized]);
+    });
+    if (!MeshFormat::write(paths[optimized], data))
+      return false;
+  }
+
+  GlES2ProgramCache cache;
+  auto program = cache.get(GlES2Mesh::kVertexShader,
+                           GlES2Mesh::kFragmentShader);
+  if (!program)
+    return false;
+  GlES2Mesh::Attributes attributes;
+  attributes.position = program->attribute("a_position");
+  attributes.normal = program->attribute("a_normal");
+  const Math::Mat4 model = Math::Mat4::rotationX(0.6f);
+  const Math::Mat4 view_projection =
+      Math::Mat4::perspective(Math::radians(45), 1, 0.1f, 10) *
+      Math::Mat4::translation(Math::Vec3(0, 0, -4));
+  GlES2State &gl = GlES2State::current();
+  gl.setEnabled(GL_DEPTH_TEST, true);
+
+  std::cout << "mesh: torus of " << stats[0].triangles << " triangles, "
+            << source.vertexCount() << " vertices, " << iterations
+            << " loads and draws each" << std::endl;
+  std::cout << "  ACMR fifo32: row order " << row_acmr << ", shuffled "
+            << stats[0].acmr32_before << std::endl;
+  bool ok = true;
+  for (int optimized = 0; optimized < 2 && ok; ++optimized) {
+    GlES2Mesh mesh;
+    MeshLoadInfo info;
+    int64_t load_ns = 0;
+    for (int i = 0; i < iterations && ok; ++i) {
+      load_ns += measureNs([&] {
+        ok = mesh.load(paths[optimized], &info);
+        glFinish();
+      });
+    }
+    if (!ok)
+      break;
+    gl.useProgram(program->program());
+    gl.uniformMatrix4fv(program->uniform("u_model"), model.data());
+    gl.uniformMatrix4fv(program->uniform("u_view_projection"),
+                        view_projection.data());
+    glUniform4fv(program->uniform("u_position_offset"), 1,
+                 mesh.positionOffset());
+    glUniform4fv(program->uniform("u_position_scale"), 1,
+                 mesh.positionScale());
+    const int64_t draw_ns = measureNs([&] {
+      for (int i = 0; i < iterations; ++i) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mesh.draw(attributes);
+      }
+      glFinish();
+    });
+    const MeshFormat::EncodeStats &s = stats[optimized];
+    std::cout << "  " << (optimized ? "optimized" : "shuffled")
+              << ": ACMR fifo16 " << s.acmr16 << " fifo32 " << s.acmr32
+              << ", " << s.chunks << " chunks, " << s.vertices
+              << " vertices, encode " << encode_ns[optimized] / 1e6
+              << " ms, load " << load_ns / 1e6 / iterations << " ms, draw "
+              << draw_ns / 1e6 / iterations << " ms" << std::endl;
+    if (optimized) {
+      std::cout << "  file " << info.file_bytes / 1024 << " KiB ("
+                << info.float_bytes / 1024
+                << " KiB as floats and 32-bit indices)" << std::endl;
+    }
+  }
+
+  // the same file read into memory first, then uploaded from there
+  if (ok) {
+    std::vector<uint8_t> data;
+    GlES2Buffer vertices;
+    GlES2Buffer indices(GL_ELEMENT_ARRAY_BUFFER);
+    int64_t read_ns = 0;
+    for (int i = 0; i < iterations && ok; ++i) {
+      read_ns += measureNs([&] {
+        std::ifstream in(paths[1], std::ios::binary | std::ios::ate);
+        data.resize(in.tellg());
+        in.seekg(0);
+        in.read(reinterpret_cast<char *>(data.data()), data.size());
+        MeshFormat::Mesh parsed;
+        ok = MeshFormat::parse(data.data(), data.size(), &parsed) &&
+             vertices.initialize(parsed.vertex_count *
+                                     sizeof(MeshFormat::Vertex),
+                                 parsed.vertices) &&
+             indices.initialize(parsed.index_count * sizeof(uint16_t),
+                                parsed.indices);
+        glFinish();
+      });
+    }
+    std::cout << "  read into memory, then upload: "
+              << read_ns / 1e6 / iterations << " ms" << std::endl;
+  }
+  gl.setEnabled(GL_DEPTH_TEST, false);
+  for (const std::string &path : paths)
+    unlink(path.c_str());
+  return ok;
+}
+
+} // namespace Bench
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "base/block_pool.h"
+#include "base/frame_arena.h"
+#include "bench/bench.h"
+#include "gles2/program_cache.h"
+#include "gles2/sprite_batch.h"
+#include "gles2/texture_manager.h"
+
+namespace Bench {
+
+namespace {
+
+constexpr int kTextureSize = 256;
+constexpr int kHotTextures = 4;
+constexpr int kColdPerFrame = 4;
+// frames each cold window stays on screen; windows wrap around the cold
+// textures, so a large enough budget turns later passes into hits
+constexpr int kWindowFrames = 2;
+
+// every (re)load fills a recycled block instead of a fresh vector
+bool loadPattern(int seed, BlockPool *pool, GlES2Texture *texture) {
+  BlockPool::Block block = pool->acquireBlock();
+  unsigned char *pixels = block.get();
+  for (int y = 0; y < kTextureSize; ++y) {
+    for (int x = 0; x < kTextureSize; ++x) {
+      unsigned char *p = &pixels[(y * kTextureSize + x) * 4];
+      p[0] = x ^ seed;
+      p[1] = y + seed * 8;
+      p[2] = (x + y) ^ (seed * 31);
+      p[3] = 0xff;
+    }
+  }
+  if (!texture->allocate(kTextureSize, kTextureSize, GL_RGBA))
+    return false;
+  texture->update(pixels);
+  return true;
+}
+
+} // namespace
+
+bool residency(const Options &options) {
+  const int textures = std::max(kHotTextures + kColdPerFrame,
+                                options.count > 0 ? options.count : 64);
+  const int cold_textures = textures - kHotTextures;
+  const int frames = options.iterations;
+
+  GlES2ProgramCache cache;
+  auto program = cache.get(GlES2SpriteBatch::kVertexShader,
+                           GlES2SpriteBatch::kFragmentShader);
+  GlES2SpriteBatch batch;
+  if (!program || !batch.initialize(program))
+    return false;
+
+  const size_t texture_bytes =
+      GlES2Texture::levelBytes(kTextureSize, kTextureSize, GL_RGBA) * 4 / 3;
+  BlockPool pool(GlES2Texture::levelBytes(kTextureSize, kTextureSize, GL_RGBA),
+                 1);
+  std::cout << "residency: " << textures << " " << kTextureSize << "^2 RGBA "
+            << "textures with mipmaps (~" << texture_bytes / 1024
+            << " KiB each), " << kHotTextures << " hot + " << kColdPerFrame
+            << " from a sliding window per frame, " << frames << " frames"
+            << std::endl;
+  for (int budget_textures : {8, 16, 32, textures}) {
+    GlES2TextureManager manager;
+    if (!manager.initialize({budget_textures * texture_bytes}))
+      return false;
+    std::vector<GlES2TextureManager::Handle> handles;
+    for (int t = 0; t < textures; ++t) {
+      handles.push_back(manager.add(
+          [t, &pool](GlES2Texture *texture) {
+            return loadPattern(t, &pool, texture);
+          },
+          true, texture_bytes));
+    }
+
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        manager.beginFrame();
+        batch.begin();
+        auto draw = [&](int t, int slot) {
+          const float x = -1 + slot * 0.25f;
+          batch.draw({x, 0.1f, x + 0.2f, -0.1f, 0, 0, 1, 1, 0xffffffff,
+                      manager.use(handles[t])});
+        };
+        for (int h = 0; h < kHotTextures; ++h)
+          draw(h, h);
+        const int window = f / kWindowFrames * kColdPerFrame;
+        for (int c = 0; c < kColdPerFrame; ++c)
+          draw(kHotTextures + (window + c) % cold_textures, kHotTextures + c);
+        batch.end();
+        FrameArena::current().reset();
+      }
+      glFinish();
+    });
+
+    const GlES2TextureManager::Stats &stats = manager.stats();
+    std::cout << "  budget " << budget_textures << " textures ("
+              << budget_textures * texture_bytes / 1024
+              << " KiB): " << ns / 1e6 / frames
+              << " ms/frame, hit rate " << stats.hitRate() * 100
+              << "%, misses=" << stats.misses
+              << " evictions=" << stats.evictions
+              << " load_ms=" << stats.load_ns / 1e6
+              << " peak_KiB=" << stats.peak_bytes / 1024
+              << " overshoot_KiB=" << stats.max_overshoot_bytes / 1024
+              << " over_budget_frames=" << stats.over_budget_frames
+              << std::endl;
+  }
+  const BlockPool::Stats pool_stats = pool.stats();
+  std::cout << "  pixel pool: " << pool_stats.acquired << " buffers, "
+            << pool_stats.reused << " reused" << std::endl;
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,98 @@
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "bench/bench.h"
+#include "gles2/program_cache.h"
+#include "gles2/utils.h"
+
+namespace Bench {
+
+namespace {
+
+// |count| distinct programs; the constant makes every source unique
+std::vector<std::pair<std::string, std::string>> makeSources(int count) {
+  std::vector<std::pair<std::string, std::string>> sources;
+  for (int i = 0; i < count; ++i) {
+    const std::string k = std::to_string(i) + ".0";
+    sources.emplace_back(
+        "attribute vec4 a_position;\n"
+        "attribute vec2 a_uv;\n"
+        "uniform mat4 u_mvp;\n"
+        "varying mediump vec2 v_uv;\n"
+        "void main() {\n"
+        "  v_uv = a_uv * " + k + ";\n"
+        "  gl_Position = u_mvp * a_position;\n"
+        "}\n",
+        "precision mediump float;\n"
+        "uniform sampler2D u_texture;\n"
+        "uniform vec4 u_color;\n"
+        "varying vec2 v_uv;\n"
+        "void main() {\n"
+        "  vec4 c = texture2D(u_texture, v_uv) * u_color;\n"
+        "  gl_FragColor = c * (1.0 / (" + k + " + 1.0));\n"
+        "}\n");
+  }
+  return sources;
+}
+
+int64_t loadAll(GlES2ProgramCache *cache,
+                const std::vector<std::pair<std::string, std::string>> &src) {
+  return measureNs([&] {
+    for (const auto &s : src) {
+      if (!cache->get(s.first.c_str(), s.second.c_str()))
+        LOG_E << "program failed";
+    }
+    glFinish();
+  });
+}
+
+void report(const char *label, int64_t ns, int count) {
+  std::cout << "  " << label << ": " << ns / 1e6 << " ms total, "
+            << ns / 1e3 / count << " us/program" << std::endl;
+}
+
+} // namespace
+
+bool shader(const Options &options) {
+  const int count = options.count > 0 ? options.count : 64;
+  // a fresh directory so the first pass is cold
+  char dir[] = "/tmp/app-main-shader-cache-XXXXXX";
+  if (!mkdtemp(dir)) {
+    LOG_E << "mkdtemp";
+    return false;
+  }
+  const auto sources = makeSources(count);
+  std::cout << "shader: " << count << " programs, GL_OES_get_program_binary "
+            << (hasGLES2Extension("GL_OES_get_program_binary") ? "yes" : "no")
+            << std::endl;
+
+  {
+    GlES2ProgramCache cache;
+    report("compile from source", loadAll(&cache, sources), count);
+    report("in-process hit", loadAll(&cache, sources), count);
+  }
+  {
+    GlES2ProgramCache cache(dir);
+    report("compile + store binary", loadAll(&cache, sources), count);
+  }
+  {
+    GlES2ProgramCache cache(dir);
+    report("load binary from disk", loadAll(&cache, sources), count);
+    const auto &stats = cache.stats();
+    std::cout << "  disk hits=" << stats.disk_hits
+              << " rejects=" << stats.disk_rejects
+              << " compiles=" << stats.compiles << std::endl;
+  }
+
+  const std::string rm = std::string("rm -rf ") + dir;
+  return system(rm.c_str()) == 0;
+}
+
+} // namespace Bench
@@ -0,0 +1,138 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "base/frame_arena.h"
+#include "bench/bench.h"
+#include "gles2/program_cache.h"
+#include "gles2/sprite_batch.h"
+#include "gles2/state.h"
+#include "gles2/texture.h"
+
+namespace Bench {
+
+namespace {
+
+constexpr int kTextures = 4;
+
+struct Mover {
+  float x, y, vx, vy;
+  int texture;
+};
+
+void report(const char *label, int64_t ns, int frames, int count,
+            uint64_t draw_calls) {
+  const double ms = ns / 1e6 / frames;
+  std::cout << "  " << label << ": " << ms << " ms/frame, "
+            << count / (ms / 1e3) / 1e6 << " M sprites/s, "
+            << draw_calls / frames << " draws/frame" << std::endl;
+}
+
+} // namespace
+
+bool sprites(const Options &options) {
+  const int count = options.count > 0 ? options.count : 10000;
+  const int frames = options.iterations;
+
+  GlES2ProgramCache cache;
+  auto program = cache.get(GlES2SpriteBatch::kVertexShader,
+                           GlES2SpriteBatch::kFragmentShader);
+  if (!program)
+    return false;
+  GlES2SpriteBatch batch;
+  if (!batch.initialize(program))
+    return false;
+
+  std::vector<GlES2Texture> textures;
+  for (int t = 0; t < kTextures; ++t) {
+    textures.push_back(*GlES2Texture::create()); // unwrap
+    std::vector<unsigned char> pixels(16 * 16 * 4, 0xff);
+    for (size_t i = 0; i < pixels.size(); i += 4)
+      pixels[i + t % 3] = 0x40;
+    textures.back().allocate(16, 16, GL_RGBA);
+    textures.back().update(pixels.data());
+  }
+
+  std::vector<Mover> movers(count);
+  srand(1);
+  for (Mover &m : movers) {
+    m.x = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    m.y = rand() / (RAND_MAX + 1.0f) * 2 - 1;
+    m.vx = (rand() / (RAND_MAX + 1.0f) - 0.5f) * 0.02f;
+    m.vy = (rand() / (RAND_MAX + 1.0f) - 0.5f) * 0.02f;
+    m.texture = rand() % kTextures;
+  }
+  auto step = [&] {
+    for (Mover &m : movers) {
+      m.x += m.vx;
+      m.y += m.vy;
+      if (std::fabs(m.x) > 1)
+        m.vx = -m.vx;
+      if (std::fabs(m.y) > 1)
+        m.vy = -m.vy;
+    }
+  };
+  const float s = 0.02f;
+  auto sprite = [&](const Mover &m) {
+    return GlES2SpriteBatch::Sprite{m.x,  m.y,  m.x + s,    m.y - s,
+                                    0.0f, 0.0f, 1.0f,       1.0f,
+                                    0xffffffff, textures[m.texture].texture()};
+  };
+
+  std::cout << "sprites: " << count << " sprites, " << kTextures
+            << " textures, " << frames << " frames" << std::endl;
+  for (bool sorted : {true, false}) {
+    batch.setSortByTexture(sorted);
+    batch.resetStats();
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        step();
+        glClear(GL_COLOR_BUFFER_BIT);
+        batch.begin();
+        for (const Mover &m : movers)
+          batch.draw(sprite(m));
+        batch.end();
+        FrameArena::current().reset();
+        glFinish();
+      }
+    });
+    report(sorted ? "batched, sorted by texture" : "batched, in order", ns,
+           frames, count, batch.stats().draw_calls);
+  }
+
+  // the pre-batching path: client arrays and one draw per quad
+  GlES2State &gl = GlES2State::current();
+  gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+  gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  const GLint a_position = program->attribute("a_position");
+  const GLint a_uv = program->attribute("a_uv");
+  const GLint a_color = program->attribute("a_color");
+  gl.disableVertexAttribArray(a_color);
+  glVertexAttrib4f(a_color, 1, 1, 1, 1);
+  const int64_t naive = measureNs([&] {
+    for (int f = 0; f < frames; ++f) {
+      step();
+      glClear(GL_COLOR_BUFFER_BIT);
+      gl.useProgram(program->program());
+      for (const Mover &m : movers) {
+        const GLfloat position[] = {m.x, m.y,     m.x,     m.y - s,
+                                    m.x + s, m.y, m.x + s, m.y - s};
+        const GLfloat uv[] = {0, 0, 0, 1, 1, 0, 1, 1};
+        gl.bindTexture(0, textures[m.texture].texture());
+        gl.vertexAttribPointer(a_position, 2, GL_FLOAT, GL_FALSE, 0, position);
+        gl.vertexAttribPointer(a_uv, 2, GL_FLOAT, GL_FALSE, 0, uv);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+      }
+      glFinish();
+    }
+  });
+  report("one draw per sprite", naive, frames, count, int64_t{count} * frames);
+  // the pointers above referenced the stack
+  gl.invalidate();
+  return true;
+}
+
+} // namespace Bench
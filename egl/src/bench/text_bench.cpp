@@ -0,0 +1,176 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "base/frame_arena.h"
+#include "bench/bench.h"
+#include "gles2/bitmap_font.h"
+#include "gles2/glyph_cache.h"
+#include "gles2/program_cache.h"
+#include "gles2/text_renderer.h"
+
+namespace Bench {
+
+namespace {
+
+constexpr int kViewport = 512;
+constexpr float kSize = 12;
+
+// |length| printable characters, about one in six a space
+std::string randomLine(int length) {
+  std::string line(length, ' ');
+  for (char &c : line) {
+    if (rand() % 6)
+      c = BitmapFont::kFirst + 1 +
+          rand() % (BitmapFont::kLast - BitmapFont::kFirst);
+  }
+  return line;
+}
+
+} // namespace
+
+bool text(const Options &options) {
+  const int count = options.count > 0 ? options.count : 200;
+  const int frames = options.iterations;
+  constexpr int kLength = 40;
+
+  srand(1);
+  std::vector<std::string> lines(count);
+  for (std::string &line : lines)
+    line = randomLine(kLength);
+
+  GlES2ProgramCache cache;
+  GlES2GlyphCache glyphs;
+  GlES2TextRenderer text;
+  if (!glyphs.initialize(GlES2GlyphCache::Config()) ||
+      !text.initialize(&cache, &glyphs))
+    return false;
+
+  std::cout << "text: " << count << " lines of " << kLength << ", "
+            << frames << " frames" << std::endl;
+
+  // every printable glyph once: rasterized, then uploaded
+  const int printable = BitmapFont::kLast - BitmapFont::kFirst + 1;
+  const int64_t fill_ns = measureNs([&] {
+    GlES2GlyphCache::Glyph g;
+    for (uint32_t c = BitmapFont::kFirst; c <= BitmapFont::kLast; ++c)
+      glyphs.glyph(c, &g);
+    glFinish();
+  });
+  const GlES2GlyphCache::Stats &glyph_stats = glyphs.stats();
+  std::cout << "  rasterize: " << glyph_stats.rasterized << " glyphs at "
+            << glyph_stats.rasterized / (glyph_stats.rasterize_ns / 1e6)
+            << " glyphs/ms, with upload " << printable / (fill_ns / 1e6)
+            << " glyphs/ms, " << glyphs.atlasStats().pages << " pages"
+            << std::endl;
+
+  // new strings: decode, glyph lookups, sort by page, VBO upload
+  std::vector<std::shared_ptr<GlES2TextRun>> runs;
+  const int64_t layout_ns = measureNs([&] {
+    for (const std::string &line : lines)
+      runs.push_back(text.layout(line, kSize));
+    glFinish();
+  });
+  const uint64_t laid_out = text.stats().glyphs_laid_out;
+  std::cout << "  layout: " << laid_out / (layout_ns / 1e6)
+            << " glyphs/ms, " << layout_ns / 1e3 / count << " us/line"
+            << std::endl;
+
+  auto draw = [&](const char *label, bool by_string) {
+    text.resetStats();
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int i = 0; i < count; ++i) {
+          const float y = (i * 14) % kViewport;
+          if (by_string)
+            text.draw(lines[i], 0, y, kSize, 0xffffffff);
+          else
+            text.draw(runs[i], 0, y, 0xffffffff);
+        }
+        text.flush(kViewport, kViewport);
+        FrameArena::current().reset();
+      }
+      glFinish();
+    });
+    const GlES2TextRenderer::Stats &stats = text.stats();
+    std::cout << "  " << label << ": " << stats.glyphs_drawn / (ns / 1e6)
+              << " glyphs/ms, " << ns / 1e6 / frames << " ms/frame, "
+              << stats.draw_calls / frames << " draws/frame, "
+              << stats.glyphs_laid_out << " glyphs laid out" << std::endl;
+  };
+  draw("draw, kept runs", false);
+  draw("draw, looked up by string", true);
+
+  // a HUD label: its CPU cost per frame once laid out, GPU excluded, which
+  // is that of its draw calls, one per page. Then again with many more runs
+  // cached (a UI with other labels on other screens), which a flush walks
+  // once per kRunLifetime frames, not every frame.
+  {
+    auto label = text.layout("frame time: 16.7 ms  draws: 42", 16);
+    auto measure = [&] {
+      text.resetStats();
+      text.draw(label, 8, 8, 0xffffffff);
+      text.flush(kViewport, kViewport);
+      int64_t cpu_ns = 0;
+      for (int f = 0; f < frames; ++f) {
+        cpu_ns += measureNs([&] {
+          text.draw(label, 8, 8, 0xffffffff);
+          text.flush(kViewport, kViewport);
+        });
+        FrameArena::current().reset();
+        glFinish();
+      }
+      std::cout << "  static label, " << text.cachedRuns()
+                << " runs cached: " << cpu_ns / frames
+                << " ns/frame on the CPU after the first, "
+                << text.stats().draw_calls / (frames + 1) << " draws/frame, "
+                << text.stats().glyphs_laid_out << " glyphs laid out again"
+                << std::endl;
+    };
+    measure();
+    for (int i = 0; i < 10000; ++i)
+      text.layout(std::to_string(i), kSize);
+    measure();
+  }
+
+  // an atlas of 2 pages of 9 glyphs, drawing a window that slides over all
+  // of them: pages are evicted and glyphs uploaded again, never rasterized
+  {
+    GlES2GlyphCache small;
+    GlES2GlyphCache::Config config;
+    config.page_size = 128;
+    config.max_pages = 2;
+    GlES2TextRenderer small_text;
+    if (!small.initialize(config) || !small_text.initialize(&cache, &small))
+      return false;
+    std::vector<std::shared_ptr<GlES2TextRun>> windows;
+    for (int i = 0; i + 8 <= printable; ++i) {
+      std::string window;
+      for (int j = 0; j < 8; ++j)
+        window += static_cast<char>(BitmapFont::kFirst + i + j);
+      windows.push_back(small_text.layout(window, kSize));
+    }
+    const int64_t ns = measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        small_text.draw(windows[f % windows.size()], 0, 0, 0xffffffff);
+        small_text.flush(kViewport, kViewport);
+        FrameArena::current().reset();
+      }
+      glFinish();
+    });
+    const GlES2GlyphCache::Stats &stats = small.stats();
+    std::cout << "  lru, 2 pages: " << ns / 1e6 / frames << " ms/frame, "
+              << small.atlasStats().evicted_pages << " pages evicted, "
+              << stats.uploads << " uploads, " << stats.rasterized
+              << " rasterized, " << small_text.stats().runs_built
+              << " runs laid out" << std::endl;
+  }
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "bench/bench.h"
+#include "gles2/texture.h"
+
+namespace Bench {
+
+namespace {
+
+void report(const char *label, int64_t ns, int iterations, size_t bytes) {
+  const double ms = ns / 1e6 / iterations;
+  std::cout << "    " << label << ": " << ms << " ms/update, "
+            << bytes / 1e6 / (ms / 1e3) << " MB/s" << std::endl;
+}
+
+void runSize(int width, int height, int iterations, int dirty_rects) {
+  std::cout << "  " << width << "x" << height << " RGBA" << std::endl;
+  const size_t frame_bytes = static_cast<size_t>(width) * height * 4;
+  std::vector<unsigned char> frame(frame_bytes);
+  for (size_t i = 0; i < frame.size(); ++i)
+    frame[i] = static_cast<unsigned char>(i * 31);
+
+  GlES2Texture texture = *GlES2Texture::create(); // unwrap
+  texture.allocate(width, height, GL_RGBA);
+
+  const int64_t respec = measureNs([&] {
+    for (int i = 0; i < iterations; ++i) {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE, frame.data());
+      glFinish();
+    }
+  });
+  report("glTexImage2D (respecify)", respec, iterations, frame_bytes);
+
+  texture.allocate(width, height, GL_RGBA);
+  const int64_t full = measureNs([&] {
+    for (int i = 0; i < iterations; ++i) {
+      texture.update(frame.data());
+      glFinish();
+    }
+  });
+  report("glTexSubImage2D (full)", full, iterations, frame_bytes);
+
+  // a few 128x128 regions spread over the frame
+  std::vector<GlES2Texture::Rect> rects;
+  for (int i = 0; i < dirty_rects; ++i) {
+    rects.push_back({(width - 128) * i / dirty_rects,
+                     (height - 128) * (dirty_rects - 1 - i) / dirty_rects,
+                     128, 128});
+  }
+  const int64_t dirty = measureNs([&] {
+    for (int i = 0; i < iterations; ++i) {
+      texture.update(frame.data(), 0, rects);
+      glFinish();
+    }
+  });
+  char label[64];
+  snprintf(label, sizeof(label), "glTexSubImage2D (%d dirty 128x128)",
+           dirty_rects);
+  report(label, dirty, iterations, rects.size() * 128 * 128 * 4);
+}
+
+} // namespace
+
+bool texture(const Options &options) {
+  const int dirty_rects = options.count > 0 ? options.count : 8;
+  std::cout << "texture: " << options.iterations << " updates per mode"
+            << std::endl;
+  runSize(1280, 720, options.iterations, dirty_rects);
+  runSize(1920, 1080, options.iterations, dirty_rects);
+  return true;
+}
+
+} // namespace Bench
@@ -0,0 +1,48 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "app/yuv.h"
+#include "bench/bench.h"
+
+namespace Bench {
+
+bool yuv(const Options &options) {
+  const int width = 1920;
+  const int height = 1080;
+  const int frames = options.iterations;
+
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  srand(1);
+  for (uint8_t &c : rgba)
+    c = rand() & 0xff;
+  const size_t luma = static_cast<size_t>(width) * height;
+  const size_t chroma = luma / 4;
+  std::vector<uint8_t> scalar(luma + 2 * chroma), simd(luma + 2 * chroma);
+  auto run = [&](auto convert, std::vector<uint8_t> *out) {
+    return measureNs([&] {
+      for (int f = 0; f < frames; ++f) {
+        convert(rgba.data(), width, height, width * 4, true, out->data(),
+                out->data() + luma, out->data() + luma + chroma);
+      }
+    });
+  };
+  const int64_t scalar_ns = run(&rgbaToI420Scalar, &scalar);
+  const int64_t simd_ns = run(&rgbaToI420, &simd);
+
+  std::cout << "yuv: 1080p RGBA -> I420 with flip, " << frames << " frames"
+            << std::endl;
+  for (auto [label, ns] : {std::make_pair("scalar", scalar_ns),
+                           std::make_pair(yuvSimdPath(), simd_ns)}) {
+    const double ms = ns / 1e6 / frames;
+    std::cout << "  " << label << ": " << ms << " ms/frame, " << 1e3 / ms
+              << " fps" << std::endl;
+  }
+  const bool same = memcmp(scalar.data(), simd.data(), scalar.size()) == 0;
+  std::cout << "  output " << (same ? "matches" : "DIFFERS FROM")
+            << " scalar" << std::endl;
+  return same;
+}
+
+} // namespace Bench
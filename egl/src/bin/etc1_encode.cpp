@@ -0,0 +1,136 @@
+// Offline ETC1 encoder: etc1-encode [--mipmaps] [--threads=N] in.ppm out.ktx
+// Writes a .pkm (one level) or a .ktx (optionally with the full mip chain)
+// for app-main --texture.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/clock.h"
+#include "base/logging.h"
+#include "gles2/etc1.h"
+
+namespace {
+
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+bool endsWith(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// binary PPM (P6, 8 bits)
+bool readPpm(const std::string &path, Image *image) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  int max_value = 0;
+  in >> magic >> image->width >> image->height >> max_value;
+  in.get();
+  if (!in || magic != "P6" || max_value != 255 || image->width <= 0 ||
+      image->height <= 0) {
+    LOG_E << "cannot read " << path << " (expects binary P6 PPM)";
+    return false;
+  }
+  const size_t texels = static_cast<size_t>(image->width) * image->height;
+  std::vector<uint8_t> rgb(texels * 3);
+  in.read(reinterpret_cast<char *>(rgb.data()), rgb.size());
+  if (!in) {
+    LOG_E << "truncated " << path;
+    return false;
+  }
+  image->rgba.resize(texels * 4);
+  for (size_t i = 0; i < texels; ++i) {
+    std::copy_n(&rgb[i * 3], 3, &image->rgba[i * 4]);
+    image->rgba[i * 4 + 3] = 0xff;
+  }
+  return true;
+}
+
+// 2x2 box filter; odd edges repeat the last texel
+Image halve(const Image &src) {
+  Image dst;
+  dst.width = std::max(1, src.width / 2);
+  dst.height = std::max(1, src.height / 2);
+  dst.rgba.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+  for (int y = 0; y < dst.height; ++y) {
+    const int y0 = std::min(y * 2, src.height - 1);
+    const int y1 = std::min(y * 2 + 1, src.height - 1);
+    for (int x = 0; x < dst.width; ++x) {
+      const int x0 = std::min(x * 2, src.width - 1);
+      const int x1 = std::min(x * 2 + 1, src.width - 1);
+      for (int c = 0; c < 4; ++c) {
+        auto at = [&](int sx, int sy) {
+          return src.rgba[(static_cast<size_t>(sy) * src.width + sx) * 4 + c];
+        };
+        dst.rgba[(static_cast<size_t>(y) * dst.width + x) * 4 + c] =
+            (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2) / 4;
+      }
+    }
+  }
+  return dst;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool mipmaps = false;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--mipmaps") {
+      mipmaps = true;
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      threads = std::max(1, atoi(arg.c_str() + 10));
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  const bool pkm = paths.size() == 2 && endsWith(paths[1], ".pkm");
+  if (paths.size() != 2 || (!pkm && !endsWith(paths[1], ".ktx")) ||
+      (pkm && mipmaps)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--mipmaps] [--threads=N] in.ppm out.ktx|out.pkm"
+              << std::endl
+              << "  (.pkm holds a single level)" << std::endl;
+    return 1;
+  }
+
+  Image image;
+  if (!readPpm(paths[0], &image))
+    return 1;
+
+  const int64_t begin = monotonicNowNs();
+  std::vector<std::vector<uint8_t>> levels;
+  size_t rgba_bytes = 0;
+  for (Image level = image;; level = halve(level)) {
+    levels.push_back(
+        Etc1::encode(level.rgba.data(), level.width, level.height, threads));
+    rgba_bytes += level.rgba.size();
+    if (!mipmaps || (level.width == 1 && level.height == 1))
+      break;
+  }
+  const double encode_ms = (monotonicNowNs() - begin) / 1e6;
+
+  const bool ok =
+      pkm ? Etc1::writePkm(paths[1], levels[0], image.width, image.height)
+          : Etc1::writeKtx(paths[1], levels, image.width, image.height);
+  if (!ok)
+    return 1;
+  size_t etc1_bytes = 0;
+  for (const std::vector<uint8_t> &level : levels)
+    etc1_bytes += level.size();
+  std::cout << paths[1] << ": " << image.width << "x" << image.height << ", "
+            << levels.size() << " level(s), " << etc1_bytes << " bytes ("
+            << rgba_bytes << " as RGBA), encoded in " << encode_ms << " ms on "
+            << threads << " thread(s)" << std::endl;
+  return 0;
+}
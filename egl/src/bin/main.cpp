@@ -1,24 +1,287 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include "app/app.h"
+#include "app/regression.h"
+#include "app/render_farm.h"
+#include "base/logging.h"
+#include "base/trace.h"
+#include "bench/bench.h"
 #include "egl/aegl.h"
 #include "window/awindow_x11.h"
 
+namespace {
+
+struct Options {
+  bool headless = false;
+  int width = 1024;
+  int height = 768;
+  App::Config app;
+  std::string trace_path;
+  size_t trace_capacity = 1 << 16;
+  std::string bench;
+  Bench::Options bench_options;
+  Regression::Options regress;
+  bool farm = false;
+  RenderFarm::Options farm_options;
+  Logging::Config logging;
+};
+
+const char *kUsage =
+    "[--headless] [--size=WxH] [--mode=vsync|fixed|unlimited] [--fps=N]\n"
+    "  [--verbosity=N] [--log-overflow=drop|block]\n"
+    "  [--late=skip|catchup] [--frames=N] [--time=SEC]\n"
+    "  [--trace=out.json] [--trace-capacity=N]\n"
+    "  [--producers=N] [--producer-fps=N] [--frame-buffers=N]\n"
+    "  [--frame-policy=backpressure|drop-oldest] [--shader-cache=DIR]\n"
+    "  [--entities=N] [--cull[=THREADS]]\n"
+    "  [--capture=out.y4m|out.yuv] [--capture-buffers=N]\n"
+    "  [--texture=FILE.ktx|FILE.pkm] [--on-demand] [--sync-load]\n"
+    "  [--mesh=FILE.mesh] [--command-buffers] [--hud]\n"
+    "  [--bench=NAME [--bench-count=N] [--bench-iterations=N]]\n"
+    "  [--regress=DIR [--regress-baseline=DIR]\n"
+    "   [--regress-update | --regress-update-baseline] [--regress-frames=N]\n"
+    "   [--regress-threshold=F] [--regress-tolerance=N]\n"
+    "   [--regress-scene=quad|triangle|composite]]\n"
+    "  [--farm [--farm-workers=N] [--farm-jobs=FILE|N] [--farm-frames=N]\n"
+    "   [--farm-out=DIR] [--farm-scaling]]";
+
+bool parseOptions(int argc, char *argv[], Options *options) {
+  FrameSchedulerConfig &scheduler = options->app.scheduler;
+  bool producers_given = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const std::string value = arg.substr(arg.find('=') + 1);
+    if (arg == "--headless") {
+      options->headless = true;
+    } else if (arg.rfind("--verbosity=", 0) == 0) {
+      Logging::setVerbosity(atoi(value.c_str()));
+    } else if (arg.rfind("--log-overflow=", 0) == 0) {
+      if (value == "drop") {
+        options->logging.overflow = Logging::OverflowPolicy::kDrop;
+      } else if (value == "block") {
+        options->logging.overflow = Logging::OverflowPolicy::kBlock;
+      } else {
+        LOG_E << "invalid log overflow policy: " << value;
+        return false;
+      }
+    } else if (arg.rfind("--size=", 0) == 0) {
+      if (sscanf(arg.c_str() + 7, "%dx%d", &options->width,
+                 &options->height) != 2 ||
+          options->width <= 0 || options->height <= 0) {
+        LOG_E << "invalid size: " << arg;
+        return false;
+      }
+    } else if (arg.rfind("--mode=", 0) == 0) {
+      if (value == "vsync") {
+        scheduler.mode = FrameMode::kVsync;
+      } else if (value == "fixed") {
+        scheduler.mode = FrameMode::kFixedRate;
+      } else if (value == "unlimited") {
+        scheduler.mode = FrameMode::kUnlimited;
+      } else {
+        LOG_E << "invalid mode: " << value;
+        return false;
+      }
+    } else if (arg.rfind("--late=", 0) == 0) {
+      if (value == "skip") {
+        scheduler.late_policy = LatePolicy::kSkip;
+      } else if (value == "catchup") {
+        scheduler.late_policy = LatePolicy::kCatchUp;
+      } else {
+        LOG_E << "invalid late policy: " << value;
+        return false;
+      }
+    } else if (arg.rfind("--fps=", 0) == 0) {
+      scheduler.fps = atof(value.c_str());
+      if (scheduler.fps <= 0) {
+        LOG_E << "invalid fps: " << value;
+        return false;
+      }
+    } else if (arg.rfind("--frames=", 0) == 0) {
+      scheduler.max_frames = strtoull(value.c_str(), nullptr, 10);
+    } else if (arg.rfind("--time=", 0) == 0) {
+      scheduler.time_limit_sec = atof(value.c_str());
+    } else if (arg.rfind("--producers=", 0) == 0) {
+      options->app.pipeline.producers = atoi(value.c_str());
+      producers_given = true;
+    } else if (arg.rfind("--producer-fps=", 0) == 0) {
+      options->app.pipeline.producer_fps = atof(value.c_str());
+    } else if (arg.rfind("--frame-buffers=", 0) == 0) {
+      options->app.pipeline.buffers_per_producer =
+          std::max(1, atoi(value.c_str()));
+    } else if (arg.rfind("--frame-policy=", 0) == 0) {
+      if (value == "backpressure") {
+        options->app.pipeline.policy = FramePolicy::kBackpressure;
+      } else if (value == "drop-oldest") {
+        options->app.pipeline.policy = FramePolicy::kDropOldest;
+      } else {
+        LOG_E << "invalid frame policy: " << value;
+        return false;
+      }
+    } else if (arg.rfind("--shader-cache=", 0) == 0) {
+      options->app.shader_cache_dir = value;
+    } else if (arg.rfind("--entities=", 0) == 0) {
+      options->app.entities = std::max(0, atoi(value.c_str()));
+    } else if (arg == "--cull") {
+      options->app.cull = true;
+    } else if (arg.rfind("--cull=", 0) == 0) {
+      options->app.cull = true;
+      options->app.cull_threads = std::max(1, atoi(value.c_str()));
+    } else if (arg.rfind("--capture=", 0) == 0) {
+      options->app.capture.path = value;
+      const bool y4m = value.size() > 4 &&
+                       value.compare(value.size() - 4, 4, ".y4m") == 0;
+      options->app.capture.format =
+          y4m ? CaptureFormat::kY4m : CaptureFormat::kRawI420;
+    } else if (arg.rfind("--capture-buffers=", 0) == 0) {
+      options->app.capture.buffers = std::max(1, atoi(value.c_str()));
+    } else if (arg == "--command-buffers") {
+      options->app.command_buffers = true;
+    } else if (arg == "--hud") {
+      options->app.hud = true;
+    } else if (arg == "--sync-load") {
+      options->app.sync_load = true;
+    } else if (arg == "--on-demand") {
+      options->app.on_demand = true;
+    } else if (arg.rfind("--texture=", 0) == 0) {
+      options->app.texture = value;
+    } else if (arg.rfind("--mesh=", 0) == 0) {
+      options->app.mesh = value;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      options->trace_path = value;
+    } else if (arg.rfind("--trace-capacity=", 0) == 0) {
+      options->trace_capacity = strtoull(value.c_str(), nullptr, 10);
+    } else if (arg.rfind("--bench=", 0) == 0) {
+      options->bench = value;
+    } else if (arg.rfind("--bench-count=", 0) == 0) {
+      options->bench_options.count = atoi(value.c_str());
+    } else if (arg.rfind("--bench-iterations=", 0) == 0) {
+      options->bench_options.iterations = atoi(value.c_str());
+    } else if (arg.rfind("--regress=", 0) == 0) {
+      options->regress.dir = value;
+    } else if (arg.rfind("--regress-baseline=", 0) == 0) {
+      options->regress.baseline_dir = value;
+    } else if (arg == "--regress-update") {
+      options->regress.update = true;
+    } else if (arg == "--regress-update-baseline") {
+      options->regress.update_baseline = true;
+    } else if (arg.rfind("--regress-frames=", 0) == 0) {
+      options->regress.frames = atoi(value.c_str());
+    } else if (arg.rfind("--regress-threshold=", 0) == 0) {
+      options->regress.threshold = atof(value.c_str());
+    } else if (arg.rfind("--regress-tolerance=", 0) == 0) {
+      options->regress.tolerance = atoi(value.c_str());
+    } else if (arg.rfind("--regress-scene=", 0) == 0) {
+      options->regress.scene = value;
+    } else if (arg == "--farm") {
+      options->farm = true;
+    } else if (arg.rfind("--farm-workers=", 0) == 0) {
+      options->farm_options.workers = std::max(0, atoi(value.c_str()));
+    } else if (arg.rfind("--farm-jobs=", 0) == 0) {
+      // a count, or a job file
+      if (!value.empty() &&
+          value.find_first_not_of("0123456789") == std::string::npos)
+        options->farm_options.jobs = atoi(value.c_str());
+      else
+        options->farm_options.jobs_path = value;
+    } else if (arg.rfind("--farm-frames=", 0) == 0) {
+      options->farm_options.frames_per_job = std::max(1, atoi(value.c_str()));
+    } else if (arg.rfind("--farm-out=", 0) == 0) {
+      options->farm_options.output_dir = value;
+    } else if (arg == "--farm-scaling") {
+      options->farm_options.scaling = true;
+    } else {
+      LOG_E << "unknown option: " << arg;
+      return false;
+    }
+  }
+  if (options->farm && !options->headless) {
+    LOG_E << "--farm needs --headless";
+    return false;
+  }
+  // an unpaced producer refills every released buffer at once and would
+  // wake an on-demand loop all the time: there, producers run only when
+  // asked for, and then at the display rate unless paced otherwise
+  FramePipelineConfig &pipeline = options->app.pipeline;
+  if (options->app.on_demand) {
+    if (!producers_given)
+      pipeline.producers = 0;
+    if (pipeline.producer_fps <= 0)
+      pipeline.producer_fps = scheduler.fps;
+  }
+  options->farm_options.entities = options->app.entities;
+  options->farm_options.texture = options->app.texture;
+  return true;
+}
+
+} // namespace
+
 int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, &options)) {
+    std::cerr << "usage: " << argv[0] << " " << kUsage << std::endl;
+    std::cerr << "benchmarks:" << std::endl;
+    Bench::list(std::cerr);
+    return 1;
+  }
+  Logging::start(options.logging);
 
-  AWindowX11 window_x11;
-  if (!window_x11.initialize()) {
-    return 2;
+  if (!options.trace_path.empty()) {
+    Trace::start(options.trace_capacity);
   }
 
+  AWindowX11 window_x11;
   AEgl egl;
-  if (!egl.initialize(window_x11.getNativeDisplay(),
-                      window_x11.getNativeWindow())) {
-    return 2;
+  if (options.headless) {
+    if (!egl.initializeOffscreen(options.width, options.height)) {
+      return 2;
+    }
+  } else {
+    if (!window_x11.initialize()) {
+      return 2;
+    }
+    if (!egl.initialize(window_x11.getNativeDisplay(),
+                        window_x11.getNativeWindow())) {
+      return 2;
+    }
   }
 
-  App::mainloop(egl.getDisplay(), egl.getSurface());
+  if (!options.bench.empty()) {
+    return Bench::run(options.bench, options.bench_options) ? 0 : 1;
+  }
+  if (!options.regress.dir.empty()) {
+    switch (Regression::run(options.regress)) {
+    case Regression::Result::kPassed:
+      return 0;
+    case Regression::Result::kNoBaseline:
+      return Regression::kSkipExitCode;
+    case Regression::Result::kFailed:
+      break;
+    }
+    return 1;
+  }
+  if (options.farm) {
+    return RenderFarm::run(egl, options.farm_options) ? 0 : 1;
+  }
 
+  App::mainloop(egl, options.headless ? nullptr : &window_x11, options.app);
+
+  if (Trace::enabled()) {
+    Trace::stop();
+    Trace::printSummary(std::cout);
+    Trace::writeChromeTrace(options.trace_path.c_str());
+  }
+
+  const Logging::Stats log_stats = Logging::stats();
+  if (log_stats.dropped || log_stats.truncated) {
+    std::cout << "log: written=" << log_stats.written
+              << " dropped=" << log_stats.dropped
+              << " truncated=" << log_stats.truncated << std::endl;
+  }
   std::cout << "quit" << std::endl;
 
   return 0;
@@ -0,0 +1,185 @@
+// Offline mesh importer: mesh-import [--no-optimize] [--chunk-vertices=N]
+// in.obj out.mesh
+// Triangulates the faces of a Wavefront OBJ file, reorders them for the
+// vertex cache and writes the quantized .mesh that app-main --mesh loads.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/clock.h"
+#include "base/logging.h"
+#include "gles2/mesh_format.h"
+
+namespace {
+
+// v/vt/vn of one face corner, 0-based; -1 when absent
+struct Corner {
+  long v = -1, vt = -1, vn = -1;
+  bool operator==(const Corner &o) const {
+    return v == o.v && vt == o.vt && vn == o.vn;
+  }
+};
+
+struct CornerHash {
+  size_t operator()(const Corner &c) const {
+    return std::hash<long>()(c.v) ^ (std::hash<long>()(c.vt) * 31) ^
+           (std::hash<long>()(c.vn) * 1000003);
+  }
+};
+
+// OBJ indices are 1-based, or relative to the end when negative
+long resolve(long index, size_t count) {
+  return index < 0 ? static_cast<long>(count) + index : index - 1;
+}
+
+bool inRange(long index, size_t count) {
+  return index >= 0 && index < static_cast<long>(count);
+}
+
+bool readObj(const std::string &path, MeshFormat::Source *source) {
+  std::ifstream in(path);
+  if (!in) {
+    LOG_E << "cannot read " << path;
+    return false;
+  }
+  std::vector<float> positions, uvs, normals;
+  std::unordered_map<Corner, uint32_t, CornerHash> vertices;
+  std::vector<Corner> corners;
+  bool has_uvs = true, has_normals = true;
+  std::string line;
+  for (int number = 1; std::getline(in, line); ++number) {
+    const char *p = line.c_str();
+    char *end;
+    if (line.rfind("v ", 0) == 0 || line.rfind("vn ", 0) == 0) {
+      std::vector<float> &out = line[1] == 'n' ? normals : positions;
+      p += line[1] == 'n' ? 3 : 2;
+      for (int c = 0; c < 3; ++c, p = end)
+        out.push_back(strtof(p, &end));
+    } else if (line.rfind("vt ", 0) == 0) {
+      p += 3;
+      for (int c = 0; c < 2; ++c, p = end)
+        uvs.push_back(strtof(p, &end));
+    } else if (line.rfind("f ", 0) == 0) {
+      corners.clear();
+      p += 2;
+      for (;;) {
+        Corner corner;
+        corner.v = strtol(p, &end, 10);
+        if (end == p)
+          break;
+        p = end;
+        if (*p == '/') {
+          if (*++p != '/') {
+            corner.vt = strtol(p, &end, 10);
+            p = end;
+          } else {
+            corner.vt = 0;
+          }
+          if (*p == '/') {
+            corner.vn = strtol(++p, &end, 10);
+            p = end;
+          } else {
+            corner.vn = 0;
+          }
+        } else {
+          corner.vt = corner.vn = 0;
+        }
+        // 0 is absent; any other index, relative ones included, has to
+        // resolve to an element read so far
+        const bool vt = corner.vt != 0, vn = corner.vn != 0;
+        corner.v = resolve(corner.v, positions.size() / 3);
+        corner.vt = vt ? resolve(corner.vt, uvs.size() / 2) : -1;
+        corner.vn = vn ? resolve(corner.vn, normals.size() / 3) : -1;
+        if (!inRange(corner.v, positions.size() / 3) ||
+            (vt && !inRange(corner.vt, uvs.size() / 2)) ||
+            (vn && !inRange(corner.vn, normals.size() / 3))) {
+          LOG_E << path << ":" << number << ": index out of range";
+          return false;
+        }
+        has_uvs = has_uvs && corner.vt >= 0;
+        has_normals = has_normals && corner.vn >= 0;
+        corners.push_back(corner);
+      }
+      // polygons as fans
+      for (size_t i = 2; i < corners.size(); ++i) {
+        for (const Corner &corner : {corners[0], corners[i - 1], corners[i]}) {
+          auto inserted = vertices.emplace(corner, vertices.size());
+          source->indices.push_back(inserted.first->second);
+        }
+      }
+    }
+  }
+  if (source->indices.empty()) {
+    LOG_E << path << ": no faces";
+    return false;
+  }
+
+  const size_t count = vertices.size();
+  source->positions.resize(count * 3);
+  if (has_uvs)
+    source->uvs.resize(count * 2);
+  if (has_normals)
+    source->normals.resize(count * 3);
+  for (const auto &[corner, index] : vertices) {
+    std::copy_n(&positions[corner.v * 3], 3, &source->positions[index * 3]);
+    if (has_uvs)
+      std::copy_n(&uvs[corner.vt * 2], 2, &source->uvs[index * 2]);
+    if (has_normals)
+      std::copy_n(&normals[corner.vn * 3], 3, &source->normals[index * 3]);
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  MeshFormat::EncodeOptions options;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--no-optimize") {
+      options.optimize = false;
+    } else if (arg.rfind("--chunk-vertices=", 0) == 0) {
+      options.max_chunk_vertices =
+          std::clamp(atoi(arg.c_str() + 17), 3, 65536);
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.size() != 2) {
+    std::cerr << "usage: " << argv[0]
+              << " [--no-optimize] [--chunk-vertices=N] in.obj out.mesh"
+              << std::endl;
+    return 1;
+  }
+
+  const int64_t begin = monotonicNowNs();
+  MeshFormat::Source source;
+  if (!readObj(paths[0], &source))
+    return 1;
+  const int64_t parsed = monotonicNowNs();
+  MeshFormat::EncodeStats stats;
+  const std::vector<uint8_t> data =
+      MeshFormat::encode(source, options, &stats);
+  const int64_t encoded = monotonicNowNs();
+  if (!MeshFormat::write(paths[1], data))
+    return 1;
+
+  std::cout << paths[1] << ": " << stats.triangles << " triangles, "
+            << stats.vertices << " vertices in " << stats.chunks
+            << " chunk(s), " << data.size() << " bytes ("
+            << source.vertexCount() * 8 * sizeof(float) +
+                   source.indices.size() * sizeof(uint32_t)
+            << " as floats and 32-bit indices)" << std::endl
+            << "  ACMR fifo16 " << stats.acmr16_before << " -> "
+            << stats.acmr16 << ", fifo32 " << stats.acmr32_before << " -> "
+            << stats.acmr32 << std::endl
+            << "  parse_ms=" << (parsed - begin) / 1e6
+            << " encode_ms=" << (encoded - parsed) / 1e6 << std::endl;
+  return 0;
+}
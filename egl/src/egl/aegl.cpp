@@ -1,19 +1,60 @@
 
+#include <cstring>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
 #include "egl/aegl.h"
 #include "base/logging.h"
 
+namespace {
+
+// EGL_NO_DISPLAY: client extensions
+bool hasExtension(EGLDisplay display, const char *name) {
+  const char *exts = eglQueryString(display, EGL_EXTENSIONS);
+  if (!exts)
+    return false;
+  const size_t len = strlen(name);
+  for (const char *p = exts; (p = strstr(p, name)) != nullptr; p += len) {
+    if ((p == exts || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+      return true;
+  }
+  return false;
+}
+
+EGLDisplay getOffscreenDisplay() {
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (getPlatformDisplay &&
+      hasExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                            EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY)
+      return display;
+  }
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+} // namespace
+
 AEgl::AEgl() {}
 
 AEgl::~AEgl() {
-  eglDestroyContext(display_, context_);
-  eglDestroySurface(display_, surface_);
-  eglTerminate(display_);
+  if (display_ == EGL_NO_DISPLAY)
+    return;
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (context_ != EGL_NO_CONTEXT)
+    eglDestroyContext(display_, context_);
+  if (surface_ != EGL_NO_SURFACE)
+    eglDestroySurface(display_, surface_);
+  if (owns_display_)
+    eglTerminate(display_);
+  else
+    eglReleaseThread();
 }
 
-bool AEgl::initialize(void *nativeDisplay, void *nativeWindow) {
-
-  display_ =
-      eglGetDisplay(reinterpret_cast<EGLNativeDisplayType>(nativeDisplay));
+bool AEgl::initializeDisplay(EGLDisplay display) {
+  display_ = display;
 
   if (display_ == EGL_NO_DISPLAY) {
     LOG_E << "eglGetDisplay";
@@ -22,22 +63,56 @@ bool AEgl::initialize(void *nativeDisplay, void *nativeWindow) {
 
   if (!eglInitialize(display_, nullptr, nullptr)) {
     LOG_E << "eglInitialize";
+    display_ = EGL_NO_DISPLAY;
     return false;
   }
+  return true;
+}
 
-  EGLint attr[] = {EGL_BUFFER_SIZE, 16, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+bool AEgl::chooseConfig(EGLint surface_type, EGLConfig *config) {
+  EGLint attr[] = {EGL_BUFFER_SIZE,
+                   16,
+                   EGL_DEPTH_SIZE,
+                   16,
+                   EGL_RENDERABLE_TYPE,
+                   EGL_OPENGL_ES2_BIT,
+                   EGL_SURFACE_TYPE,
+                   surface_type,
                    EGL_NONE};
-  EGLConfig config = nullptr;
   EGLint numConfigs = 0;
-  if (!eglChooseConfig(display_, attr, &config, 1, &numConfigs)) {
+  if (!eglChooseConfig(display_, attr, config, 1, &numConfigs)) {
     LOG_E << "eglChooseConfig";
     return false;
   }
   if (numConfigs != 1) {
-    LOG_E << "eglChooseConfig";
-    std::cerr << "Error numConfigs." << std::endl;
+    LOG_E << "eglChooseConfig numConfigs=" << numConfigs;
     return false;
   }
+  return true;
+}
+
+bool AEgl::createContext(EGLConfig config, EGLContext share_context) {
+  EGLint ctxattr[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+  context_ = eglCreateContext(display_, config, share_context, ctxattr);
+  if (context_ == EGL_NO_CONTEXT) {
+    LOG_E << "eglCreateContext error=" << eglGetError();
+    return false;
+  }
+  if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+    LOG_E << "eglMakeCurrent error=" << eglGetError();
+    return false;
+  }
+  return true;
+}
+
+bool AEgl::initialize(void *nativeDisplay, void *nativeWindow) {
+  if (!initializeDisplay(
+          eglGetDisplay(reinterpret_cast<EGLNativeDisplayType>(nativeDisplay))))
+    return false;
+
+  EGLConfig config = nullptr;
+  if (!chooseConfig(EGL_WINDOW_BIT, &config))
+    return false;
 
   surface_ = eglCreateWindowSurface(
       display_, config, reinterpret_cast<EGLNativeWindowType>(nativeWindow),
@@ -47,17 +122,51 @@ bool AEgl::initialize(void *nativeDisplay, void *nativeWindow) {
     return false;
   }
 
-  EGLint ctxattr[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
-  context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, ctxattr);
-  if (context_ == EGL_NO_CONTEXT) {
-    LOG_E << "eglCreateContext error=" << eglGetError();
+  return createContext(config);
+}
+
+bool AEgl::initializeOffscreen(int width, int height) {
+  if (!initializeDisplay(getOffscreenDisplay()))
     return false;
+
+  EGLConfig config = nullptr;
+  if (!chooseConfig(EGL_PBUFFER_BIT, &config))
+    return false;
+
+  return createPbuffer(config, width, height) && createContext(config);
+}
+
+bool AEgl::initializeShared(const AEgl &share, int width, int height) {
+  display_ = share.display_;
+  owns_display_ = false;
+  EGLConfig config = nullptr;
+  if (!chooseConfig(EGL_PBUFFER_BIT, &config))
+    return false;
+  if (width == 0 && height == 0) {
+    if (!hasExtension("EGL_KHR_surfaceless_context"))
+      width = height = 1;
+  }
+  if (width > 0 || height > 0) {
+    if (!createPbuffer(config, width, height))
+      return false;
   }
-  eglMakeCurrent(display_, surface_, surface_, context_);
+  return createContext(config, share.context_);
+}
 
+bool AEgl::createPbuffer(EGLConfig config, int width, int height) {
+  EGLint pbattr[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+  surface_ = eglCreatePbufferSurface(display_, config, pbattr);
+  if (surface_ == EGL_NO_SURFACE) {
+    LOG_E << "eglCreatePbufferSurface error=" << eglGetError();
+    return false;
+  }
   return true;
 }
 
 EGLDisplay AEgl::getDisplay() const { return display_; }
 
 EGLSurface AEgl::getSurface() const { return surface_; }
+
+bool AEgl::hasExtension(const char *name) const {
+  return ::hasExtension(display_, name);
+}
@@ -8,14 +8,32 @@ public:
   AEgl();
   ~AEgl();
   bool initialize(void *eglNativeDisplay, void *eglNativeWindow);
+  // headless: no native window is needed. A surfaceless platform display
+  // (or the default one) is opened and a pbuffer is used as the surface.
+  bool initializeOffscreen(int width, int height);
+  // another pbuffer and context on |share|'s display, in its share group
+  // (textures, buffers and programs are visible to both). Current on the
+  // calling thread. EGL hands out one display per process, so only |share|
+  // terminates it. 0x0 (for a context that only loads resources) creates
+  // no surface where EGL_KHR_surfaceless_context allows.
+  bool initializeShared(const AEgl &share, int width, int height);
 
   EGLDisplay getDisplay() const;
   EGLSurface getSurface() const;
+  // of the display
+  bool hasExtension(const char *name) const;
 
 private:
-  EGLDisplay display_;
-  EGLContext context_;
-  EGLSurface surface_;
+  bool initializeDisplay(EGLDisplay display);
+  bool chooseConfig(EGLint surface_type, EGLConfig *config);
+  bool createContext(EGLConfig config,
+                     EGLContext share_context = EGL_NO_CONTEXT);
+  bool createPbuffer(EGLConfig config, int width, int height);
+
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  bool owns_display_ = true;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  EGLSurface surface_ = EGL_NO_SURFACE;
 };
 
-#endif // EGL_SRC_EGL_EGL_H_
\ No newline at end of file
+#endif // EGL_SRC_EGL_EGL_H_
@@ -0,0 +1,32 @@
+#ifndef EGL_SRC_GLES2_BITMAP_FONT_H_
+#define EGL_SRC_GLES2_BITMAP_FONT_H_
+
+#include <cstdint>
+
+// The built-in font: printable ASCII on an 8x8 grid (the public domain
+// font8x8 set), and the signed distance fields the text renderer draws it
+// from. No GL here.
+namespace BitmapFont {
+
+constexpr int kCells = 8;
+constexpr uint32_t kFirst = 0x20;
+constexpr uint32_t kLast = 0x7e;
+// drawn for code points outside kFirst..kLast
+constexpr uint32_t kFallback = '?';
+
+// the kCells rows of |c|, top first, bit 0 leftmost
+const uint8_t *rows(uint32_t c);
+
+// the distance field of a glyph: kTexelsPerCell texels per grid cell and
+// kSpread texels of distance around the grid, one byte per texel
+constexpr int kTexelsPerCell = 4;
+constexpr int kSpread = 4;
+constexpr int kSdfSize = kCells * kTexelsPerCell + 2 * kSpread;
+
+// writes kSdfSize x kSdfSize texels of |c| to |out|: 0.5 (128) on the
+// outline, rising inside and falling outside by 0.5 over kSpread texels
+void rasterizeSdf(uint32_t c, uint8_t *out);
+
+} // namespace BitmapFont
+
+#endif // EGL_SRC_GLES2_BITMAP_FONT_H_
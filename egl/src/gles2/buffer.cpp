@@ -0,0 +1,129 @@
+#include <cstring>
+#include <utility>
+
+#include "base/logging.h"
+#include "gles2/buffer.h"
+#include "gles2/state.h"
+#include "gles2/utils.h"
+
+GlES2Buffer::~GlES2Buffer() {
+  if (buffer_) {
+    GlES2State::current().onDeleteBuffer(buffer_);
+    glDeleteBuffers(1, &buffer_);
+  }
+}
+
+GlES2Buffer::GlES2Buffer(GlES2Buffer &&other)
+    : target_(other.target_), usage_(other.usage_),
+      buffer_(std::exchange(other.buffer_, 0)),
+      size_(std::exchange(other.size_, 0)) {}
+
+GlES2Buffer &GlES2Buffer::operator=(GlES2Buffer &&other) {
+  if (this != &other) {
+    if (buffer_) {
+      GlES2State::current().onDeleteBuffer(buffer_);
+      glDeleteBuffers(1, &buffer_);
+    }
+    target_ = other.target_;
+    usage_ = other.usage_;
+    buffer_ = std::exchange(other.buffer_, 0);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+GLenum GlES2Buffer::glUsage() const {
+  switch (usage_) {
+  case Usage::kStatic:
+    return GL_STATIC_DRAW;
+  case Usage::kDynamic:
+    return GL_DYNAMIC_DRAW;
+  case Usage::kStream:
+    return GL_STREAM_DRAW;
+  }
+  return GL_STATIC_DRAW;
+}
+
+bool GlES2Buffer::initialize(GLsizeiptr size, const void *data) {
+  if (!buffer_)
+    glGenBuffers(1, &buffer_);
+  if (!buffer_) {
+    LOG_E << "glGenBuffers";
+    return false;
+  }
+  bind();
+  glBufferData(target_, size, data, glUsage());
+  size_ = size;
+  return checkGLES2Error();
+}
+
+void GlES2Buffer::bind() const {
+  GlES2State::current().bindBuffer(target_, buffer_);
+}
+
+void GlES2Buffer::orphan() {
+  bind();
+  glBufferData(target_, size_, nullptr, glUsage());
+}
+
+void GlES2Buffer::update(const void *data, GLsizeiptr size, GLintptr offset) {
+  if (offset + size > size_) {
+    // grow; anything outside the new range is lost
+    initialize(offset + size, nullptr);
+  } else if (usage_ == Usage::kStream) {
+    orphan();
+  } else {
+    bind();
+  }
+  glBufferSubData(target_, offset, size, data);
+}
+
+bool GlES2RingBuffer::initialize(GLsizeiptr capacity) {
+  staging_.resize(capacity);
+  head_ = 0;
+  flushed_ = 0;
+  return buffer_.initialize(capacity, nullptr);
+}
+
+void *GlES2RingBuffer::allocate(GLsizeiptr size, GLintptr *offset,
+                                GLsizeiptr alignment) {
+  if (size > capacity())
+    return nullptr;
+  GLintptr begin = (head_ + alignment - 1) / alignment * alignment;
+  if (begin + size > capacity()) {
+    flush();
+    reset();
+    begin = 0;
+  }
+  head_ = begin + size;
+  *offset = begin;
+  return staging_.data() + begin;
+}
+
+GLintptr GlES2RingBuffer::push(const void *data, GLsizeiptr size,
+                               GLsizeiptr alignment) {
+  GLintptr offset = -1;
+  void *dst = allocate(size, &offset, alignment);
+  if (dst)
+    memcpy(dst, data, size);
+  return offset;
+}
+
+void GlES2RingBuffer::flush() {
+  if (head_ == flushed_)
+    return;
+  if (flushed_ == 0) {
+    buffer_.orphan();
+    ++orphans_;
+  } else {
+    buffer_.bind();
+  }
+  glBufferSubData(buffer_.target(), flushed_, head_ - flushed_,
+                  staging_.data() + flushed_);
+  flushed_ = head_;
+}
+
+void GlES2RingBuffer::reset() {
+  head_ = 0;
+  flushed_ = 0;
+}
@@ -0,0 +1,83 @@
+#ifndef EGL_SRC_GLES2_BUFFER_H_
+#define EGL_SRC_GLES2_BUFFER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+// owns one VBO/IBO name
+class GlES2Buffer {
+public:
+  enum class Usage {
+    kStatic,  // uploaded once
+    kDynamic, // updated in place with glBufferSubData
+    kStream,  // respecified every update; the old storage is orphaned
+  };
+
+  GlES2Buffer(GLenum target = GL_ARRAY_BUFFER, Usage usage = Usage::kStatic)
+      : target_(target), usage_(usage){};
+  ~GlES2Buffer();
+  GlES2Buffer(GlES2Buffer &&other);
+  GlES2Buffer &operator=(GlES2Buffer &&other);
+  GlES2Buffer(const GlES2Buffer &) = delete;
+  GlES2Buffer &operator=(const GlES2Buffer &) = delete;
+
+  // allocates |size| bytes of storage. |data| may be null.
+  bool initialize(GLsizeiptr size, const void *data = nullptr);
+
+  void bind() const;
+  // kStream orphans the whole storage before writing
+  void update(const void *data, GLsizeiptr size, GLintptr offset = 0);
+  // glBufferData(NULL): the driver hands out fresh storage instead of
+  // waiting for draws that still read the old one
+  void orphan();
+
+  GLuint buffer() const { return buffer_; }
+  GLenum target() const { return target_; }
+  GLsizeiptr size() const { return size_; }
+
+private:
+  GLenum glUsage() const;
+
+  GLenum target_;
+  Usage usage_;
+  GLuint buffer_ = 0;
+  GLsizeiptr size_ = 0;
+};
+
+// suballocates per-frame data out of one stream buffer. Allocations are
+// staged in client memory and uploaded by flush() with one glBufferSubData,
+// so draws must be issued after the flush. When the storage is full (or
+// after reset()) it is orphaned and allocation restarts at offset 0; ranges
+// handed out before that must already have been drawn.
+class GlES2RingBuffer {
+public:
+  GlES2RingBuffer(GLenum target = GL_ARRAY_BUFFER)
+      : buffer_(target, GlES2Buffer::Usage::kStream){};
+
+  bool initialize(GLsizeiptr capacity);
+
+  // reserves |size| bytes and returns where to write them. |*offset| gets
+  // the byte offset in buffer(). nullptr if |size| exceeds the capacity.
+  void *allocate(GLsizeiptr size, GLintptr *offset, GLsizeiptr alignment = 4);
+  // allocate() + copy. -1 if |size| exceeds the capacity.
+  GLintptr push(const void *data, GLsizeiptr size, GLsizeiptr alignment = 4);
+  // uploads everything allocated since the last flush; leaves buffer() bound
+  void flush();
+  // new frame: the next flush orphans the storage and starts at 0
+  void reset();
+
+  const GlES2Buffer &buffer() const { return buffer_; }
+  GLsizeiptr capacity() const { return buffer_.size(); }
+  uint64_t orphanCount() const { return orphans_; }
+
+private:
+  GlES2Buffer buffer_;
+  std::vector<uint8_t> staging_;
+  GLintptr head_ = 0;
+  GLintptr flushed_ = 0;
+  uint64_t orphans_ = 0;
+};
+
+#endif // EGL_SRC_GLES2_BUFFER_H_
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstring>
+
+#include "base/trace.h"
+#include "gles2/command_buffer.h"
+#include "gles2/state.h"
+
+uint64_t GlES2CommandBuffer::sortKey(int layer, GLuint program,
+                                     GLuint texture, float depth) {
+  const uint64_t z = static_cast<uint64_t>(
+      std::clamp(depth, 0.0f, 1.0f) * 0xffffff);
+  return (static_cast<uint64_t>(layer & 0xff) << 56) |
+         (static_cast<uint64_t>(program & 0xffff) << 40) |
+         (static_cast<uint64_t>(texture & 0xffff) << 24) | z;
+}
+
+void GlES2CommandBuffer::clear() {
+  commands_.clear();
+  floats_.clear();
+  packets_.clear();
+  packet_begin_ = 0;
+}
+
+GlES2CommandBuffer::Command &GlES2CommandBuffer::push(Op op) {
+  commands_.push_back(Command());
+  commands_.back().op = op;
+  return commands_.back();
+}
+
+void GlES2CommandBuffer::useProgram(GLuint program) {
+  push(Op::kUseProgram).name = program;
+}
+
+void GlES2CommandBuffer::bindTexture(int unit, GLuint texture) {
+  Command &c = push(Op::kBindTexture);
+  c.location = unit;
+  c.name = texture;
+}
+
+void GlES2CommandBuffer::bindBuffer(GLenum target, GLuint buffer) {
+  Command &c = push(Op::kBindBuffer);
+  c.target = target;
+  c.name = buffer;
+}
+
+void GlES2CommandBuffer::enableVertexAttribArray(GLuint index) {
+  push(Op::kEnableAttrib).location = index;
+}
+
+void GlES2CommandBuffer::vertexAttribPointer(GLuint index, GLint size,
+                                             GLenum type,
+                                             GLboolean normalized,
+                                             GLsizei stride,
+                                             uintptr_t offset) {
+  Command &c = push(Op::kAttribPointer);
+  c.location = index;
+  c.size = size;
+  c.target = type;
+  c.flag = normalized;
+  c.data =
+      (static_cast<uint64_t>(stride) << 32) | static_cast<uint32_t>(offset);
+}
+
+void GlES2CommandBuffer::uniform1i(GLint location, GLint value) {
+  Command &c = push(Op::kUniform1i);
+  c.location = location;
+  c.name = value;
+}
+
+void GlES2CommandBuffer::uniformMatrix4fv(GLint location,
+                                          const GLfloat *value) {
+  Command &c = push(Op::kUniformMatrix4fv);
+  c.location = location;
+  c.data = floats_.size();
+  floats_.insert(floats_.end(), value, value + 16);
+}
+
+GLfloat *GlES2CommandBuffer::uniform4fv(GLint location, GLsizei count) {
+  Command &c = push(Op::kUniform4fv);
+  c.location = location;
+  c.name = count;
+  c.data = floats_.size();
+  floats_.resize(floats_.size() + count * 4);
+  return floats_.data() + c.data;
+}
+
+void GlES2CommandBuffer::setEnabled(GLenum capability, bool enabled) {
+  Command &c = push(Op::kSetEnabled);
+  c.target = capability;
+  c.flag = enabled;
+}
+
+void GlES2CommandBuffer::depthFunc(GLenum func) {
+  push(Op::kDepthFunc).target = func;
+}
+
+void GlES2CommandBuffer::drawArrays(uint64_t key, GLenum mode, GLint first,
+                                    GLsizei count) {
+  Command &c = push(Op::kDrawArrays);
+  c.target = mode;
+  c.name = count;
+  c.data = first;
+  endPacket(key);
+}
+
+void GlES2CommandBuffer::drawElements(uint64_t key, GLenum mode,
+                                      GLsizei count, GLenum type,
+                                      uintptr_t offset) {
+  Command &c = push(Op::kDrawElements);
+  c.target = mode;
+  c.name = count;
+  c.location = type;
+  c.data = offset;
+  endPacket(key);
+}
+
+void GlES2CommandBuffer::endPacket(uint64_t key) {
+  const uint32_t end = commands_.size();
+  packets_.push_back({key, packet_begin_, end - packet_begin_});
+  packet_begin_ = end;
+}
+
+void GlES2CommandBuffer::sort() {
+  TRACE_SCOPE("GlES2CommandBuffer::sort");
+  // packets are recorded in order of |first|: a stable sort without the
+  // heap buffer of std::stable_sort
+  std::sort(packets_.begin(), packets_.end(),
+            [](const Packet &a, const Packet &b) {
+              return a.key != b.key ? a.key < b.key : a.first < b.first;
+            });
+}
+
+void GlES2CommandBuffer::replay() {
+  TRACE_SCOPE("GlES2CommandBuffer::replay");
+  GlES2State &gl = GlES2State::current();
+  GLuint program = 0;
+  GLuint texture = 0;
+  for (const Packet &packet : packets_) {
+    const Command *c = commands_.data() + packet.first;
+    for (const Command *end = c + packet.count; c != end; ++c) {
+      switch (c->op) {
+      case Op::kUseProgram:
+        stats_.program_switches += c->name != program;
+        program = c->name;
+        gl.useProgram(c->name);
+        break;
+      case Op::kBindTexture:
+        stats_.texture_switches += c->name != texture;
+        texture = c->name;
+        gl.bindTexture(c->location, c->name);
+        break;
+      case Op::kBindBuffer:
+        gl.bindBuffer(c->target, c->name);
+        break;
+      case Op::kEnableAttrib:
+        gl.enableVertexAttribArray(c->location);
+        break;
+      case Op::kAttribPointer:
+        gl.vertexAttribPointer(
+            c->location, c->size, c->target, c->flag,
+            static_cast<GLsizei>(c->data >> 32),
+            reinterpret_cast<const void *>(c->data & 0xffffffff));
+        break;
+      case Op::kUniform1i:
+        gl.uniform1i(c->location, c->name);
+        break;
+      case Op::kUniformMatrix4fv:
+        gl.uniformMatrix4fv(c->location, floats_.data() + c->data);
+        break;
+      case Op::kUniform4fv:
+        glUniform4fv(c->location, c->name, floats_.data() + c->data);
+        break;
+      case Op::kSetEnabled:
+        gl.setEnabled(c->target, c->flag);
+        break;
+      case Op::kDepthFunc:
+        gl.depthFunc(c->target);
+        break;
+      case Op::kDrawArrays:
+        glDrawArrays(c->target, c->data, c->name);
+        ++stats_.draws;
+        break;
+      case Op::kDrawElements:
+        glDrawElements(c->target, c->name, c->location,
+                       reinterpret_cast<const void *>(c->data));
+        ++stats_.draws;
+        break;
+      }
+    }
+  }
+  stats_.commands += commands_.size();
+}
@@ -0,0 +1,112 @@
+#ifndef EGL_SRC_GLES2_COMMAND_BUFFER_H_
+#define EGL_SRC_GLES2_COMMAND_BUFFER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+// GL work recorded as plain structs on any thread, sorted and replayed
+// later on the thread of the context. Recording makes no GL calls.
+//
+// The commands up to and including a draw form its packet, and packets are
+// replayed in sort key order. A packet may be moved anywhere in its layer,
+// so it must set all the state its draw needs; replay goes through
+// GlES2State, which drops what the previous packet already set. Sorting
+// then turns repeated state into elided calls.
+class GlES2CommandBuffer {
+public:
+  struct Stats {
+    uint64_t commands = 0;
+    uint64_t draws = 0;
+    // changes seen while replaying, whatever GlES2State made of them
+    uint64_t program_switches = 0;
+    uint64_t texture_switches = 0;
+  };
+
+  // layer (8 bits), program (16), texture (16), depth (24), high to low.
+  // Layers keep their order (passes that overlap without a depth test);
+  // within a layer draws group by program, then texture, then go front to
+  // back with |depth| in [0, 1]. Names wider than their field only group
+  // less well.
+  static uint64_t sortKey(int layer, GLuint program, GLuint texture,
+                          float depth);
+
+  void clear();
+
+  void useProgram(GLuint program);
+  void bindTexture(int unit, GLuint texture);
+  void bindBuffer(GLenum target, GLuint buffer);
+  void enableVertexAttribArray(GLuint index);
+  // |offset| into the GL_ARRAY_BUFFER bound before it
+  void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                           GLboolean normalized, GLsizei stride,
+                           uintptr_t offset);
+  void uniform1i(GLint location, GLint value);
+  void uniformMatrix4fv(GLint location, const GLfloat *value);
+  // room for |count| vec4s, filled by the caller before the next call
+  GLfloat *uniform4fv(GLint location, GLsizei count);
+  void setEnabled(GLenum capability, bool enabled);
+  void depthFunc(GLenum func);
+
+  // ends the packet
+  void drawArrays(uint64_t key, GLenum mode, GLint first, GLsizei count);
+  void drawElements(uint64_t key, GLenum mode, GLsizei count, GLenum type,
+                    uintptr_t offset);
+
+  // orders the packets by key, recording order among equal keys
+  void sort();
+  // needs the context current; commands after the last draw are dropped
+  void replay();
+
+  size_t packets() const { return packets_.size(); }
+  const Stats &stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  enum class Op : uint8_t {
+    kUseProgram,
+    kBindTexture,
+    kBindBuffer,
+    kEnableAttrib,
+    kAttribPointer,
+    kUniform1i,
+    kUniformMatrix4fv,
+    kUniform4fv,
+    kSetEnabled,
+    kDepthFunc,
+    kDrawArrays,
+    kDrawElements,
+  };
+  // 24 bytes; |data| indexes |floats_| for the uniform arrays
+  struct Command {
+    Op op;
+    uint8_t flag;   // enabled, normalized
+    int16_t size;   // attribute components
+    GLint location; // uniform location, attribute index, texture unit,
+                    // index type
+    GLenum target;  // buffer target, capability, attribute type, draw
+                    // mode, depth func
+    GLuint name;    // program, texture, buffer; uniform value or count;
+                    // vertex count
+    uint64_t data;  // float offset, first vertex, buffer offset (with the
+                    // attribute stride in the high half)
+  };
+  struct Packet {
+    uint64_t key;
+    uint32_t first;
+    uint32_t count;
+  };
+
+  Command &push(Op op);
+  void endPacket(uint64_t key);
+
+  std::vector<Command> commands_;
+  std::vector<GLfloat> floats_;
+  std::vector<Packet> packets_;
+  // first command of the open packet
+  uint32_t packet_begin_ = 0;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_COMMAND_BUFFER_H_
@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "base/logging.h"
+#include "gles2/etc1.h"
+
+namespace {
+
+// modifier pairs {a, b}; texel index 0..3 adds a, b, -a, -b
+const int kModifiers[8][2] = {{2, 8},   {5, 17},  {9, 29},   {13, 42},
+                              {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+const uint8_t kKtxIdentifier[12] = {0xAB, 'K',  'T',  'X',  ' ',  '1',
+                                    '1',  0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t kKtxEndianness = 0x04030201;
+constexpr uint32_t kGlRgb = 0x1907;
+constexpr size_t kKtxHeaderSize = 64;
+constexpr size_t kPkmHeaderSize = 16;
+// larger KTX images are rejected; no GLES2 implementation takes them, and
+// the levels' sizes stay far from overflowing
+constexpr uint32_t kMaxKtxSize = 16384;
+
+uint8_t clamp255(int v) { return static_cast<uint8_t>(std::clamp(v, 0, 255)); }
+
+uint32_t readBe32(const uint8_t *p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+         (uint32_t(p[2]) << 8) | p[3];
+}
+
+uint16_t readBe16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+
+void writeBe32(uint32_t v, uint8_t *p) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+uint32_t readKtx32(const uint8_t *p, bool swap) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+int blocks(int texels) { return (texels + 3) / 4; }
+
+// runs fn(first, last) over [0, count) split across |threads| threads
+template <typename F> void parallelRows(int count, int threads, F &&fn) {
+  threads = std::clamp(threads, 1, std::max(count, 1));
+  if (threads == 1) {
+    fn(0, count);
+    return;
+  }
+  std::vector<std::thread> workers;
+  const int per = (count + threads - 1) / threads;
+  for (int first = 0; first < count; first += per)
+    workers.emplace_back(fn, first, std::min(count, first + per));
+  for (std::thread &t : workers)
+    t.join();
+}
+
+// base colors of both subblocks, expanded to 8 bits
+struct Bases {
+  int color[2][3];
+};
+
+Bases readBases(uint32_t hi) {
+  Bases b;
+  if (hi & 2) {
+    for (int c = 0; c < 3; ++c) {
+      const int shift = 27 - 8 * c;
+      const int base = (hi >> shift) & 0x1f;
+      const int delta = (hi >> (shift - 3)) & 7;
+      const int second = (base + (delta >= 4 ? delta - 8 : delta)) & 0x1f;
+      b.color[0][c] = (base << 3) | (base >> 2);
+      b.color[1][c] = (second << 3) | (second >> 2);
+    }
+  } else {
+    for (int c = 0; c < 3; ++c) {
+      b.color[0][c] = ((hi >> (28 - 8 * c)) & 0xf) * 17;
+      b.color[1][c] = ((hi >> (24 - 8 * c)) & 0xf) * 17;
+    }
+  }
+  return b;
+}
+
+bool inSecondSubblock(bool flip, int x, int y) {
+  return flip ? y >= 2 : x >= 2;
+}
+
+// texels of the block at (bx, by), edge texels repeated past the image
+struct Texels {
+  int rgb[16][3]; // index x * 4 + y, as the block stores them
+};
+
+Texels gather(const uint8_t *rgba, int stride, int width, int height) {
+  Texels t;
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) {
+      const uint8_t *p =
+          rgba + std::min(y, height - 1) * stride + std::min(x, width - 1) * 4;
+      for (int c = 0; c < 3; ++c)
+        t.rgb[x * 4 + y][c] = p[c];
+    }
+  }
+  return t;
+}
+
+int texelError(const int *rgb, const int *base, int modifier) {
+  int error = 0;
+  for (int c = 0; c < 3; ++c) {
+    const int d = clamp255(base[c] + modifier) - rgb[c];
+    error += d * d;
+  }
+  return error;
+}
+
+// best table and texel indices for one subblock around |base|; adds the
+// index bits to |lo| and returns the error
+int fitSubblock(const Texels &t, const int *base, bool flip, int subblock,
+                int *table, uint32_t *lo) {
+  int best = INT_MAX;
+  uint32_t best_bits = 0;
+  for (int tb = 0; tb < 8; ++tb) {
+    const int a = kModifiers[tb][0], b = kModifiers[tb][1];
+    const int modifiers[4] = {a, b, -a, -b};
+    int error = 0;
+    uint32_t bits = 0;
+    for (int i = 0; i < 16 && error < best; ++i) {
+      if (inSecondSubblock(flip, i / 4, i % 4) != (subblock == 1))
+        continue;
+      int texel_best = INT_MAX, index = 0;
+      for (int m = 0; m < 4; ++m) {
+        const int e = texelError(t.rgb[i], base, modifiers[m]);
+        if (e < texel_best) {
+          texel_best = e;
+          index = m;
+        }
+      }
+      error += texel_best;
+      bits |= ((index >> 1) << (16 + i)) | ((index & 1) << i);
+    }
+    if (error < best) {
+      best = error;
+      best_bits = bits;
+      *table = tb;
+    }
+  }
+  *lo |= best_bits;
+  return best;
+}
+
+} // namespace
+
+namespace Etc1 {
+
+size_t encodedSize(int width, int height) {
+  return static_cast<size_t>(blocks(width)) * blocks(height) * 8;
+}
+
+bool parse(const uint8_t *data, size_t size, std::vector<Level> *levels) {
+  levels->clear();
+  if (size >= kPkmHeaderSize && memcmp(data, "PKM 10", 6) == 0) {
+    if (readBe16(data + 6) != 0) {
+      LOG_E << "pkm: unsupported format " << readBe16(data + 6);
+      return false;
+    }
+    Level level;
+    level.width = readBe16(data + 12);
+    level.height = readBe16(data + 14);
+    level.data = data + kPkmHeaderSize;
+    level.size = encodedSize(level.width, level.height);
+    if (level.width == 0 || level.height == 0 ||
+        kPkmHeaderSize + level.size > size) {
+      LOG_E << "pkm: truncated";
+      return false;
+    }
+    levels->push_back(level);
+    return true;
+  }
+
+  if (size < kKtxHeaderSize ||
+      memcmp(data, kKtxIdentifier, sizeof(kKtxIdentifier)) != 0) {
+    LOG_E << "not a ktx or pkm file";
+    return false;
+  }
+  const uint32_t endianness = readKtx32(data + 12, false);
+  if (endianness != kKtxEndianness &&
+      endianness != __builtin_bswap32(kKtxEndianness)) {
+    LOG_E << "ktx: bad endianness";
+    return false;
+  }
+  const bool swap = endianness != kKtxEndianness;
+  auto field = [&](int i) { return readKtx32(data + 12 + 4 * i, swap); };
+  if (field(4) != kInternalFormat) {
+    LOG_E << "ktx: not ETC1 (glInternalFormat " << std::hex << field(4)
+          << std::dec << ")";
+    return false;
+  }
+  if (field(8) > 1 || field(9) > 0 || field(10) != 1) {
+    LOG_E << "ktx: only single 2D images are supported";
+    return false;
+  }
+  if (field(6) == 0 || field(7) == 0 || field(6) > kMaxKtxSize ||
+      field(7) > kMaxKtxSize) {
+    LOG_E << "ktx: bad size " << field(6) << "x" << field(7);
+    return false;
+  }
+  const int width = field(6);
+  const int height = field(7);
+  // down to 1x1, and no further
+  uint32_t max_levels = 1;
+  while ((std::max(width, height) >> max_levels) > 0)
+    ++max_levels;
+  const uint32_t mip_levels = std::max(1u, field(11));
+  if (mip_levels > max_levels) {
+    LOG_E << "ktx: " << mip_levels << " mip levels for " << width << "x"
+          << height;
+    return false;
+  }
+  size_t offset = kKtxHeaderSize + field(12);
+  for (uint32_t l = 0; l < mip_levels; ++l) {
+    if (offset + 4 > size) {
+      LOG_E << "ktx: truncated";
+      return false;
+    }
+    Level level;
+    level.width = std::max(1, width >> l);
+    level.height = std::max(1, height >> l);
+    level.size = readKtx32(data + offset, swap);
+    level.data = data + offset + 4;
+    if (level.size < encodedSize(level.width, level.height) ||
+        offset + 4 + level.size > size) {
+      LOG_E << "ktx: level " << l << " truncated";
+      return false;
+    }
+    levels->push_back(level);
+    offset += 4 + ((level.size + 3) & ~size_t(3));
+  }
+  return !levels->empty();
+}
+
+void decodeBlock(const uint8_t *block, uint8_t *rgba, int stride, int width,
+                 int height) {
+  const uint32_t hi = readBe32(block);
+  const uint32_t lo = readBe32(block + 4);
+  const Bases bases = readBases(hi);
+  const int tables[2] = {static_cast<int>((hi >> 5) & 7),
+                         static_cast<int>((hi >> 2) & 7)};
+  const bool flip = hi & 1;
+  for (int x = 0; x < std::min(width, 4); ++x) {
+    for (int y = 0; y < std::min(height, 4); ++y) {
+      const int i = x * 4 + y;
+      const int index = (((lo >> (16 + i)) & 1) << 1) | ((lo >> i) & 1);
+      const int s = inSecondSubblock(flip, x, y);
+      const int a = kModifiers[tables[s]][index & 1];
+      const int modifier = index & 2 ? -a : a;
+      uint8_t *p = rgba + y * stride + x * 4;
+      for (int c = 0; c < 3; ++c)
+        p[c] = clamp255(bases.color[s][c] + modifier);
+      p[3] = 0xff;
+    }
+  }
+}
+
+void decode(const Level &level, uint8_t *rgba, int threads) {
+  const int bw = blocks(level.width);
+  const int stride = level.width * 4;
+  parallelRows(blocks(level.height), threads, [&](int first, int last) {
+    for (int by = first; by < last; ++by) {
+      for (int bx = 0; bx < bw; ++bx) {
+        decodeBlock(level.data + (static_cast<size_t>(by) * bw + bx) * 8,
+                    rgba + by * 4 * stride + bx * 16, stride,
+                    level.width - bx * 4, level.height - by * 4);
+      }
+    }
+  });
+}
+
+void encodeBlock(const uint8_t *rgba, int stride, int width, int height,
+                 uint8_t *block) {
+  const Texels t = gather(rgba, stride, width, height);
+  int best = INT_MAX;
+  for (int flip = 0; flip < 2; ++flip) {
+    int average[2][3] = {};
+    for (int i = 0; i < 16; ++i) {
+      const int s = inSecondSubblock(flip, i / 4, i % 4);
+      for (int c = 0; c < 3; ++c)
+        average[s][c] += t.rgb[i][c];
+    }
+
+    // differential mode when the 5-bit colors are close enough, and
+    // individual mode always
+    for (int diff = 1; diff >= 0; --diff) {
+      int q[2][3];
+      bool fits = true;
+      for (int s = 0; s < 2; ++s) {
+        for (int c = 0; c < 3; ++c) {
+          const int max = diff ? 31 : 15;
+          q[s][c] = (average[s][c] * max + 8 * 255 / 2) / (8 * 255);
+        }
+      }
+      for (int c = 0; c < 3 && diff; ++c)
+        fits = fits && q[1][c] - q[0][c] >= -4 && q[1][c] - q[0][c] <= 3;
+      if (!fits)
+        continue;
+
+      uint32_t hi = (diff << 1) | flip;
+      for (int c = 0; c < 3; ++c) {
+        if (diff) {
+          hi |= q[0][c] << (27 - 8 * c);
+          hi |= ((q[1][c] - q[0][c]) & 7) << (24 - 8 * c);
+        } else {
+          hi |= q[0][c] << (28 - 8 * c);
+          hi |= q[1][c] << (24 - 8 * c);
+        }
+      }
+      const Bases bases = readBases(hi);
+      uint32_t lo = 0;
+      int tables[2];
+      int error = 0;
+      for (int s = 0; s < 2; ++s)
+        error += fitSubblock(t, bases.color[s], flip, s, &tables[s], &lo);
+      if (error < best) {
+        best = error;
+        hi |= (tables[0] << 5) | (tables[1] << 2);
+        writeBe32(hi, block);
+        writeBe32(lo, block + 4);
+      }
+    }
+  }
+}
+
+std::vector<uint8_t> encode(const uint8_t *rgba, int width, int height,
+                            int threads) {
+  const int bw = blocks(width);
+  std::vector<uint8_t> out(encodedSize(width, height));
+  const int stride = width * 4;
+  parallelRows(blocks(height), threads, [&](int first, int last) {
+    for (int by = first; by < last; ++by) {
+      for (int bx = 0; bx < bw; ++bx) {
+        encodeBlock(rgba + by * 4 * stride + bx * 16, stride, width - bx * 4,
+                    height - by * 4,
+                    out.data() + (static_cast<size_t>(by) * bw + bx) * 8);
+      }
+    }
+  });
+  return out;
+}
+
+bool writeKtx(const std::string &path,
+              const std::vector<std::vector<uint8_t>> &levels, int width,
+              int height) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    LOG_E << "cannot write " << path;
+    return false;
+  }
+  const uint32_t header[13] = {kKtxEndianness,
+                               0, // glType
+                               1, // glTypeSize
+                               0, // glFormat
+                               kInternalFormat,
+                               kGlRgb,
+                               static_cast<uint32_t>(width),
+                               static_cast<uint32_t>(height),
+                               0, // pixelDepth
+                               0, // numberOfArrayElements
+                               1, // numberOfFaces
+                               static_cast<uint32_t>(levels.size()),
+                               0}; // bytesOfKeyValueData
+  bool ok = fwrite(kKtxIdentifier, sizeof(kKtxIdentifier), 1, file) == 1 &&
+            fwrite(header, sizeof(header), 1, file) == 1;
+  // ETC1 levels are whole 8-byte blocks, so no mip padding is needed
+  for (const std::vector<uint8_t> &level : levels) {
+    const uint32_t size = level.size();
+    ok = ok && fwrite(&size, 4, 1, file) == 1 &&
+         fwrite(level.data(), level.size(), 1, file) == 1;
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    LOG_E << "cannot write " << path;
+  return ok;
+}
+
+bool writePkm(const std::string &path, const std::vector<uint8_t> &level,
+              int width, int height) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    LOG_E << "cannot write " << path;
+    return false;
+  }
+  uint8_t header[kPkmHeaderSize] = {'P', 'K', 'M', ' ', '1', '0'};
+  const int sizes[4] = {blocks(width) * 4, blocks(height) * 4, width, height};
+  for (int i = 0; i < 4; ++i) {
+    header[8 + 2 * i] = sizes[i] >> 8;
+    header[9 + 2 * i] = sizes[i] & 0xff;
+  }
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(level.data(), level.size(), 1, file) == 1;
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    LOG_E << "cannot write " << path;
+  return ok;
+}
+
+} // namespace Etc1
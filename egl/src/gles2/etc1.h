@@ -0,0 +1,53 @@
+#ifndef EGL_SRC_GLES2_ETC1_H_
+#define EGL_SRC_GLES2_ETC1_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ETC1 codec and the KTX 1.1 / PKM containers. No GL here, so that the
+// offline encoder links it alone.
+namespace Etc1 {
+
+// GL_ETC1_RGB8_OES
+constexpr uint32_t kInternalFormat = 0x8D64;
+
+// one mip level of 4x4 blocks of 8 bytes
+struct Level {
+  int width = 0;
+  int height = 0;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+};
+
+// bytes of a |width| x |height| level (whole blocks)
+size_t encodedSize(int width, int height);
+
+// the levels of a .ktx (glInternalFormat ETC1) or .pkm file in |data|; they
+// point into |data|
+bool parse(const uint8_t *data, size_t size, std::vector<Level> *levels);
+
+// 4x4 texels of one block into RGBA rows |stride| bytes apart, clipped to
+// |width| x |height| texels
+void decodeBlock(const uint8_t *block, uint8_t *rgba, int stride, int width,
+                 int height);
+// a whole level into tightly packed RGBA, split over |threads| threads by
+// block rows
+void decode(const Level &level, uint8_t *rgba, int threads = 1);
+
+// one block from up to 4x4 RGBA texels (edges are clamped)
+void encodeBlock(const uint8_t *rgba, int stride, int width, int height,
+                 uint8_t *block);
+std::vector<uint8_t> encode(const uint8_t *rgba, int width, int height,
+                            int threads = 1);
+
+bool writeKtx(const std::string &path,
+              const std::vector<std::vector<uint8_t>> &levels, int width,
+              int height);
+bool writePkm(const std::string &path, const std::vector<uint8_t> &level,
+              int width, int height);
+
+} // namespace Etc1
+
+#endif // EGL_SRC_GLES2_ETC1_H_
@@ -0,0 +1,45 @@
+#include "base/clock.h"
+#include "base/trace.h"
+#include "gles2/bitmap_font.h"
+#include "gles2/glyph_cache.h"
+
+bool GlES2GlyphCache::initialize(const Config &config) {
+  GlES2TextureAtlas::Config atlas_config;
+  atlas_config.page_size = config.page_size;
+  atlas_config.max_pages = config.max_pages;
+  atlas_config.format = GL_ALPHA;
+  atlas_config.linear_filter = true;
+  entries_.clear();
+  stats_ = Stats();
+  return atlas_.initialize(atlas_config);
+}
+
+bool GlES2GlyphCache::glyph(uint32_t c, Glyph *out) {
+  ++stats_.lookups;
+  if (c < BitmapFont::kFirst || c > BitmapFont::kLast)
+    c = BitmapFont::kFallback;
+  Entry &entry = entries_[c];
+  if (!atlas_.valid(entry.handle)) {
+    TRACE_SCOPE("GlES2GlyphCache::upload");
+    if (entry.field.empty()) {
+      const int64_t begin = monotonicNowNs();
+      entry.field.resize(BitmapFont::kSdfSize * BitmapFont::kSdfSize);
+      BitmapFont::rasterizeSdf(c, entry.field.data());
+      stats_.rasterize_ns += monotonicNowNs() - begin;
+      ++stats_.rasterized;
+    }
+    entry.handle = atlas_.insert(entry.field.data(), BitmapFont::kSdfSize,
+                                 BitmapFont::kSdfSize);
+    if (entry.handle == GlES2TextureAtlas::kInvalid)
+      return false;
+    ++stats_.uploads;
+  }
+  const GlES2TextureAtlas::Region &region = atlas_.region(entry.handle);
+  out->texture = region.texture;
+  out->u0 = region.u0;
+  out->v0 = region.v0;
+  out->u1 = region.u1;
+  out->v1 = region.v1;
+  out->handle = entry.handle;
+  return true;
+}
@@ -0,0 +1,72 @@
+#ifndef EGL_SRC_GLES2_GLYPH_CACHE_H_
+#define EGL_SRC_GLES2_GLYPH_CACHE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/texture_atlas.h"
+
+// The distance fields of the built-in font (gles2/bitmap_font.h) in a
+// single-channel GlES2TextureAtlas with linear filtering. A glyph is
+// rasterized once, on first use, and its field kept in memory; when the
+// atlas evicts the least recently used page, the glyphs on it are uploaded
+// again from there the next time they are asked for.
+class GlES2GlyphCache {
+public:
+  struct Config {
+    int page_size = 256;
+    // 36 glyphs per page of 256
+    int max_pages = 4;
+  };
+
+  struct Glyph {
+    GLuint texture = 0;
+    // the whole kSdfSize^2 field, spread included
+    float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+    // for touch()
+    GlES2TextureAtlas::Handle handle = GlES2TextureAtlas::kInvalid;
+  };
+
+  struct Stats {
+    uint64_t lookups = 0;
+    uint64_t rasterized = 0;
+    uint64_t uploads = 0; // rasterized ones included
+    int64_t rasterize_ns = 0;
+  };
+
+  bool initialize(const Config &config);
+
+  // |c| in the atlas, marking its page as used. False only when the atlas
+  // cannot take it (a page too small).
+  bool glyph(uint32_t c, Glyph *out);
+  // marks the page of |handle| as used, for callers that keep glyphs
+  // across frames without looking them up
+  void touch(GlES2TextureAtlas::Handle handle) { atlas_.region(handle); }
+  // false once the page of |handle| was evicted
+  bool resident(GlES2TextureAtlas::Handle handle) const {
+    return atlas_.valid(handle);
+  }
+  // changes whenever a page is evicted: glyphs looked up before may then
+  // point at other images
+  uint64_t generation() const { return atlas_.stats().evicted_pages; }
+
+  const Stats &stats() const { return stats_; }
+  const GlES2TextureAtlas::Stats &atlasStats() const {
+    return atlas_.stats();
+  }
+
+private:
+  struct Entry {
+    std::vector<uint8_t> field;
+    GlES2TextureAtlas::Handle handle = GlES2TextureAtlas::kInvalid;
+  };
+
+  GlES2TextureAtlas atlas_;
+  std::unordered_map<uint32_t, Entry> entries_;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_GLYPH_CACHE_H_
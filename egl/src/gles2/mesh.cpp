@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "base/clock.h"
+#include "base/logging.h"
+#include "base/mapped_file.h"
+#include "base/trace.h"
+#include "gles2/mesh.h"
+#include "gles2/state.h"
+
+using MeshFormat::Chunk;
+using MeshFormat::Vertex;
+
+const char *const GlES2Mesh::kVertexShader = R"(
+        attribute vec3 a_position;
+        attribute vec3 a_normal;
+        uniform vec4 u_position_offset;
+        uniform vec4 u_position_scale;
+        uniform mat4 u_model;
+        uniform mat4 u_view_projection;
+        varying lowp float v_light;
+        void main() {
+            vec3 position = u_position_offset.xyz +
+                            a_position * u_position_scale.xyz;
+            gl_Position = u_view_projection * u_model * vec4(position, 1.0);
+            vec3 normal = normalize((u_model * vec4(a_normal, 0.0)).xyz);
+            v_light = 0.3 + 0.7 * max(normal.z, 0.0);
+        }
+    )";
+
+const char *const GlES2Mesh::kFragmentShader = R"(
+        varying lowp float v_light;
+        void main() {
+            gl_FragColor = vec4(vec3(0.9, 0.75, 0.5) * v_light, 1.0);
+        }
+    )";
+
+bool GlES2Mesh::load(const std::string &path, MeshLoadInfo *info) {
+  TRACE_SCOPE("GlES2Mesh::load");
+  const int64_t begin = monotonicNowNs();
+  MappedFile file;
+  if (!file.open(path))
+    return false;
+  MeshFormat::Mesh mesh;
+  if (!MeshFormat::parse(file.data(), file.size(), &mesh) ||
+      mesh.chunks.empty()) {
+    LOG_E << "cannot load " << path;
+    return false;
+  }
+  // from the mapping to the driver, no copy in between
+  if (!vertices_.initialize(mesh.vertex_count * sizeof(Vertex),
+                            mesh.vertices) ||
+      !indices_.initialize(mesh.index_count * sizeof(uint16_t),
+                           mesh.indices)) {
+    LOG_E << "cannot upload " << path;
+    return false;
+  }
+  chunks_ = std::move(mesh.chunks);
+  std::copy_n(mesh.position_offset, 3, position_offset_);
+  std::copy_n(mesh.position_scale, 3, position_scale_);
+  std::copy_n(mesh.uv_offset, 2, uv_transform_);
+  std::copy_n(mesh.uv_scale, 2, uv_transform_ + 2);
+
+  if (info) {
+    info->chunks = chunks_.size();
+    info->vertices = mesh.vertex_count;
+    info->triangles = mesh.index_count / 3;
+    info->file_bytes = file.size();
+    info->float_bytes = mesh.vertex_count * 8 * sizeof(float) +
+                        mesh.index_count * sizeof(uint32_t);
+    info->load_ns = monotonicNowNs() - begin;
+  }
+  return true;
+}
+
+void GlES2Mesh::bindChunk(const Chunk &chunk,
+                          const Attributes &attributes) const {
+  GlES2State &gl = GlES2State::current();
+  const char *base = reinterpret_cast<const char *>(chunk.first_vertex *
+                                                    sizeof(Vertex));
+  gl.vertexAttribPointer(attributes.position, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                         sizeof(Vertex), base + offsetof(Vertex, position));
+  if (attributes.normal >= 0)
+    gl.vertexAttribPointer(attributes.normal, 3, GL_BYTE, GL_TRUE,
+                           sizeof(Vertex), base + offsetof(Vertex, normal));
+  if (attributes.uv >= 0)
+    gl.vertexAttribPointer(attributes.uv, 2, GL_UNSIGNED_SHORT, GL_TRUE,
+                           sizeof(Vertex), base + offsetof(Vertex, uv));
+}
+
+void GlES2Mesh::draw(const Attributes &attributes) const {
+  TRACE_SCOPE("GlES2Mesh::draw");
+  GlES2State &gl = GlES2State::current();
+  gl.bindBuffer(GL_ARRAY_BUFFER, vertices_.buffer());
+  gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_.buffer());
+  for (GLint attribute :
+       {attributes.position, attributes.normal, attributes.uv}) {
+    if (attribute >= 0)
+      gl.enableVertexAttribArray(attribute);
+  }
+  for (const Chunk &chunk : chunks_) {
+    bindChunk(chunk, attributes);
+    glDrawElements(GL_TRIANGLES, chunk.index_count, GL_UNSIGNED_SHORT,
+                   reinterpret_cast<const void *>(chunk.first_index *
+                                                  sizeof(uint16_t)));
+  }
+}
+
+void GlES2Mesh::recordChunk(GlES2CommandBuffer *commands, size_t index,
+                            uint64_t key,
+                            const Attributes &attributes) const {
+  const Chunk &chunk = chunks_[index];
+  const uintptr_t base = chunk.first_vertex * sizeof(Vertex);
+  commands->bindBuffer(GL_ARRAY_BUFFER, vertices_.buffer());
+  commands->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_.buffer());
+  commands->enableVertexAttribArray(attributes.position);
+  commands->vertexAttribPointer(attributes.position, 3, GL_UNSIGNED_SHORT,
+                                GL_TRUE, sizeof(Vertex),
+                                base + offsetof(Vertex, position));
+  if (attributes.normal >= 0) {
+    commands->enableVertexAttribArray(attributes.normal);
+    commands->vertexAttribPointer(attributes.normal, 3, GL_BYTE, GL_TRUE,
+                                  sizeof(Vertex),
+                                  base + offsetof(Vertex, normal));
+  }
+  if (attributes.uv >= 0) {
+    commands->enableVertexAttribArray(attributes.uv);
+    commands->vertexAttribPointer(attributes.uv, 2, GL_UNSIGNED_SHORT,
+                                  GL_TRUE, sizeof(Vertex),
+                                  base + offsetof(Vertex, uv));
+  }
+  commands->drawElements(key, GL_TRIANGLES, chunk.index_count,
+                         GL_UNSIGNED_SHORT,
+                         chunk.first_index * sizeof(uint16_t));
+}
@@ -0,0 +1,75 @@
+#ifndef EGL_SRC_GLES2_MESH_H_
+#define EGL_SRC_GLES2_MESH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/buffer.h"
+#include "gles2/command_buffer.h"
+#include "gles2/mesh_format.h"
+
+struct MeshLoadInfo {
+  size_t chunks = 0;
+  size_t vertices = 0;
+  size_t triangles = 0;
+  size_t file_bytes = 0;
+  // the same mesh as float positions, normals and uvs with 32-bit indices
+  size_t float_bytes = 0;
+  int64_t load_ns = 0;
+};
+
+// A .mesh file (gles2/mesh_format.h) in one VBO and one IBO. The vertices
+// and indices are uploaded straight from the mapped file; the attributes
+// stay quantized, so the vertex shader scales them back:
+//   position = u_position_offset + a_position * u_position_scale
+// with a_position read as normalized unsigned shorts, and the same for the
+// uvs. The normal is read as normalized signed bytes.
+class GlES2Mesh {
+public:
+  struct Attributes {
+    GLint position = -1;
+    GLint normal = -1; // -1: not used by the program
+    GLint uv = -1;
+  };
+
+  // a program that satisfies the above (a_position, a_normal,
+  // u_position_offset, u_position_scale), placed with u_model and
+  // u_view_projection and shaded by how much it faces -z after u_model
+  static const char *const kVertexShader;
+  static const char *const kFragmentShader;
+
+  // needs a current context. |info| may be null.
+  bool load(const std::string &path, MeshLoadInfo *info = nullptr);
+  bool loaded() const { return !chunks_.empty(); }
+
+  // xyz offset and scale of the quantized positions (w 0), for
+  // glUniform4fv
+  const GLfloat *positionOffset() const { return position_offset_; }
+  const GLfloat *positionScale() const { return position_scale_; }
+  // uv offset in xy, scale in zw
+  const GLfloat *uvTransform() const { return uv_transform_; }
+  size_t chunks() const { return chunks_.size(); }
+
+  // one glDrawElements per chunk, with the program and uniforms already set
+  void draw(const Attributes &attributes) const;
+  // the buffers, attributes and draw of |chunk| as a packet under |key|;
+  // the program and uniforms must be recorded before each
+  void recordChunk(GlES2CommandBuffer *commands, size_t chunk, uint64_t key,
+                   const Attributes &attributes) const;
+
+private:
+  void bindChunk(const MeshFormat::Chunk &chunk,
+                 const Attributes &attributes) const;
+
+  GlES2Buffer vertices_;
+  GlES2Buffer indices_{GL_ELEMENT_ARRAY_BUFFER};
+  std::vector<MeshFormat::Chunk> chunks_;
+  GLfloat position_offset_[4] = {};
+  GLfloat position_scale_[4] = {};
+  GLfloat uv_transform_[4] = {};
+};
+
+#endif // EGL_SRC_GLES2_MESH_H_
@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "base/logging.h"
+#include "gles2/mesh_format.h"
+
+namespace MeshFormat {
+
+namespace {
+
+const char kMagic[8] = {'E', 'G', 'L', 'M', 'E', 'S', 'H', '1'};
+
+struct Header {
+  char magic[8];
+  uint32_t chunk_count;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t reserved;
+  float position_offset[3];
+  float position_scale[3];
+  float uv_offset[2];
+  float uv_scale[2];
+};
+static_assert(sizeof(Header) == 64, "Header layout");
+
+// Forsyth's scoring: the vertices of the last triangle score flat (they
+// are reused anyway), older cache entries decay with their position, and
+// vertices with few triangles left get a boost so that none are stranded
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float vertexScore(int cache_position, uint32_t remaining) {
+  if (remaining == 0)
+    return -1; // nothing left to draw with it
+  float score = 0;
+  if (cache_position >= 3) {
+    const float scaler = 1.0f / (kCacheSize - 3);
+    score = std::pow(1.0f - (cache_position - 3) * scaler, kCacheDecayPower);
+  } else if (cache_position >= 0) {
+    score = kLastTriangleScore;
+  }
+  return score + kValenceBoostScale *
+                     std::pow(static_cast<float>(remaining),
+                              -kValenceBoostPower);
+}
+
+uint16_t quantize(float v, float offset, float scale) {
+  if (scale <= 0)
+    return 0;
+  return static_cast<uint16_t>(
+      std::lround(std::clamp((v - offset) / scale, 0.0f, 1.0f) * 65535));
+}
+
+int8_t quantizeSigned(float v) {
+  return static_cast<int8_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127));
+}
+
+// offset and scale that map [min, max] of |components|-wide |values| to
+// [0, 1]
+void bounds(const std::vector<float> &values, int components, float *offset,
+            float *scale) {
+  for (int c = 0; c < components; ++c) {
+    float lo = values.empty() ? 0 : values[c], hi = lo;
+    for (size_t i = c; i < values.size(); i += components) {
+      lo = std::min(lo, values[i]);
+      hi = std::max(hi, values[i]);
+    }
+    offset[c] = lo;
+    scale[c] = hi - lo;
+  }
+}
+
+// vertices transformed for |indices| through a FIFO of |cache_size|
+template <typename Index>
+uint64_t fifoMisses(const Index *indices, size_t count, int cache_size) {
+  if (count == 0)
+    return 0;
+  const Index max_index = *std::max_element(indices, indices + count);
+  // the miss that brought each vertex in; it stays for |cache_size| more
+  std::vector<uint64_t> entered(max_index + 1, 0);
+  uint64_t misses = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t &at = entered[indices[i]];
+    if (at == 0 || misses - at >= static_cast<uint64_t>(cache_size))
+      at = ++misses;
+  }
+  return misses;
+}
+
+} // namespace
+
+bool parse(const uint8_t *data, size_t size, Mesh *mesh) {
+  Header header;
+  if (size < sizeof(header) || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    LOG_E << "not a mesh file";
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  const size_t table_bytes = header.chunk_count * sizeof(Chunk);
+  const size_t vertex_bytes = header.vertex_count * sizeof(Vertex);
+  const size_t index_bytes = header.index_count * sizeof(uint16_t);
+  if (size != sizeof(header) + table_bytes + vertex_bytes + index_bytes) {
+    LOG_E << "mesh: size does not match the header";
+    return false;
+  }
+  std::copy_n(header.position_offset, 3, mesh->position_offset);
+  std::copy_n(header.position_scale, 3, mesh->position_scale);
+  std::copy_n(header.uv_offset, 2, mesh->uv_offset);
+  std::copy_n(header.uv_scale, 2, mesh->uv_scale);
+  mesh->chunks.resize(header.chunk_count);
+  memcpy(mesh->chunks.data(), data + sizeof(header), table_bytes);
+  mesh->vertices = reinterpret_cast<const Vertex *>(data + sizeof(header) +
+                                                    table_bytes);
+  mesh->vertex_count = header.vertex_count;
+  mesh->indices = reinterpret_cast<const uint16_t *>(
+      data + sizeof(header) + table_bytes + vertex_bytes);
+  mesh->index_count = header.index_count;
+
+  // a bad index would make the GPU read past the buffer
+  for (const Chunk &chunk : mesh->chunks) {
+    if (chunk.vertex_count > 65536 || chunk.index_count % 3 != 0 ||
+        chunk.first_vertex > mesh->vertex_count ||
+        chunk.vertex_count > mesh->vertex_count - chunk.first_vertex ||
+        chunk.first_index > mesh->index_count ||
+        chunk.index_count > mesh->index_count - chunk.first_index) {
+      LOG_E << "mesh: bad chunk";
+      return false;
+    }
+    const uint16_t *indices = mesh->indices + chunk.first_index;
+    if (chunk.index_count &&
+        *std::max_element(indices, indices + chunk.index_count) >=
+            chunk.vertex_count) {
+      LOG_E << "mesh: index out of range";
+      return false;
+    }
+  }
+  return true;
+}
+
+void computeNormals(Source *source) {
+  const std::vector<float> &p = source->positions;
+  std::vector<float> &n = source->normals;
+  n.assign(p.size(), 0.0f);
+  for (size_t t = 0; t + 2 < source->indices.size(); t += 3) {
+    const uint32_t *tri = &source->indices[t];
+    const float *a = &p[tri[0] * 3], *b = &p[tri[1] * 3], *c = &p[tri[2] * 3];
+    const float u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const float v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    // the cross product's length is twice the area: larger faces weigh more
+    const float cross[3] = {u[1] * v[2] - u[2] * v[1],
+                            u[2] * v[0] - u[0] * v[2],
+                            u[0] * v[1] - u[1] * v[0]};
+    for (int k = 0; k < 3; ++k) {
+      for (int c = 0; c < 3; ++c)
+        n[tri[k] * 3 + c] += cross[c];
+    }
+  }
+  for (size_t i = 0; i < n.size(); i += 3) {
+    const float length =
+        std::sqrt(n[i] * n[i] + n[i + 1] * n[i + 1] + n[i + 2] * n[i + 2]);
+    if (length > 0) {
+      for (int c = 0; c < 3; ++c)
+        n[i + c] /= length;
+    } else {
+      n[i + 2] = 1;
+    }
+  }
+}
+
+double acmr(const uint32_t *indices, size_t count, int cache_size) {
+  if (count < 3)
+    return 0;
+  return static_cast<double>(fifoMisses(indices, count, cache_size)) /
+         (count / 3);
+}
+
+void optimizeVertexCache(uint32_t *indices, size_t count,
+                         size_t vertex_count) {
+  const size_t triangles = count / 3;
+  if (triangles == 0)
+    return;
+  const std::vector<uint32_t> input(indices, indices + triangles * 3);
+
+  // the triangles not drawn yet of each vertex:
+  // adjacency[offsets[v], offsets[v] + remaining[v])
+  std::vector<uint32_t> remaining(vertex_count, 0);
+  for (uint32_t v : input)
+    ++remaining[v];
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t v = 0; v < vertex_count; ++v)
+    offsets[v + 1] = offsets[v] + remaining[v];
+  std::vector<uint32_t> adjacency(input.size());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < input.size(); ++i)
+      adjacency[fill[input[i]]++] = i / 3;
+  }
+
+  std::vector<int> position(vertex_count, -1);
+  std::vector<float> vertex_score(vertex_count);
+  for (size_t v = 0; v < vertex_count; ++v)
+    vertex_score[v] = vertexScore(-1, remaining[v]);
+  std::vector<uint8_t> emitted(triangles, 0);
+  long best = -1;
+  float best_score = -1;
+  for (size_t t = 0; t < triangles; ++t) {
+    const float score = vertex_score[input[t * 3]] +
+                        vertex_score[input[t * 3 + 1]] +
+                        vertex_score[input[t * 3 + 2]];
+    if (score > best_score) {
+      best_score = score;
+      best = t;
+    }
+  }
+
+  uint32_t cache[kCacheSize + 3];
+  int cache_used = 0;
+  size_t cursor = 0;
+  for (size_t out = 0; out < triangles; ++out) {
+    if (best < 0) {
+      // nothing in the cache has triangles left: take the next one in the
+      // input order rather than scan for the best
+      while (emitted[cursor])
+        ++cursor;
+      best = cursor;
+    }
+    const uint32_t *tri = &input[best * 3];
+    emitted[best] = 1;
+    std::copy_n(tri, 3, indices + out * 3);
+
+    uint32_t next[kCacheSize + 3];
+    int next_used = 0;
+    for (int k = 0; k < 3; ++k) {
+      const uint32_t v = tri[k];
+      // drop |best| from the vertex's live triangles
+      uint32_t *live = &adjacency[offsets[v]];
+      uint32_t &live_count = remaining[v];
+      for (uint32_t i = 0; i < live_count; ++i) {
+        if (live[i] == static_cast<uint32_t>(best)) {
+          std::swap(live[i], live[live_count - 1]);
+          --live_count;
+          break;
+        }
+      }
+      if (std::find(next, next + next_used, v) == next + next_used)
+        next[next_used++] = v;
+    }
+    // LRU: the triangle's vertices move to the front
+    for (int i = 0; i < cache_used; ++i) {
+      if (std::find(tri, tri + 3, cache[i]) == tri + 3)
+        next[next_used++] = cache[i];
+    }
+    for (int i = 0; i < next_used; ++i) {
+      const uint32_t v = next[i];
+      position[v] = i < kCacheSize ? i : -1;
+      vertex_score[v] = vertexScore(position[v], remaining[v]);
+    }
+
+    best = -1;
+    best_score = -1;
+    for (int i = 0; i < next_used; ++i) {
+      const uint32_t v = next[i];
+      for (uint32_t j = 0; j < remaining[v]; ++j) {
+        const uint32_t t = adjacency[offsets[v] + j];
+        const float score = vertex_score[input[t * 3]] +
+                            vertex_score[input[t * 3 + 1]] +
+                            vertex_score[input[t * 3 + 2]];
+        if (score > best_score) {
+          best_score = score;
+          best = t;
+        }
+      }
+    }
+    cache_used = std::min(next_used, kCacheSize);
+    std::copy_n(next, cache_used, cache);
+  }
+}
+
+std::vector<uint8_t> encode(const Source &source,
+                            const EncodeOptions &options, EncodeStats *stats) {
+  const size_t vertex_count = source.vertexCount();
+  if (source.normals.size() != vertex_count * 3) {
+    Source with_normals = source;
+    computeNormals(&with_normals);
+    return encode(with_normals, options, stats);
+  }
+  const bool has_uvs = source.uvs.size() == vertex_count * 2;
+  std::vector<uint32_t> order(
+      source.indices.begin(),
+      source.indices.begin() + source.indices.size() / 3 * 3);
+  EncodeStats result;
+  result.triangles = order.size() / 3;
+  result.acmr16_before = acmr(order.data(), order.size(), 16);
+  result.acmr32_before = acmr(order.data(), order.size(), 32);
+  if (options.optimize)
+    optimizeVertexCache(order.data(), order.size(), vertex_count);
+
+  Header header = {};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  bounds(source.positions, 3, header.position_offset, header.position_scale);
+  if (has_uvs)
+    bounds(source.uvs, 2, header.uv_offset, header.uv_scale);
+
+  // triangles go into the current chunk until their new vertices would not
+  // fit; a chunk's vertices are numbered in the order of first use
+  const uint32_t max_vertices =
+      std::clamp<uint32_t>(options.max_chunk_vertices, 3, 65536);
+  std::vector<Chunk> chunks;
+  std::vector<Vertex> vertices;
+  std::vector<uint16_t> indices;
+  indices.reserve(order.size());
+  std::vector<uint32_t> local(vertex_count);
+  // the chunk (1-based) each source vertex was last added to
+  std::vector<uint32_t> added(vertex_count, 0);
+  Chunk chunk = {0, 0, 0, 0};
+  uint32_t chunk_id = 1;
+  for (size_t t = 0; t < order.size(); t += 3) {
+    const uint32_t *tri = &order[t];
+    uint32_t fresh = 0;
+    for (int k = 0; k < 3; ++k) {
+      const bool repeated = std::find(tri, tri + k, tri[k]) != tri + k;
+      if (added[tri[k]] != chunk_id && !repeated)
+        ++fresh;
+    }
+    if (chunk.vertex_count + fresh > max_vertices) {
+      chunks.push_back(chunk);
+      chunk = {static_cast<uint32_t>(vertices.size()), 0,
+               static_cast<uint32_t>(indices.size()), 0};
+      ++chunk_id;
+    }
+    for (int k = 0; k < 3; ++k) {
+      const uint32_t v = tri[k];
+      if (added[v] != chunk_id) {
+        added[v] = chunk_id;
+        local[v] = chunk.vertex_count++;
+        Vertex vertex = {};
+        for (int c = 0; c < 3; ++c) {
+          vertex.position[c] =
+              quantize(source.positions[v * 3 + c], header.position_offset[c],
+                       header.position_scale[c]);
+          vertex.normal[c] = quantizeSigned(source.normals[v * 3 + c]);
+        }
+        for (int c = 0; has_uvs && c < 2; ++c) {
+          vertex.uv[c] = quantize(source.uvs[v * 2 + c], header.uv_offset[c],
+                                  header.uv_scale[c]);
+        }
+        vertices.push_back(vertex);
+      }
+      indices.push_back(local[v]);
+      ++chunk.index_count;
+    }
+  }
+  if (chunk.index_count)
+    chunks.push_back(chunk);
+
+  header.chunk_count = chunks.size();
+  header.vertex_count = vertices.size();
+  header.index_count = indices.size();
+  std::vector<uint8_t> data(sizeof(header) + chunks.size() * sizeof(Chunk) +
+                            vertices.size() * sizeof(Vertex) +
+                            indices.size() * sizeof(uint16_t));
+  uint8_t *p = data.data();
+  auto append = [&p](const void *src, size_t bytes) {
+    if (bytes)
+      memcpy(p, src, bytes);
+    p += bytes;
+  };
+  append(&header, sizeof(header));
+  append(chunks.data(), chunks.size() * sizeof(Chunk));
+  append(vertices.data(), vertices.size() * sizeof(Vertex));
+  append(indices.data(), indices.size() * sizeof(uint16_t));
+
+  if (stats) {
+    result.chunks = chunks.size();
+    result.vertices = vertices.size();
+    // chunk by chunk, as drawn
+    uint64_t misses16 = 0, misses32 = 0;
+    for (const Chunk &c : chunks) {
+      misses16 += fifoMisses(&indices[c.first_index], c.index_count, 16);
+      misses32 += fifoMisses(&indices[c.first_index], c.index_count, 32);
+    }
+    if (result.triangles) {
+      result.acmr16 = static_cast<double>(misses16) / result.triangles;
+      result.acmr32 = static_cast<double>(misses32) / result.triangles;
+    }
+    *stats = result;
+  }
+  return data;
+}
+
+bool write(const std::string &path, const std::vector<uint8_t> &data) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    LOG_E << "cannot write " << path;
+    return false;
+  }
+  bool ok = data.empty() || fwrite(data.data(), data.size(), 1, file) == 1;
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    LOG_E << "cannot write " << path;
+  return ok;
+}
+
+} // namespace MeshFormat
@@ -0,0 +1,110 @@
+#ifndef EGL_SRC_GLES2_MESH_FORMAT_H_
+#define EGL_SRC_GLES2_MESH_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The .mesh container for static triangle meshes and the offline steps that
+// produce it: vertex cache optimization, splitting into chunks that 16-bit
+// indices can address, and quantization. No GL here, so that the importer
+// links it alone.
+//
+// A file is a header, the chunk table, the vertices and the indices, laid
+// out so that the last two go to glBufferData() straight from the mapped
+// file (native byte order, little-endian in practice).
+namespace MeshFormat {
+
+// 16 bytes, read with normalized attributes: the position in 16-bit
+// fractions of the bounding box, the normal in signed bytes and the uv in
+// 16-bit fractions of the uv bounds
+struct Vertex {
+  uint16_t position[4]; // w is 0
+  int8_t normal[4];     // w is 0
+  uint16_t uv[2];
+};
+static_assert(sizeof(Vertex) == 16, "Vertex layout");
+
+// one glDrawElements: at most 65536 vertices and indices relative to
+// |first_vertex|
+struct Chunk {
+  uint32_t first_vertex;
+  uint32_t vertex_count;
+  uint32_t first_index;
+  uint32_t index_count;
+};
+
+// a parsed file; |vertices| and |indices| point into its data
+struct Mesh {
+  // position = offset + fraction * scale, and the same for the uvs
+  float position_offset[3] = {};
+  float position_scale[3] = {};
+  float uv_offset[2] = {};
+  float uv_scale[2] = {};
+  std::vector<Chunk> chunks;
+  const Vertex *vertices = nullptr;
+  size_t vertex_count = 0;
+  const uint16_t *indices = nullptr;
+  size_t index_count = 0;
+};
+
+bool parse(const uint8_t *data, size_t size, Mesh *mesh);
+
+// an indexed triangle list before encoding; |normals| and |uvs| hold one
+// entry per position or are empty
+struct Source {
+  std::vector<float> positions; // xyz
+  std::vector<float> normals;   // xyz
+  std::vector<float> uvs;       // uv
+  std::vector<uint32_t> indices;
+
+  size_t vertexCount() const { return positions.size() / 3; }
+};
+
+// area-weighted smooth normals
+void computeNormals(Source *source);
+
+// the post-transform cache the optimizer assumes (LRU, in vertices)
+constexpr int kCacheSize = 32;
+
+// average cache miss ratio: vertices transformed per triangle through a
+// FIFO post-transform cache of |cache_size| entries. 3 is no reuse at all;
+// about 0.5 is the best a large regular mesh allows.
+double acmr(const uint32_t *indices, size_t count, int cache_size);
+
+// reorders the triangles of |indices| for the post-transform cache with
+// Forsyth's linear-speed algorithm
+void optimizeVertexCache(uint32_t *indices, size_t count,
+                         size_t vertex_count);
+
+struct EncodeOptions {
+  // reorder triangles for the vertex cache; vertices always go in the order
+  // of first use, for fetch locality
+  bool optimize = true;
+  // per chunk, at most 65536
+  uint32_t max_chunk_vertices = 65536;
+};
+
+struct EncodeStats {
+  size_t chunks = 0;
+  // after the vertices shared between chunks are repeated
+  size_t vertices = 0;
+  size_t triangles = 0;
+  // FIFO 16 and 32, in the source order and as encoded
+  double acmr16_before = 0;
+  double acmr32_before = 0;
+  double acmr16 = 0;
+  double acmr32 = 0;
+};
+
+// computes the normals first when |source| has none. |stats| may be null.
+std::vector<uint8_t> encode(const Source &source,
+                            const EncodeOptions &options = {},
+                            EncodeStats *stats = nullptr);
+
+bool write(const std::string &path, const std::vector<uint8_t> &data);
+
+} // namespace MeshFormat
+
+#endif // EGL_SRC_GLES2_MESH_FORMAT_H_
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/mesh_renderer.h"
+#include "gles2/state.h"
+#include "math/batch.h"
+
+namespace {
+
+// three vec4 rows of an affine model matrix per instance
+constexpr int kVectorsPerInstance = 3;
+
+std::string vertexShader(int batch) {
+  return R"(
+        attribute vec3 a_position;
+        attribute vec4 a_color;
+        attribute float a_instance;
+        uniform mat4 u_view_projection;
+        uniform vec4 u_models[)" +
+         std::to_string(batch * kVectorsPerInstance) + R"(];
+        varying lowp vec4 v_color;
+        void main() {
+            int i = int(a_instance) * 3;
+            vec4 p = vec4(a_position, 1.0);
+            vec3 world = vec3(dot(u_models[i], p), dot(u_models[i + 1], p),
+                              dot(u_models[i + 2], p));
+            gl_Position = u_view_projection * vec4(world, 1.0);
+            v_color = a_color;
+        }
+    )";
+}
+
+const char *kFragmentShader = R"(
+        varying lowp vec4 v_color;
+        void main() {
+            gl_FragColor = v_color;
+        }
+    )";
+
+} // namespace
+
+bool GlES2MeshRenderer::initialize(GlES2ProgramCache *cache,
+                                   const ShapeList &shapes, int max_batch) {
+  if (shapes.size() == 0) {
+    LOG_E << "no shapes";
+    return false;
+  }
+  GLint max_vectors = 0;
+  glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &max_vectors);
+  // u_view_projection takes four
+  capacity_ = std::min({max_batch, kMaxBatch,
+                        (max_vectors - 4) / kVectorsPerInstance,
+                        static_cast<int>(0x10000 / shapes.vertices().size())});
+  if (capacity_ < 1) {
+    LOG_E << "shapes do not fit in 16-bit indices";
+    return false;
+  }
+  batch_ = capacity_;
+
+  const std::string vshader = vertexShader(capacity_);
+  program_ = cache->get(vshader.c_str(), kFragmentShader);
+  if (!program_)
+    return false;
+  a_position_ = program_->attribute("a_position");
+  a_color_ = program_->attribute("a_color");
+  a_instance_ = program_->attribute("a_instance");
+  u_view_projection_ = program_->uniform("u_view_projection");
+  u_models_ = program_->uniform("u_models");
+
+  // shape by shape, |capacity_| consecutive copies of its vertices and
+  // indices
+  std::vector<Vertex> vertices;
+  std::vector<GLushort> indices;
+  vertices.reserve(shapes.vertices().size() * capacity_);
+  indices.reserve(shapes.indices().size() * capacity_);
+  ranges_.clear();
+  for (int s = 0; s < shapes.size(); ++s) {
+    const ShapeList::IndexRange &range = shapes.range(s);
+    const uint32_t first = shapes.vertexOffset(s);
+    const uint32_t count = shapes.vertexCount(s);
+    ranges_.push_back({static_cast<uint32_t>(indices.size()), range.length});
+    for (int copy = 0; copy < capacity_; ++copy) {
+      const uint32_t base = vertices.size();
+      for (uint32_t v = first; v < first + count; ++v) {
+        const auto &p = shapes.vertices()[v];
+        vertices.push_back({p[0], p[1], p[2], shapes.colors()[v],
+                            static_cast<uint8_t>(copy), {}});
+      }
+      for (uint32_t i = range.offset; i < range.offset + range.length; ++i)
+        indices.push_back(base + shapes.indices()[i] - first);
+    }
+  }
+  models_.resize(capacity_ * kVectorsPerInstance * 4);
+  return vertices_.initialize(vertices.size() * sizeof(Vertex),
+                              vertices.data()) &&
+         indices_.initialize(indices.size() * sizeof(GLushort),
+                             indices.data());
+}
+
+void GlES2MeshRenderer::setBatchSize(int batch) {
+  batch_ = std::clamp(batch, 1, capacity_);
+}
+
+GlES2MeshRenderer::Selection
+GlES2MeshRenderer::select(EntityList *entities, const uint8_t *visible) {
+  entities->sort();
+  const size_t n = entities->size();
+  if (!visible)
+    return {entities->positions(), entities->rotations(), entities->shapes(),
+            n};
+  // the shape order carries over, so the runs below stay whole
+  visible_positions_.resize(n * 3);
+  visible_rotations_.resize(n * 4);
+  visible_shapes_.resize(n);
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (!visible[i])
+      continue;
+    std::copy_n(entities->positions() + i * 3, 3,
+                &visible_positions_[count * 3]);
+    std::copy_n(entities->rotations() + i * 4, 4,
+                &visible_rotations_[count * 4]);
+    visible_shapes_[count++] = entities->shapes()[i];
+  }
+  return {visible_positions_.data(), visible_rotations_.data(),
+          visible_shapes_.data(), count};
+}
+
+void GlES2MeshRenderer::draw(const float view_projection[16],
+                             EntityList *entities, const uint8_t *visible) {
+  TRACE_SCOPE("GlES2MeshRenderer::draw");
+  const Selection selection = select(entities, visible);
+  if (selection.size == 0)
+    return;
+
+  GlES2State &gl = GlES2State::current();
+  gl.setEnabled(GL_DEPTH_TEST, true);
+  gl.depthFunc(GL_LEQUAL);
+  gl.useProgram(program_->program());
+  gl.uniformMatrix4fv(u_view_projection_, view_projection);
+  vertices_.bind();
+  indices_.bind();
+  gl.enableVertexAttribArray(a_position_);
+  gl.enableVertexAttribArray(a_color_);
+  gl.enableVertexAttribArray(a_instance_);
+  gl.vertexAttribPointer(a_position_, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                         reinterpret_cast<void *>(offsetof(Vertex, x)));
+  gl.vertexAttribPointer(a_color_, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                         sizeof(Vertex),
+                         reinterpret_cast<void *>(offsetof(Vertex, color)));
+  gl.vertexAttribPointer(a_instance_, 1, GL_UNSIGNED_BYTE, GL_FALSE,
+                         sizeof(Vertex),
+                         reinterpret_cast<void *>(offsetof(Vertex, instance)));
+
+  const float *positions = selection.positions;
+  const float *rotations = selection.rotations;
+  const uint16_t *shapes = selection.shapes;
+  const size_t n = selection.size;
+  for (size_t begin = 0; begin < n;) {
+    // one run of a shape, cut into batches
+    size_t end = begin + 1;
+    while (end < n && shapes[end] == shapes[begin])
+      ++end;
+    for (size_t i = begin; i < end; i += batch_) {
+      const size_t count = std::min<size_t>(batch_, end - i);
+      Math::affineRows(rotations + i * 4, positions + i * 3, models_.data(),
+                       count);
+      flush(ranges_[shapes[begin]], count);
+    }
+    begin = end;
+  }
+  stats_.entities += n;
+  gl.setEnabled(GL_DEPTH_TEST, false);
+}
+
+void GlES2MeshRenderer::record(GlES2CommandBuffer *commands, int layer,
+                               const float view_projection[16],
+                               EntityList *entities,
+                               const uint8_t *visible) {
+  TRACE_SCOPE("GlES2MeshRenderer::record");
+  const Selection selection = select(entities, visible);
+  const float *positions = selection.positions;
+  const float *rotations = selection.rotations;
+  const uint16_t *shapes = selection.shapes;
+  const size_t n = selection.size;
+  const float *m = view_projection;
+  for (size_t begin = 0; begin < n;) {
+    size_t end = begin + 1;
+    while (end < n && shapes[end] == shapes[begin])
+      ++end;
+    const Range &range = ranges_[shapes[begin]];
+    for (size_t i = begin; i < end; i += batch_) {
+      const size_t count = std::min<size_t>(batch_, end - i);
+      // window depth of the first entity's origin
+      const float *p = positions + i * 3;
+      const float z = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+      const float w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+      const float depth = w > 0 ? z / w * 0.5f + 0.5f : 1.0f;
+
+      commands->setEnabled(GL_DEPTH_TEST, true);
+      commands->depthFunc(GL_LEQUAL);
+      commands->useProgram(program_->program());
+      commands->uniformMatrix4fv(u_view_projection_, view_projection);
+      commands->bindBuffer(GL_ARRAY_BUFFER, vertices_.buffer());
+      commands->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_.buffer());
+      commands->enableVertexAttribArray(a_position_);
+      commands->enableVertexAttribArray(a_color_);
+      commands->enableVertexAttribArray(a_instance_);
+      commands->vertexAttribPointer(a_position_, 3, GL_FLOAT, GL_FALSE,
+                                    sizeof(Vertex), offsetof(Vertex, x));
+      commands->vertexAttribPointer(a_color_, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                                    sizeof(Vertex), offsetof(Vertex, color));
+      commands->vertexAttribPointer(a_instance_, 1, GL_UNSIGNED_BYTE,
+                                    GL_FALSE, sizeof(Vertex),
+                                    offsetof(Vertex, instance));
+      Math::affineRows(rotations + i * 4, positions + i * 3,
+                       commands->uniform4fv(u_models_,
+                                            count * kVectorsPerInstance),
+                       count);
+      commands->drawElements(
+          GlES2CommandBuffer::sortKey(layer, program_->program(), 0, depth),
+          GL_TRIANGLES, range.length * count, GL_UNSIGNED_SHORT,
+          range.offset * sizeof(GLushort));
+      stats_.uniform_vectors += count * kVectorsPerInstance;
+      ++stats_.draw_calls;
+    }
+    begin = end;
+  }
+  stats_.entities += n;
+}
+
+void GlES2MeshRenderer::flush(const Range &range, int count) {
+  glUniform4fv(u_models_, count * kVectorsPerInstance, models_.data());
+  glDrawElements(GL_TRIANGLES, range.length * count, GL_UNSIGNED_SHORT,
+                 reinterpret_cast<void *>(range.offset * sizeof(GLushort)));
+  stats_.uniform_vectors += count * kVectorsPerInstance;
+  ++stats_.draw_calls;
+}
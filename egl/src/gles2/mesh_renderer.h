@@ -0,0 +1,103 @@
+#ifndef EGL_SRC_GLES2_MESH_RENDERER_H_
+#define EGL_SRC_GLES2_MESH_RENDERER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/buffer.h"
+#include "gles2/command_buffer.h"
+#include "gles2/program_cache.h"
+#include "gles2/shader.h"
+#include "scene/entity_list.h"
+#include "scene/shape_list.h"
+
+// Draws the entities of an EntityList (the native sample2 Renderer).
+//
+// GLES2 has no instancing, so the geometry of each shape is stored
+// |batch| times in one shared VBO/IBO, every copy tagged with its instance
+// number. A draw of k entities of one shape uploads k model transforms
+// into a uniform array and draws the first k copies: one uniform upload
+// and one glDrawElements per batch instead of per entity.
+class GlES2MeshRenderer {
+public:
+  struct Stats {
+    uint64_t entities = 0;
+    uint64_t draw_calls = 0;
+    uint64_t uniform_vectors = 0;
+  };
+
+  // copies per shape; the instance attribute is an unsigned byte anyway
+  static constexpr int kMaxBatch = 128;
+
+  // builds the program through |cache| and uploads |shapes|. The batch may
+  // come out smaller than |max_batch|: it is bounded by
+  // GL_MAX_VERTEX_UNIFORM_VECTORS and by the 16-bit indices of the copies.
+  bool initialize(GlES2ProgramCache *cache, const ShapeList &shapes,
+                  int max_batch = kMaxBatch);
+
+  // entities per draw call, at most batchCapacity(); 1 is the one draw per
+  // entity path of sample2
+  void setBatchSize(int batch);
+  int batchSize() const { return batch_; }
+  int batchCapacity() const { return capacity_; }
+
+  // sorts |entities| by shape first if needed. With |visible| (per slot,
+  // as EntityBvh::cull() fills it) only the entities marked in it are
+  // drawn, so |entities| must already be sorted.
+  void draw(const float view_projection[16], EntityList *entities,
+            const uint8_t *visible = nullptr);
+  // draw() as one packet per batch in |layer|, keyed by the depth of the
+  // batch's first entity. Makes no GL calls.
+  void record(GlES2CommandBuffer *commands, int layer,
+              const float view_projection[16], EntityList *entities,
+              const uint8_t *visible = nullptr);
+
+  const Stats &stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  struct Vertex {
+    GLfloat x, y, z;
+    uint32_t color;
+    uint8_t instance;
+    uint8_t padding[3];
+  };
+  // the copies of one shape in the index buffer
+  struct Range {
+    uint32_t offset; // in indices
+    uint32_t length; // of one copy
+  };
+
+  // the entities to draw, sorted by shape
+  struct Selection {
+    const float *positions;
+    const float *rotations;
+    const uint16_t *shapes;
+    size_t size;
+  };
+  // all of |entities|, or the ones |visible| marks copied together
+  Selection select(EntityList *entities, const uint8_t *visible);
+  void flush(const Range &range, int count);
+
+  std::shared_ptr<GlES2ShaderProgram> program_;
+  GLint a_position_ = -1;
+  GLint a_color_ = -1;
+  GLint a_instance_ = -1;
+  GLint u_view_projection_ = -1;
+  GLint u_models_ = -1;
+  int capacity_ = 0;
+  int batch_ = 0;
+  GlES2Buffer vertices_;
+  GlES2Buffer indices_{GL_ELEMENT_ARRAY_BUFFER};
+  std::vector<Range> ranges_;
+  std::vector<GLfloat> models_;
+  std::vector<float> visible_positions_;
+  std::vector<float> visible_rotations_;
+  std::vector<uint16_t> visible_shapes_;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_MESH_RENDERER_H_
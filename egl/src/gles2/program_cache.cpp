@@ -0,0 +1,176 @@
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/program_cache.h"
+
+namespace {
+
+constexpr uint32_t kMagic = 0x42504c47; // "GLPB"
+constexpr uint32_t kVersion = 1;
+
+struct BinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t format;
+  uint32_t length;
+  uint64_t key;
+};
+
+uint64_t fnv1a(const char *s, uint64_t hash) {
+  for (; *s; ++s) {
+    hash ^= static_cast<unsigned char>(*s);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+constexpr uint64_t kFnvBasis = 0xcbf29ce484222325ULL;
+
+const char *glString(GLenum name) {
+  const char *s = reinterpret_cast<const char *>(glGetString(name));
+  return s ? s : "";
+}
+
+} // namespace
+
+GlES2ProgramCache::GlES2ProgramCache(std::string directory)
+    : directory_(std::move(directory)) {
+  if (directory_.empty())
+    return;
+  if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+    LOG_W << "shader cache disabled, mkdir " << directory_ << ": "
+          << strerror(errno);
+    directory_.clear();
+    return;
+  }
+  driver_hash_ = fnv1a(glString(GL_VENDOR), kFnvBasis);
+  driver_hash_ = fnv1a(glString(GL_RENDERER), driver_hash_);
+  driver_hash_ = fnv1a(glString(GL_VERSION), driver_hash_);
+}
+
+uint64_t GlES2ProgramCache::hashSource(const char *vshader,
+                                       const char *fshader) {
+  uint64_t hash = fnv1a(vshader, kFnvBasis);
+  hash = (hash ^ 0xff) * 0x100000001b3ULL; // separator
+  return fnv1a(fshader, hash);
+}
+
+std::shared_ptr<GlES2ShaderProgram>
+GlES2ProgramCache::get(const char *vshader, const char *fshader) {
+  TRACE_SCOPE("GlES2ProgramCache::get");
+  const uint64_t key = hashSource(vshader, fshader);
+  auto it = programs_.find(key);
+  if (it != programs_.end()) {
+    ++stats_.memory_hits;
+    return it->second;
+  }
+
+  std::shared_ptr<GlES2ShaderProgram> program;
+  if (!directory_.empty())
+    program = loadBinary(key);
+  GlES2ProgramBinaryStore::Binary shared;
+  if (!program && shared_store_ && shared_store_->find(key, &shared)) {
+    program = std::make_shared<GlES2ShaderProgram>();
+    if (program->initializeFromBinary(shared.format, shared.data.data(),
+                                      shared.data.size())) {
+      ++stats_.shared_hits;
+    } else {
+      program.reset();
+    }
+  }
+  if (!program) {
+    program = std::make_shared<GlES2ShaderProgram>();
+    if (!program->initialize(vshader, fshader))
+      return nullptr;
+    ++stats_.compiles;
+    if (!directory_.empty())
+      storeBinary(key, *program);
+    if (shared_store_ && program->getBinary(&shared.format, &shared.data))
+      shared_store_->put(key, std::move(shared));
+  }
+  programs_.emplace(key, program);
+  return program;
+}
+
+bool GlES2ProgramBinaryStore::find(uint64_t key, Binary *binary) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = binaries_.find(key);
+  if (it == binaries_.end())
+    return false;
+  *binary = it->second;
+  return true;
+}
+
+void GlES2ProgramBinaryStore::put(uint64_t key, Binary binary) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  binaries_.emplace(key, std::move(binary));
+}
+
+std::string GlES2ProgramCache::binaryPath(uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin",
+           static_cast<unsigned long long>(key ^ driver_hash_));
+  return directory_ + "/" + name;
+}
+
+std::shared_ptr<GlES2ShaderProgram>
+GlES2ProgramCache::loadBinary(uint64_t key) {
+  const std::string path = binaryPath(key);
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return nullptr;
+  BinaryHeader header;
+  std::vector<uint8_t> binary;
+  bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+            header.magic == kMagic && header.version == kVersion &&
+            header.key == key;
+  if (ok) {
+    binary.resize(header.length);
+    ok = fread(binary.data(), 1, binary.size(), fp) == binary.size();
+  }
+  fclose(fp);
+
+  if (ok) {
+    auto program = std::make_shared<GlES2ShaderProgram>();
+    if (program->initializeFromBinary(header.format, binary.data(),
+                                      binary.size())) {
+      ++stats_.disk_hits;
+      return program;
+    }
+  }
+  ++stats_.disk_rejects;
+  return nullptr;
+}
+
+void GlES2ProgramCache::storeBinary(uint64_t key,
+                                    const GlES2ShaderProgram &program) {
+  GLenum format = 0;
+  std::vector<uint8_t> binary;
+  if (!program.getBinary(&format, &binary))
+    return;
+
+  const std::string path = binaryPath(key);
+  const std::string tmp = path + ".tmp";
+  FILE *fp = fopen(tmp.c_str(), "wb");
+  if (!fp) {
+    LOG_W << "fopen " << tmp << ": " << strerror(errno);
+    return;
+  }
+  const BinaryHeader header = {kMagic, kVersion, format,
+                               static_cast<uint32_t>(binary.size()), key};
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            fwrite(binary.data(), 1, binary.size(), fp) == binary.size();
+  ok = fclose(fp) == 0 && ok;
+  // rename so a concurrent reader never sees a partial file
+  if (ok && rename(tmp.c_str(), path.c_str()) == 0) {
+    ++stats_.disk_writes;
+  } else {
+    remove(tmp.c_str());
+  }
+}
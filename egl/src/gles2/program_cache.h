@@ -0,0 +1,77 @@
+#ifndef EGL_SRC_GLES2_PROGRAM_CACHE_H_
+#define EGL_SRC_GLES2_PROGRAM_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gles2/shader.h"
+
+// Linked program binaries shared by the caches of several contexts (one
+// per thread), so that each program is compiled once per process. A
+// program object itself cannot be shared that way: its uniforms are
+// per-program state. Thread-safe.
+class GlES2ProgramBinaryStore {
+public:
+  struct Binary {
+    GLenum format = 0;
+    std::vector<uint8_t> data;
+  };
+
+  bool find(uint64_t key, Binary *binary) const;
+  void put(uint64_t key, Binary binary);
+
+private:
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, Binary> binaries_;
+};
+
+// Programs keyed by a hash of their sources. Identical sources share one
+// program. With a directory and GL_OES_get_program_binary, linked binaries
+// are stored there and reloaded on the next run; a binary the driver
+// rejects is recompiled from source and replaced.
+class GlES2ProgramCache {
+public:
+  struct Stats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t disk_rejects = 0;
+    uint64_t compiles = 0;
+    uint64_t disk_writes = 0;
+    uint64_t shared_hits = 0;
+  };
+
+  // an empty |directory| only deduplicates in-process
+  explicit GlES2ProgramCache(std::string directory = std::string());
+
+  // nullptr if the program fails to compile or link
+  std::shared_ptr<GlES2ShaderProgram> get(const char *vshader,
+                                          const char *fshader);
+
+  // programs compiled by other caches are loaded from |store|, and this
+  // cache's compiles are added to it. Needs GL_OES_get_program_binary.
+  void setSharedStore(std::shared_ptr<GlES2ProgramBinaryStore> store) {
+    shared_store_ = std::move(store);
+  }
+
+  const Stats &stats() const { return stats_; }
+
+  static uint64_t hashSource(const char *vshader, const char *fshader);
+
+private:
+  std::string binaryPath(uint64_t key) const;
+  std::shared_ptr<GlES2ShaderProgram> loadBinary(uint64_t key);
+  void storeBinary(uint64_t key, const GlES2ShaderProgram &program);
+
+  std::string directory_;
+  std::shared_ptr<GlES2ProgramBinaryStore> shared_store_;
+  // GL_VENDOR/GL_RENDERER/GL_VERSION; binaries are only valid for one driver
+  uint64_t driver_hash_ = 0;
+  std::unordered_map<uint64_t, std::shared_ptr<GlES2ShaderProgram>> programs_;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_PROGRAM_CACHE_H_
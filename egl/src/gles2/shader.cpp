@@ -1,8 +1,17 @@
 
+#include <algorithm>
+#include <cstring>
 #include <optional>
 #include <string>
 
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include "base/trace.h"
 #include "gles2/shader.h"
+#include "gles2/state.h"
+#include "gles2/utils.h"
 
 namespace {
 
@@ -29,6 +38,7 @@ std::string getProgramInfoLog(GLuint program) {
 }
 
 GLuint loadShader(GLenum shaderType, const char *source) {
+  TRACE_SCOPE("loadShader");
   GLuint shader = glCreateShader(shaderType);
   glShaderSource(shader, 1, &source, nullptr);
   glCompileShader(shader);
@@ -43,6 +53,7 @@ GLuint loadShader(GLenum shaderType, const char *source) {
 }
 
 GLuint createProgram(const char *vshader, const char *fshader) {
+  TRACE_SCOPE("createProgram");
   GLuint vertexShader = loadShader(GL_VERTEX_SHADER, vshader);
   if (vertexShader == 0)
     return 0;
@@ -78,9 +89,38 @@ GLuint createProgram(const char *vshader, const char *fshader) {
 }
 
 void deleteShaderProgram(GLuint shaderProgram) {
+  GlES2State::current().onDeleteProgram(shaderProgram);
   glDeleteProgram(shaderProgram);
 }
 
+PFNGLGETPROGRAMBINARYOESPROC getProgramBinary() {
+  static const auto fn =
+      hasGLES2Extension("GL_OES_get_program_binary")
+          ? reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glGetProgramBinaryOES"))
+          : nullptr;
+  return fn;
+}
+
+PFNGLPROGRAMBINARYOESPROC programBinary() {
+  static const auto fn =
+      hasGLES2Extension("GL_OES_get_program_binary")
+          ? reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glProgramBinaryOES"))
+          : nullptr;
+  return fn;
+}
+
+const GlES2ShaderProgram::Variable *
+findVariable(const std::vector<GlES2ShaderProgram::Variable> &variables,
+             const char *name) {
+  for (const auto &v : variables) {
+    if (v.name == name)
+      return &v;
+  }
+  return nullptr;
+}
+
 } // namespace
 
 GlES2ShaderProgram::~GlES2ShaderProgram() {
@@ -91,5 +131,108 @@ GlES2ShaderProgram::~GlES2ShaderProgram() {
 
 bool GlES2ShaderProgram::initialize(const char *vshader, const char *fshader) {
   program_ = createProgram(vshader, fshader);
+  if (program_)
+    resolveLocations();
   return !!program_;
 }
+
+bool GlES2ShaderProgram::initializeFromBinary(GLenum format,
+                                              const void *binary,
+                                              GLsizei length) {
+  TRACE_SCOPE("GlES2ShaderProgram::initializeFromBinary");
+  auto load = programBinary();
+  if (!load)
+    return false;
+  GLuint program = glCreateProgram();
+  if (program == 0)
+    return false;
+  load(program, format, binary, length);
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if (linkStatus == GL_FALSE) {
+    // driver or GPU changed; not an error, the caller recompiles
+    glGetError();
+    glDeleteProgram(program);
+    return false;
+  }
+  program_ = program;
+  resolveLocations();
+  return true;
+}
+
+bool GlES2ShaderProgram::getBinary(GLenum *format,
+                                   std::vector<uint8_t> *binary) const {
+  auto get = getProgramBinary();
+  if (!get || !program_)
+    return false;
+  GLint length = 0;
+  glGetProgramiv(program_, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+  if (length <= 0)
+    return false;
+  binary->resize(length);
+  GLsizei written = 0;
+  get(program_, length, &written, format, binary->data());
+  binary->resize(written);
+  return written > 0 && checkGLES2Error();
+}
+
+void GlES2ShaderProgram::resolveLocations() {
+  attributes_.clear();
+  uniforms_.clear();
+
+  GLint max_length = 0;
+  glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+  GLint uniform_max_length = 0;
+  glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniform_max_length);
+  std::vector<char> name(std::max(max_length, uniform_max_length) + 1);
+
+  GLint count = 0;
+  glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTES, &count);
+  for (GLint i = 0; i < count; ++i) {
+    Variable v;
+    GLsizei length = 0;
+    glGetActiveAttrib(program_, i, name.size(), &length, &v.size, &v.type,
+                      name.data());
+    v.name.assign(name.data(), length);
+    v.location = glGetAttribLocation(program_, v.name.c_str());
+    attributes_.push_back(std::move(v));
+  }
+
+  glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+  for (GLint i = 0; i < count; ++i) {
+    Variable v;
+    GLsizei length = 0;
+    glGetActiveUniform(program_, i, name.size(), &length, &v.size, &v.type,
+                       name.data());
+    v.name.assign(name.data(), length);
+    v.location = glGetUniformLocation(program_, v.name.c_str());
+    if (v.name.size() > 3 &&
+        v.name.compare(v.name.size() - 3, 3, "[0]") == 0)
+      v.name.resize(v.name.size() - 3);
+    uniforms_.push_back(std::move(v));
+  }
+}
+
+const GlES2ShaderProgram::Variable *
+GlES2ShaderProgram::findAttribute(const char *name) const {
+  return findVariable(attributes_, name);
+}
+
+const GlES2ShaderProgram::Variable *
+GlES2ShaderProgram::findUniform(const char *name) const {
+  return findVariable(uniforms_, name);
+}
+
+GLint GlES2ShaderProgram::attribute(const char *name) const {
+  const Variable *v = findAttribute(name);
+  if (!v)
+    LOG_W << "inactive attribute: " << name;
+  return v ? v->location : -1;
+}
+
+GLint GlES2ShaderProgram::uniform(const char *name) const {
+  const Variable *v = findUniform(name);
+  if (!v)
+    LOG_W << "inactive uniform: " << name;
+  return v ? v->location : -1;
+}
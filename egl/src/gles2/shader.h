@@ -1,6 +1,10 @@
 #ifndef EGL_SRC_GLES2_SHADER_H_
 #define EGL_SRC_GLES2_SHADER_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include <GLES2/gl2.h>
 
 #include "base/logging.h"
@@ -8,14 +12,42 @@
 class GlES2ShaderProgram {
 
 public:
+  // an active attribute or uniform, resolved once after linking
+  struct Variable {
+    std::string name; // without a trailing "[0]"
+    GLint location;
+    GLenum type; // GL_FLOAT_VEC2, GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+    GLint size;  // array length
+  };
+
   GlES2ShaderProgram() : program_(0){};
   ~GlES2ShaderProgram();
+  GlES2ShaderProgram(const GlES2ShaderProgram &) = delete;
+  GlES2ShaderProgram &operator=(const GlES2ShaderProgram &) = delete;
+
   bool initialize(const char *vshader, const char *fshader);
+  // from glGetProgramBinaryOES output. false if the driver rejects it.
+  bool initializeFromBinary(GLenum format, const void *binary,
+                            GLsizei length);
+  // needs GL_OES_get_program_binary
+  bool getBinary(GLenum *format, std::vector<uint8_t> *binary) const;
 
   GLuint program() const { return program_; }
 
+  // table lookups; no GL call. -1 if not active.
+  GLint attribute(const char *name) const;
+  GLint uniform(const char *name) const;
+  const Variable *findAttribute(const char *name) const;
+  const Variable *findUniform(const char *name) const;
+  const std::vector<Variable> &attributes() const { return attributes_; }
+  const std::vector<Variable> &uniforms() const { return uniforms_; }
+
 private:
+  void resolveLocations();
+
   GLuint program_;
+  std::vector<Variable> attributes_;
+  std::vector<Variable> uniforms_;
 };
 
-#endif // EGL_SRC_GLES2_SHADER_H_
\ No newline at end of file
+#endif // EGL_SRC_GLES2_SHADER_H_
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <climits>
+
+#include "gles2/skyline_packer.h"
+
+void SkylinePacker::reset(int width, int height) {
+  width_ = width;
+  height_ = height;
+  used_area_ = 0;
+  segments_.assign(1, Segment{0, 0, width});
+}
+
+int SkylinePacker::fit(size_t index, int width, int height) const {
+  const int x = segments_[index].x;
+  if (x + width > width_)
+    return -1;
+  int y = 0;
+  for (int left = width; left > 0; ++index) {
+    y = std::max(y, segments_[index].y);
+    if (y + height > height_)
+      return -1;
+    left -= segments_[index].width;
+  }
+  return y;
+}
+
+bool SkylinePacker::insert(int width, int height, int *x, int *y) {
+  if (width <= 0 || height <= 0)
+    return false;
+  size_t best = segments_.size();
+  int best_top = INT_MAX;
+  int best_width = INT_MAX;
+  int best_y = 0;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const int top = fit(i, width, height);
+    if (top < 0)
+      continue;
+    // lowest top edge, then the narrowest segment to waste less
+    if (top + height < best_top ||
+        (top + height == best_top && segments_[i].width < best_width)) {
+      best = i;
+      best_top = top + height;
+      best_width = segments_[i].width;
+      best_y = top;
+    }
+  }
+  if (best == segments_.size())
+    return false;
+
+  const Segment placed{segments_[best].x, best_y + height, width};
+  segments_.insert(segments_.begin() + best, placed);
+  // trim what the new segment covers
+  for (size_t i = best + 1; i < segments_.size();) {
+    Segment &s = segments_[i];
+    const int covered = placed.x + placed.width - s.x;
+    if (covered <= 0)
+      break;
+    if (covered < s.width) {
+      s.x += covered;
+      s.width -= covered;
+      break;
+    }
+    segments_.erase(segments_.begin() + i);
+  }
+  // merge neighbours at the same height
+  for (size_t i = 0; i + 1 < segments_.size();) {
+    if (segments_[i].y == segments_[i + 1].y) {
+      segments_[i].width += segments_[i + 1].width;
+      segments_.erase(segments_.begin() + i + 1);
+    } else {
+      ++i;
+    }
+  }
+
+  *x = placed.x;
+  *y = best_y;
+  used_area_ += static_cast<int64_t>(width) * height;
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef EGL_SRC_GLES2_SKYLINE_PACKER_H_
+#define EGL_SRC_GLES2_SKYLINE_PACKER_H_
+
+#include <cstdint>
+#include <vector>
+
+// Bottom-left skyline bin packer: the free space is the region above a
+// list of horizontal segments, and a rectangle goes where its top ends up
+// lowest. Rectangles are never freed individually; reset() empties the bin.
+class SkylinePacker {
+public:
+  SkylinePacker(int width = 0, int height = 0) { reset(width, height); }
+
+  void reset(int width, int height);
+  // false when |width| x |height| does not fit anymore
+  bool insert(int width, int height, int *x, int *y);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // area handed out by insert()
+  int64_t usedArea() const { return used_area_; }
+
+private:
+  struct Segment {
+    int x, y, width;
+  };
+
+  // the y a rectangle of |width| placed at segments_[index].x would get, or
+  // -1 when it does not fit
+  int fit(size_t index, int width, int height) const;
+
+  int width_ = 0;
+  int height_ = 0;
+  int64_t used_area_ = 0;
+  std::vector<Segment> segments_;
+};
+
+#endif // EGL_SRC_GLES2_SKYLINE_PACKER_H_
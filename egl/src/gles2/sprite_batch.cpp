@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "base/frame_arena.h"
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/sprite_batch.h"
+#include "gles2/state.h"
+
+const char *const GlES2SpriteBatch::kVertexShader = R"(
+        attribute vec4 a_position;
+        attribute vec2 a_uv;
+        attribute vec4 a_color;
+        varying mediump vec2 v_uv;
+        varying lowp vec4 v_color;
+        void main() {
+            gl_Position = a_position;
+            v_uv = a_uv;
+            v_color = a_color;
+        }
+    )";
+
+const char *const GlES2SpriteBatch::kFragmentShader = R"(
+        uniform sampler2D u_texture;
+        varying mediump vec2 v_uv;
+        varying lowp vec4 v_color;
+        void main() {
+            gl_FragColor = texture2D(u_texture, v_uv) * v_color;
+        }
+    )";
+
+bool GlES2SpriteBatch::initialize(std::shared_ptr<GlES2ShaderProgram> program,
+                                  int max_sprites_per_flush) {
+  program_ = std::move(program);
+  a_position_ = program_->attribute("a_position");
+  a_uv_ = program_->attribute("a_uv");
+  a_color_ = program_->attribute("a_color");
+  u_texture_ = program_->uniform("u_texture");
+  max_sprites_ = std::clamp(max_sprites_per_flush, 1, kMaxSpritesPerDraw);
+
+  std::vector<GLushort> indices(kMaxSpritesPerDraw * 6);
+  for (int i = 0; i < kMaxSpritesPerDraw; ++i) {
+    const GLushort v = i * 4;
+    const GLushort quad[] = {v,
+                             static_cast<GLushort>(v + 1),
+                             static_cast<GLushort>(v + 2),
+                             static_cast<GLushort>(v + 2),
+                             static_cast<GLushort>(v + 1),
+                             static_cast<GLushort>(v + 3)};
+    std::copy(quad, quad + 6, indices.begin() + i * 6);
+  }
+  if (!indices_.initialize(indices.size() * sizeof(GLushort), indices.data()))
+    return false;
+  sprites_.reserve(max_sprites_);
+  return vertices_.initialize(max_sprites_ * 4 * sizeof(Vertex));
+}
+
+void GlES2SpriteBatch::begin() { sprites_.clear(); }
+
+void GlES2SpriteBatch::end() {
+  TRACE_SCOPE("GlES2SpriteBatch::end");
+  if (sprites_.empty())
+    return;
+  const Sprite *sprites = sprites_.data();
+  const size_t n = sprites_.size();
+  if (sort_by_texture_) {
+    // by texture, then submission order: stable, without the heap buffer
+    // of std::stable_sort
+    FrameArena &arena = FrameArena::current();
+    uint64_t *keys = arena.allocateArray<uint64_t>(n);
+    Sprite *sorted = arena.allocateArray<Sprite>(n);
+    if (!keys || !sorted) {
+      LOG_E << "sprite batch: no frame memory to sort " << n
+            << " sprites; dropped";
+      sprites_.clear();
+      return;
+    }
+    for (size_t i = 0; i < n; ++i)
+      keys[i] = static_cast<uint64_t>(sprites_[i].texture) << 32 | i;
+    std::sort(keys, keys + n);
+    for (size_t i = 0; i < n; ++i)
+      sorted[i] = sprites_[keys[i] & 0xffffffff];
+    sprites = sorted;
+  }
+
+  GlES2State &gl = GlES2State::current();
+  gl.useProgram(program_->program());
+  gl.uniform1i(u_texture_, 0);
+  gl.enableVertexAttribArray(a_position_);
+  gl.enableVertexAttribArray(a_uv_);
+  gl.enableVertexAttribArray(a_color_);
+
+  for (size_t i = 0; i < n; i += max_sprites_)
+    flush(sprites + i, std::min<size_t>(max_sprites_, n - i));
+  stats_.sprites += n;
+  sprites_.clear();
+}
+
+void GlES2SpriteBatch::flush(const Sprite *sprites, int count) {
+  GLintptr base = 0;
+  vertices_.reset();
+  Vertex *v = static_cast<Vertex *>(
+      vertices_.allocate(count * 4 * sizeof(Vertex), &base));
+  for (int i = 0; i < count; ++i, v += 4) {
+    const Sprite &s = sprites[i];
+    v[0] = {s.x0, s.y0, s.u0, s.v0, s.color};
+    v[1] = {s.x0, s.y1, s.u0, s.v1, s.color};
+    v[2] = {s.x1, s.y0, s.u1, s.v0, s.color};
+    v[3] = {s.x1, s.y1, s.u1, s.v1, s.color};
+  }
+  vertices_.flush();
+
+  GlES2State &gl = GlES2State::current();
+  vertices_.buffer().bind();
+  indices_.bind();
+  for (int begin = 0; begin < count;) {
+    int end = begin + 1;
+    while (end < count && sprites[end].texture == sprites[begin].texture)
+      ++end;
+
+    // no base vertex in GLES2: point the attributes at the run instead
+    const GLintptr offset = base + begin * 4 * sizeof(Vertex);
+    gl.vertexAttribPointer(a_position_, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                           reinterpret_cast<void *>(offset));
+    gl.vertexAttribPointer(
+        a_uv_, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+        reinterpret_cast<void *>(offset + offsetof(Vertex, u)));
+    gl.vertexAttribPointer(
+        a_color_, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+        reinterpret_cast<void *>(offset + offsetof(Vertex, color)));
+    gl.bindTexture(0, sprites[begin].texture);
+    glDrawElements(GL_TRIANGLES, (end - begin) * 6, GL_UNSIGNED_SHORT,
+                   nullptr);
+    ++stats_.draw_calls;
+    begin = end;
+  }
+}
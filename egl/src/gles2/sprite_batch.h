@@ -0,0 +1,77 @@
+#ifndef EGL_SRC_GLES2_SPRITE_BATCH_H_
+#define EGL_SRC_GLES2_SPRITE_BATCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/buffer.h"
+#include "gles2/shader.h"
+
+// Collects textured quads and draws them with one glDrawElements per run of
+// sprites sharing a texture. Vertices are interleaved into a stream ring
+// buffer once per end(); the 16-bit index buffer is static and shared.
+//
+// The program needs a_position (vec2), a_uv (vec2), a_color (normalized
+// RGBA8) and a sampler u_texture.
+class GlES2SpriteBatch {
+public:
+  struct Sprite {
+    // corners: (x0, y0) gets (u0, v0), (x1, y1) gets (u1, v1)
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+    uint32_t color; // RGBA8, R in the lowest byte
+    GLuint texture;
+  };
+
+  struct Stats {
+    uint64_t sprites = 0;
+    uint64_t draw_calls = 0;
+  };
+
+  // sprites per draw call: 65536 vertices is the 16-bit index limit
+  static constexpr int kMaxSpritesPerDraw = 16384;
+
+  // a program that satisfies the above
+  static const char *const kVertexShader;
+  static const char *const kFragmentShader;
+
+  bool initialize(std::shared_ptr<GlES2ShaderProgram> program,
+                  int max_sprites_per_flush = kMaxSpritesPerDraw);
+
+  // group sprites by texture on end() (draw order between textures is
+  // then not preserved); otherwise a batch breaks at every texture change.
+  // The sort uses the thread's FrameArena.
+  void setSortByTexture(bool sort) { sort_by_texture_ = sort; }
+
+  void begin();
+  void draw(const Sprite &sprite) { sprites_.push_back(sprite); }
+  void end();
+
+  const Stats &stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  struct Vertex {
+    GLfloat x, y, u, v;
+    uint32_t color;
+  };
+
+  void flush(const Sprite *sprites, int count);
+
+  std::shared_ptr<GlES2ShaderProgram> program_;
+  GLint a_position_ = -1;
+  GLint a_uv_ = -1;
+  GLint a_color_ = -1;
+  GLint u_texture_ = -1;
+  int max_sprites_ = 0;
+  bool sort_by_texture_ = true;
+  GlES2Buffer indices_{GL_ELEMENT_ARRAY_BUFFER};
+  GlES2RingBuffer vertices_;
+  std::vector<Sprite> sprites_;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_SPRITE_BATCH_H_
@@ -0,0 +1,199 @@
+#include <cstring>
+#include <iterator>
+
+#include "gles2/state.h"
+
+namespace {
+
+constexpr GLenum kCapabilities[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE,
+                                    GL_SCISSOR_TEST};
+
+} // namespace
+
+GlES2State &GlES2State::current() {
+  thread_local GlES2State state;
+  return state;
+}
+
+void GlES2State::useProgram(GLuint program) {
+  if (count(program_.set(program)))
+    glUseProgram(program);
+}
+
+void GlES2State::activeTexture(int unit) {
+  if (count(active_unit_.set(unit)))
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GlES2State::bindTexture(GLuint texture) {
+  if (!active_unit_.known)
+    activeTexture(0);
+  // units past the cache go straight to GL
+  const int unit = active_unit_.value;
+  if (unit < 0 || unit >= kMaxTextureUnits) {
+    count(true);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    ++counters_.texture_binds;
+    return;
+  }
+  if (count(textures_[unit].set(texture))) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    ++counters_.texture_binds;
+  }
+}
+
+void GlES2State::bindTexture(int unit, GLuint texture) {
+  activeTexture(unit);
+  bindTexture(texture);
+}
+
+void GlES2State::bindBuffer(GLenum target, GLuint buffer) {
+  auto &cached = target == GL_ARRAY_BUFFER ? array_buffer_ : element_buffer_;
+  if (count(cached.set(buffer)))
+    glBindBuffer(target, buffer);
+}
+
+void GlES2State::enableVertexAttribArray(GLuint index) {
+  if (index >= kMaxVertexAttribs) {
+    glEnableVertexAttribArray(index);
+    return;
+  }
+  if (count(attrib_enabled_[index].set(true)))
+    glEnableVertexAttribArray(index);
+}
+
+void GlES2State::disableVertexAttribArray(GLuint index) {
+  if (index >= kMaxVertexAttribs) {
+    glDisableVertexAttribArray(index);
+    return;
+  }
+  if (count(attrib_enabled_[index].set(false)))
+    glDisableVertexAttribArray(index);
+}
+
+void GlES2State::vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                                     GLboolean normalized, GLsizei stride,
+                                     const void *pointer) {
+  const AttribPointer p = {array_buffer_.known ? array_buffer_.value : ~0u,
+                           size,
+                           type,
+                           normalized,
+                           stride,
+                           pointer};
+  if (index >= kMaxVertexAttribs || !array_buffer_.known ||
+      count(attrib_pointers_[index].set(p))) {
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+  }
+}
+
+void GlES2State::uniform1i(GLint location, GLint value) {
+  if (location < 0 || !program_.known) {
+    glUniform1i(location, value);
+    return;
+  }
+  auto it = uniform_ints_.find(uniformKey(location));
+  if (it != uniform_ints_.end() && it->second == value) {
+    count(false);
+    return;
+  }
+  uniform_ints_[uniformKey(location)] = value;
+  count(true);
+  glUniform1i(location, value);
+}
+
+void GlES2State::uniformMatrix4fv(GLint location, const GLfloat *value) {
+  if (location < 0 || !program_.known) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    return;
+  }
+  auto it = uniform_matrices_.find(uniformKey(location));
+  if (it != uniform_matrices_.end() &&
+      memcmp(it->second.data(), value, sizeof(it->second)) == 0) {
+    count(false);
+    return;
+  }
+  memcpy(uniform_matrices_[uniformKey(location)].data(), value,
+         sizeof(GLfloat) * 16);
+  count(true);
+  glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+int GlES2State::capabilityIndex(GLenum capability) const {
+  for (int i = 0; i < 4; ++i) {
+    if (kCapabilities[i] == capability)
+      return i;
+  }
+  return -1;
+}
+
+void GlES2State::setEnabled(GLenum capability, bool enabled) {
+  const int i = capabilityIndex(capability);
+  if (i < 0 || count(capabilities_[i].set(enabled))) {
+    if (enabled)
+      glEnable(capability);
+    else
+      glDisable(capability);
+  }
+}
+
+void GlES2State::blendFunc(GLenum src, GLenum dst) {
+  if (count(blend_func_.set({src, dst})))
+    glBlendFunc(src, dst);
+}
+
+void GlES2State::depthFunc(GLenum func) {
+  if (count(depth_func_.set(func)))
+    glDepthFunc(func);
+}
+
+void GlES2State::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (count(viewport_.set({x, y, width, height})))
+    glViewport(x, y, width, height);
+}
+
+void GlES2State::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+  if (count(clear_color_.set({r, g, b, a})))
+    glClearColor(r, g, b, a);
+}
+
+void GlES2State::pixelStorei(GLenum pname, GLint value) {
+  if (pname != GL_UNPACK_ALIGNMENT || count(unpack_alignment_.set(value)))
+    glPixelStorei(pname, value);
+}
+
+void GlES2State::onDeleteProgram(GLuint program) {
+  // the name may come back for a different program
+  if (program_.known && program_.value == program)
+    program_.known = false;
+  auto erase = [program](auto *map) {
+    for (auto it = map->begin(); it != map->end();)
+      it = (it->first >> 32) == program ? map->erase(it) : std::next(it);
+  };
+  erase(&uniform_ints_);
+  erase(&uniform_matrices_);
+}
+
+void GlES2State::onDeleteTexture(GLuint texture) {
+  // GL rebinds 0 wherever the texture was bound
+  for (auto &unit : textures_) {
+    if (unit.known && unit.value == texture)
+      unit.value = 0;
+  }
+}
+
+void GlES2State::onDeleteBuffer(GLuint buffer) {
+  for (auto *cached : {&array_buffer_, &element_buffer_}) {
+    if (cached->known && cached->value == buffer)
+      cached->value = 0;
+  }
+  for (auto &p : attrib_pointers_) {
+    if (p.known && p.value.buffer == buffer)
+      p.known = false;
+  }
+}
+
+void GlES2State::invalidate() {
+  const Counters counters = counters_;
+  *this = GlES2State();
+  counters_ = counters;
+}
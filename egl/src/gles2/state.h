@@ -0,0 +1,121 @@
+#ifndef EGL_SRC_GLES2_STATE_H_
+#define EGL_SRC_GLES2_STATE_H_
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include <GLES2/gl2.h>
+
+// Shadows the GL state of the current thread's context and drops calls that
+// would not change it. Everything that binds, enables or sets state should
+// go through here; after raw GL calls, invalidate() forgets what is known.
+class GlES2State {
+public:
+  struct Counters {
+    uint64_t issued = 0;
+    uint64_t elided = 0;
+    // issued glBindTexture calls, also part of |issued|
+    uint64_t texture_binds = 0;
+  };
+
+  // bindings on higher units (attributes at higher indices) are passed
+  // through uncached
+  static constexpr int kMaxTextureUnits = 8;
+  static constexpr int kMaxVertexAttribs = 16;
+
+  // one per thread, like the current context
+  static GlES2State &current();
+
+  void useProgram(GLuint program);
+  // on the active unit
+  void bindTexture(GLuint texture);
+  void bindTexture(int unit, GLuint texture);
+  void activeTexture(int unit);
+  void bindBuffer(GLenum target, GLuint buffer);
+
+  void enableVertexAttribArray(GLuint index);
+  void disableVertexAttribArray(GLuint index);
+  // remembers the GL_ARRAY_BUFFER binding together with the pointer
+  void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                           GLboolean normalized, GLsizei stride,
+                           const void *pointer);
+
+  // for the current program
+  void uniform1i(GLint location, GLint value);
+  void uniformMatrix4fv(GLint location, const GLfloat *value);
+
+  // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST
+  void setEnabled(GLenum capability, bool enabled);
+  void blendFunc(GLenum src, GLenum dst);
+  void depthFunc(GLenum func);
+  void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+  void pixelStorei(GLenum pname, GLint value);
+
+  // keep the shadow right when objects go away
+  void onDeleteProgram(GLuint program);
+  void onDeleteTexture(GLuint texture);
+  void onDeleteBuffer(GLuint buffer);
+
+  void invalidate();
+
+  const Counters &counters() const { return counters_; }
+  void resetCounters() { counters_ = Counters(); }
+
+private:
+  template <typename T> struct Cached {
+    T value{};
+    bool known = false;
+    // true when the value changed and the GL call must be issued
+    bool set(const T &v) {
+      if (known && value == v)
+        return false;
+      value = v;
+      known = true;
+      return true;
+    }
+  };
+  struct AttribPointer {
+    GLuint buffer;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void *pointer;
+    bool operator==(const AttribPointer &o) const {
+      return buffer == o.buffer && size == o.size && type == o.type &&
+             normalized == o.normalized && stride == o.stride &&
+             pointer == o.pointer;
+    }
+  };
+
+  bool count(bool changed) {
+    ++(changed ? counters_.issued : counters_.elided);
+    return changed;
+  }
+  int capabilityIndex(GLenum capability) const;
+  uint64_t uniformKey(GLint location) const {
+    return (static_cast<uint64_t>(program_.value) << 32) |
+           static_cast<uint32_t>(location);
+  }
+
+  Cached<GLuint> program_;
+  Cached<int> active_unit_;
+  std::array<Cached<GLuint>, kMaxTextureUnits> textures_;
+  Cached<GLuint> array_buffer_;
+  Cached<GLuint> element_buffer_;
+  std::array<Cached<bool>, kMaxVertexAttribs> attrib_enabled_;
+  std::array<Cached<AttribPointer>, kMaxVertexAttribs> attrib_pointers_;
+  std::array<Cached<bool>, 4> capabilities_;
+  Cached<std::array<GLenum, 2>> blend_func_;
+  Cached<GLenum> depth_func_;
+  Cached<std::array<GLint, 4>> viewport_;
+  Cached<std::array<GLfloat, 4>> clear_color_;
+  Cached<GLint> unpack_alignment_;
+  std::unordered_map<uint64_t, GLint> uniform_ints_;
+  std::unordered_map<uint64_t, std::array<GLfloat, 16>> uniform_matrices_;
+  Counters counters_;
+};
+
+#endif // EGL_SRC_GLES2_STATE_H_
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/bitmap_font.h"
+#include "gles2/state.h"
+#include "gles2/text_renderer.h"
+
+namespace {
+
+// screen pixels per distance field texel at |size|
+float texelSize(float size) {
+  return size / (BitmapFont::kCells * BitmapFont::kTexelsPerCell);
+}
+
+// about half a screen pixel of the field at |size|, to blend the outline
+// over
+float smoothing(float size) {
+  return std::clamp(0.25f / (BitmapFont::kSpread * texelSize(size)),
+                    1.0f / 256, 0.5f);
+}
+
+std::string runKey(const std::string &text, float size) {
+  std::string key(sizeof(size), '\0');
+  std::memcpy(&key[0], &size, sizeof(size));
+  return key + text;
+}
+
+} // namespace
+
+const char *const GlES2TextRenderer::kVertexShader = R"(
+        attribute vec2 a_position;
+        attribute vec2 a_uv;
+        uniform vec2 u_origin;
+        uniform vec2 u_viewport;
+        varying mediump vec2 v_uv;
+        void main() {
+            vec2 p = (a_position + u_origin) * u_viewport + vec2(-1.0, 1.0);
+            gl_Position = vec4(p, 0.0, 1.0);
+            v_uv = a_uv;
+        }
+    )";
+
+// the field is 0.5 on the outline; |u_smoothing| is about half a pixel
+const char *const GlES2TextRenderer::kFragmentShader = R"(
+        uniform sampler2D u_atlas;
+        uniform lowp vec4 u_color;
+        uniform mediump float u_smoothing;
+        varying mediump vec2 v_uv;
+        void main() {
+            mediump float d = texture2D(u_atlas, v_uv).a;
+            mediump float a =
+                smoothstep(0.5 - u_smoothing, 0.5 + u_smoothing, d);
+            gl_FragColor = vec4(u_color.rgb, u_color.a * a);
+        }
+    )";
+
+bool GlES2TextRenderer::initialize(GlES2ProgramCache *cache,
+                                   GlES2GlyphCache *glyphs) {
+  glyphs_ = glyphs;
+  program_ = cache->get(kVertexShader, kFragmentShader);
+  if (!program_)
+    return false;
+  a_position_ = program_->attribute("a_position");
+  a_uv_ = program_->attribute("a_uv");
+  u_origin_ = program_->uniform("u_origin");
+  u_viewport_ = program_->uniform("u_viewport");
+  u_color_ = program_->uniform("u_color");
+  u_smoothing_ = program_->uniform("u_smoothing");
+  u_atlas_ = program_->uniform("u_atlas");
+
+  std::vector<GLushort> indices(kMaxRunGlyphs * 6);
+  for (int i = 0; i < kMaxRunGlyphs; ++i) {
+    const GLushort v = i * 4;
+    const GLushort quad[] = {v,
+                             static_cast<GLushort>(v + 1),
+                             static_cast<GLushort>(v + 2),
+                             static_cast<GLushort>(v + 2),
+                             static_cast<GLushort>(v + 1),
+                             static_cast<GLushort>(v + 3)};
+    std::copy(quad, quad + 6, indices.begin() + i * 6);
+  }
+  return indices_.initialize(indices.size() * sizeof(GLushort),
+                             indices.data());
+}
+
+std::shared_ptr<GlES2TextRun>
+GlES2TextRenderer::layout(const std::string &text, float size) {
+  if (text.empty() || text.size() > static_cast<size_t>(kMaxRunGlyphs))
+    return nullptr;
+  std::shared_ptr<GlES2TextRun> &run = runs_[runKey(text, size)];
+  if (run) {
+    ++stats_.run_hits;
+    return run;
+  }
+  run = std::make_shared<GlES2TextRun>();
+  run->text_ = text;
+  run->size_ = size;
+  if (!build(run.get())) {
+    runs_.erase(runKey(text, size));
+    return nullptr;
+  }
+  run->last_frame_ = frame_;
+  return run;
+}
+
+bool GlES2TextRenderer::build(GlES2TextRun *run) {
+  TRACE_SCOPE("GlES2TextRenderer::build");
+  const float texel = texelSize(run->size_);
+  const float border = texel * BitmapFont::kSpread;
+  const float extent = texel * BitmapFont::kSdfSize;
+  const float line_height = run->size_ * kLineSpacing;
+
+  // a glyph looked up late in the run may evict the page of an earlier
+  // one; the second pass finds those pages recently used
+  for (int attempt = 0;; ++attempt) {
+    const uint64_t generation = glyphs_->generation();
+    quads_.clear();
+    handles_.clear();
+    keys_.clear();
+    float pen = 0, top = 0, width = 0;
+    for (const char ch : run->text_) {
+      const unsigned char b = ch;
+      if ((b & 0xc0) == 0x80) // UTF-8 continuation
+        continue;
+      if (b == '\n') {
+        pen = 0;
+        top += line_height;
+        continue;
+      }
+      if (b != ' ') {
+        GlES2GlyphCache::Glyph g;
+        if (!glyphs_->glyph(b < 0x80 ? b : 0xfffd, &g))
+          return false;
+        const float x0 = pen - border, y0 = top - border;
+        const float x1 = x0 + extent, y1 = y0 + extent;
+        quads_.push_back({x0, y0, g.u0, g.v0});
+        quads_.push_back({x0, y1, g.u0, g.v1});
+        quads_.push_back({x1, y0, g.u1, g.v0});
+        quads_.push_back({x1, y1, g.u1, g.v1});
+        keys_.push_back(static_cast<uint64_t>(g.texture) << 32 |
+                        handles_.size());
+        handles_.push_back(g.handle);
+      }
+      pen += run->size_;
+      width = std::max(width, pen);
+    }
+    run->width_ = width;
+    run->height_ = top + line_height;
+    if (glyphs_->generation() == generation)
+      break;
+    if (attempt == 1) {
+      LOG_W << "text run needs more glyph atlas pages than there are";
+      break;
+    }
+  }
+
+  // by page, then text order
+  const size_t n = handles_.size();
+  std::sort(keys_.begin(), keys_.end());
+  sorted_.resize(n * 4);
+  run->segments_.clear();
+  for (size_t i = 0; i < n; ++i) {
+    const uint32_t q = keys_[i] & 0xffffffff;
+    const GLuint texture = keys_[i] >> 32;
+    std::copy(quads_.begin() + q * 4, quads_.begin() + q * 4 + 4,
+              sorted_.begin() + i * 4);
+    if (run->segments_.empty() || run->segments_.back().texture != texture)
+      run->segments_.push_back(
+          {texture, static_cast<uint32_t>(i), 0, handles_[q]});
+    ++run->segments_.back().count;
+  }
+  if (n > 0 &&
+      !run->vertices_.initialize(sorted_.size() * sizeof(GlES2TextRun::Vertex),
+                                 sorted_.data())) {
+    run->segments_.clear();
+    return false;
+  }
+  run->glyphs_ = n;
+  run->generation_ = glyphs_->generation();
+  ++stats_.runs_built;
+  stats_.glyphs_laid_out += n;
+  return true;
+}
+
+bool GlES2TextRenderer::refresh(GlES2TextRun *run) {
+  if (run->generation_ == glyphs_->generation())
+    return true;
+  for (const GlES2TextRun::Segment &s : run->segments_) {
+    if (!glyphs_->resident(s.handle))
+      return build(run);
+  }
+  run->generation_ = glyphs_->generation();
+  return true;
+}
+
+void GlES2TextRenderer::draw(std::shared_ptr<GlES2TextRun> run, float x,
+                             float y, uint32_t color) {
+  if (run)
+    queue_.push_back({std::move(run), x, y, color});
+}
+
+void GlES2TextRenderer::drawQueued(int width, int height) {
+  // make every run resident before drawing any: laying one out again may
+  // evict a page another one was going to draw from
+  for (const Queued &q : queue_) {
+    if (!refresh(q.run.get()))
+      q.run->segments_.clear();
+    for (const GlES2TextRun::Segment &s : q.run->segments_)
+      glyphs_->touch(s.handle);
+    q.run->last_frame_ = frame_;
+  }
+
+  GlES2State &gl = GlES2State::current();
+  gl.useProgram(program_->program());
+  gl.uniform1i(u_atlas_, 0);
+  glUniform2f(u_viewport_, 2.0f / width, -2.0f / height);
+  gl.setEnabled(GL_BLEND, true);
+  gl.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  gl.enableVertexAttribArray(a_position_);
+  gl.enableVertexAttribArray(a_uv_);
+  indices_.bind();
+  // runs of one color or size in a row set it once
+  uint32_t color = 0;
+  float size = 0;
+  bool first = true;
+  for (const Queued &q : queue_) {
+    const GlES2TextRun *run = q.run.get();
+    if (run->segments_.empty())
+      continue;
+    run->vertices_.bind();
+    gl.vertexAttribPointer(a_position_, 2, GL_FLOAT, GL_FALSE,
+                           sizeof(GlES2TextRun::Vertex), nullptr);
+    gl.vertexAttribPointer(
+        a_uv_, 2, GL_FLOAT, GL_FALSE, sizeof(GlES2TextRun::Vertex),
+        reinterpret_cast<void *>(offsetof(GlES2TextRun::Vertex, u)));
+    glUniform2f(u_origin_, q.x, q.y);
+    if (first || q.color != color) {
+      color = q.color;
+      glUniform4f(u_color_, (color & 0xff) / 255.0f,
+                  (color >> 8 & 0xff) / 255.0f, (color >> 16 & 0xff) / 255.0f,
+                  (color >> 24) / 255.0f);
+    }
+    if (first || run->size_ != size) {
+      size = run->size_;
+      glUniform1f(u_smoothing_, smoothing(size));
+    }
+    first = false;
+    for (const GlES2TextRun::Segment &s : run->segments_) {
+      gl.bindTexture(0, s.texture);
+      glDrawElements(GL_TRIANGLES, s.count * 6, GL_UNSIGNED_SHORT,
+                     reinterpret_cast<void *>(s.first * 6 * sizeof(GLushort)));
+      ++stats_.draw_calls;
+    }
+    stats_.glyphs_drawn += run->glyphs_;
+  }
+  gl.setEnabled(GL_BLEND, false);
+}
+
+void GlES2TextRenderer::flush(int width, int height) {
+  TRACE_SCOPE("GlES2TextRenderer::flush");
+  ++frame_;
+  if (!queue_.empty()) {
+    drawQueued(width, height);
+    queue_.clear();
+  }
+
+  // a sweep every kRunLifetime frames, not a walk over the cache every
+  // frame: an unused run goes after one to two lifetimes
+  if (frame_ % kRunLifetime != 0)
+    return;
+  for (auto it = runs_.begin(); it != runs_.end();) {
+    if (frame_ - it->second->last_frame_ > kRunLifetime)
+      it = runs_.erase(it);
+    else
+      ++it;
+  }
+}
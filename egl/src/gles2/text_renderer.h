@@ -0,0 +1,141 @@
+#ifndef EGL_SRC_GLES2_TEXT_RENDERER_H_
+#define EGL_SRC_GLES2_TEXT_RENDERER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/buffer.h"
+#include "gles2/glyph_cache.h"
+#include "gles2/program_cache.h"
+#include "gles2/shader.h"
+
+// A string laid out once: the quads of its glyphs, relative to its top
+// left corner and grouped by atlas page, in a static VBO of its own.
+class GlES2TextRun {
+public:
+  float width() const { return width_; }
+  float height() const { return height_; }
+  size_t glyphs() const { return glyphs_; }
+
+private:
+  friend class GlES2TextRenderer;
+
+  struct Vertex {
+    GLfloat x, y, u, v;
+  };
+  // the quads on one page
+  struct Segment {
+    GLuint texture;
+    uint32_t first; // in quads
+    uint32_t count;
+    GlES2TextureAtlas::Handle handle; // one of its glyphs, to touch
+  };
+
+  std::string text_;
+  float size_ = 0;
+  float width_ = 0;
+  float height_ = 0;
+  size_t glyphs_ = 0;
+  GlES2Buffer vertices_; // 4 per quad
+  std::vector<Segment> segments_;
+  // GlES2GlyphCache::generation() at layout
+  uint64_t generation_ = 0;
+  uint64_t last_frame_ = 0;
+};
+
+// Draws text from the glyph cache's distance fields, which keep their
+// edges sharp at any size. A string is laid out into a GlES2TextRun once
+// and the run cached while it is drawn, so a string that does not change
+// needs no glyph lookups and no vertex work after its first frame: its
+// quads stay in its VBO, and flush() passes the position, color and edge
+// smoothing as uniforms and makes one glDrawElements per page the run
+// draws from.
+//
+// Text is a line of |size| pixels per kCells rows of the font, monospaced,
+// with '\n' starting a new line; UTF-8 outside printable ASCII shows as
+// the font's fallback.
+class GlES2TextRenderer {
+public:
+  struct Stats {
+    uint64_t runs_built = 0;
+    uint64_t run_hits = 0;
+    uint64_t glyphs_laid_out = 0;
+    uint64_t glyphs_drawn = 0;
+    uint64_t draw_calls = 0;
+  };
+
+  // glyphs per run and per draw, bounded by the 16-bit indices
+  static constexpr int kMaxRunGlyphs = 16384;
+  // cached runs not drawn for this many frames are dropped at the next
+  // sweep, which runs as often
+  static constexpr uint64_t kRunLifetime = 120;
+  // line height over size
+  static constexpr float kLineSpacing = 1.25f;
+
+  static const char *const kVertexShader;
+  static const char *const kFragmentShader;
+
+  // |glyphs| outlives the renderer
+  bool initialize(GlES2ProgramCache *cache, GlES2GlyphCache *glyphs);
+
+  // the run of |text| at |size|, from the cache or laid out now; keep it
+  // to skip the lookup as well. Null when |text| is empty, longer than
+  // kMaxRunGlyphs bytes or does not fit in the atlas.
+  std::shared_ptr<GlES2TextRun> layout(const std::string &text, float size);
+  // queues |run| with its top left corner at (x, y) pixels, y down.
+  // |color| is RGBA8, R in the lowest byte.
+  void draw(std::shared_ptr<GlES2TextRun> run, float x, float y,
+            uint32_t color);
+  void draw(const std::string &text, float x, float y, float size,
+            uint32_t color) {
+    draw(layout(text, size), x, y, color);
+  }
+  // draws the queued runs, blended, over a |width| x |height| viewport;
+  // runs whose glyphs were evicted from the atlas are laid out again first
+  void flush(int width, int height);
+
+  size_t cachedRuns() const { return runs_.size(); }
+  const Stats &stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  struct Queued {
+    std::shared_ptr<GlES2TextRun> run;
+    float x, y;
+    uint32_t color;
+  };
+
+  bool build(GlES2TextRun *run);
+  // lays |run| out again if a page it draws from was evicted
+  bool refresh(GlES2TextRun *run);
+  // draws |queue_|, in order
+  void drawQueued(int width, int height);
+
+  GlES2GlyphCache *glyphs_ = nullptr;
+  std::shared_ptr<GlES2ShaderProgram> program_;
+  GLint a_position_ = -1;
+  GLint a_uv_ = -1;
+  GLint u_origin_ = -1;
+  GLint u_viewport_ = -1;
+  GLint u_color_ = -1;
+  GLint u_smoothing_ = -1;
+  GLint u_atlas_ = -1;
+  GlES2Buffer indices_{GL_ELEMENT_ARRAY_BUFFER};
+  // text and size -> run
+  std::unordered_map<std::string, std::shared_ptr<GlES2TextRun>> runs_;
+  std::vector<Queued> queue_;
+  // build() scratch: quads in text order, then sorted by page
+  std::vector<GlES2TextRun::Vertex> quads_;
+  std::vector<GlES2TextRun::Vertex> sorted_;
+  std::vector<GlES2TextureAtlas::Handle> handles_;
+  std::vector<uint64_t> keys_;
+  uint64_t frame_ = 0;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_TEXT_RENDERER_H_
@@ -1,6 +1,42 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/state.h"
 #include "gles2/texture.h"
 #include "gles2/utils.h"
 
+#ifndef GL_UNPACK_ROW_LENGTH_EXT
+#define GL_UNPACK_ROW_LENGTH_EXT 0x0CF2
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+namespace {
+
+// largest of 8/4/2/1 that every row start of |data| honours
+GLint unpackAlignment(const unsigned char *data, int stride) {
+  const uintptr_t bits = reinterpret_cast<uintptr_t>(data) | stride;
+  for (GLint a = 8; a > 1; a /= 2) {
+    if ((bits & (a - 1)) == 0)
+      return a;
+  }
+  return 1;
+}
+
+bool hasUnpackSubimage() {
+  static const bool has = hasGLES2Extension("GL_EXT_unpack_subimage");
+  return has;
+}
+
+bool isPowerOfTwo(int v) { return v > 0 && (v & (v - 1)) == 0; }
+
+} // namespace
+
 std::optional<GlES2Texture> GlES2Texture::create() {
   GLuint tex_handle = 0;
   // TODO: some textures
@@ -8,10 +44,38 @@ std::optional<GlES2Texture> GlES2Texture::create() {
   return GlES2Texture(tex_handle);
 }
 
+GlES2Texture::~GlES2Texture() { release(); }
+
+GlES2Texture::GlES2Texture(GlES2Texture &&other)
+    : texture_(std::exchange(other.texture_, 0)), width_(other.width_),
+      height_(other.height_), format_(other.format_),
+      levels_(other.levels_), scratch_(std::move(other.scratch_)) {}
+
+GlES2Texture &GlES2Texture::operator=(GlES2Texture &&other) {
+  if (this != &other) {
+    release();
+    texture_ = std::exchange(other.texture_, 0);
+    width_ = other.width_;
+    height_ = other.height_;
+    format_ = other.format_;
+    levels_ = other.levels_;
+    scratch_ = std::move(other.scratch_);
+  }
+  return *this;
+}
+
+void GlES2Texture::release() {
+  if (texture_) {
+    GlES2State::current().onDeleteTexture(texture_);
+    glDeleteTextures(1, &texture_);
+    texture_ = 0;
+  }
+}
+
 void GlES2Texture::initialize() {
 
-  glBindTexture(GL_TEXTURE_2D, texture_);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  GlES2State::current().bindTexture(texture_);
+  GlES2State::current().pixelStorei(GL_UNPACK_ALIGNMENT, 1);
   // // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   // // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -19,18 +83,179 @@ void GlES2Texture::initialize() {
   // // glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 }
 
-void GlES2Texture::setBuffer(unsigned char *data) {
-  const int frame_width = 256;
-  const int frame_height = 256;
-  glBindTexture(GL_TEXTURE_2D, texture_);
-  assert(checkGLES2Error());
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_width, frame_height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, data);
+int GlES2Texture::bytesPerPixel(GLenum format) {
+  switch (format) {
+  case GL_RGBA:
+    return 4;
+  case GL_RGB:
+    return 3;
+  case GL_LUMINANCE_ALPHA:
+    return 2;
+  case GL_LUMINANCE:
+  case GL_ALPHA:
+    return 1;
+  }
+  return 0;
+}
+
+size_t GlES2Texture::levelBytes(int width, int height, GLenum format) {
+  if (format == GL_ETC1_RGB8_OES) // 8 bytes per 4x4 block
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+  return static_cast<size_t>(width) * height * bytesPerPixel(format);
+}
+
+size_t GlES2Texture::memoryBytes() const {
+  size_t bytes = 0;
+  for (int l = 0; l < levels_; ++l)
+    bytes += levelBytes(std::max(1, width_ >> l), std::max(1, height_ >> l),
+                        format_);
+  return bytes;
+}
+
+bool GlES2Texture::allocate(int width, int height, GLenum format) {
+  if (bytesPerPixel(format) == 0) {
+    LOG_E << "unsupported texture format: " << format;
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  format_ = format;
+  levels_ = 1;
+  GlES2State::current().bindTexture(texture_);
+  glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
+               GL_UNSIGNED_BYTE, nullptr);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return checkGLES2Error();
+}
+
+void GlES2Texture::update(const unsigned char *data, int stride) {
+  update(data, stride, {Rect{0, 0, width_, height_}});
+}
+
+void GlES2Texture::update(const unsigned char *data, int stride,
+                          const std::vector<Rect> &rects) {
+  TRACE_SCOPE("GlES2Texture::update");
+  if (stride == 0)
+    stride = width_ * bytesPerPixel(format_);
+  const int bpp = bytesPerPixel(format_);
+  GlES2State::current().bindTexture(texture_);
+  for (const Rect &rect : rects)
+    updateRect(data + rect.y * stride + rect.x * bpp, stride, rect);
   assert(checkGLES2Error());
 }
 
+void GlES2Texture::updateRegion(const Rect &rect, const unsigned char *data,
+                                int stride) {
+  if (stride == 0)
+    stride = rect.width * bytesPerPixel(format_);
+  GlES2State::current().bindTexture(texture_);
+  updateRect(data, stride, rect);
+  assert(checkGLES2Error());
+}
+
+void GlES2Texture::updateRect(const unsigned char *origin, int stride,
+                              const Rect &rect) {
+  const int bpp = bytesPerPixel(format_);
+  const int row_bytes = rect.width * bpp;
+  GlES2State &state = GlES2State::current();
+
+  if (stride == row_bytes || rect.height == 1) {
+    // rows are contiguous (or there is only one)
+    state.pixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(origin, row_bytes));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height,
+                    format_, GL_UNSIGNED_BYTE, origin);
+  } else if (stride % bpp == 0 && hasUnpackSubimage()) {
+    state.pixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(origin, stride));
+    state.pixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / bpp);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height,
+                    format_, GL_UNSIGNED_BYTE, origin);
+    state.pixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+  } else {
+    // plain GLES2 has no row length: repack the rows tightly
+    scratch_.resize(static_cast<size_t>(row_bytes) * rect.height);
+    for (int y = 0; y < rect.height; ++y)
+      memcpy(scratch_.data() + y * row_bytes, origin + y * stride, row_bytes);
+    state.pixelStorei(GL_UNPACK_ALIGNMENT,
+                      unpackAlignment(scratch_.data(), row_bytes));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height,
+                    format_, GL_UNSIGNED_BYTE, scratch_.data());
+  }
+}
+
+bool GlES2Texture::uploadLevel(int level, int width, int height,
+                               GLenum format, const unsigned char *data) {
+  if (level == 0) {
+    width_ = width;
+    height_ = height;
+    format_ = format;
+    levels_ = 0;
+  }
+  levels_ = std::max(levels_, level + 1);
+  GlES2State &state = GlES2State::current();
+  state.bindTexture(texture_);
+  state.pixelStorei(GL_UNPACK_ALIGNMENT,
+                    unpackAlignment(data, width * bytesPerPixel(format)));
+  glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format,
+               GL_UNSIGNED_BYTE, data);
+  return checkGLES2Error();
+}
+
+bool GlES2Texture::uploadCompressed(int level, int width, int height,
+                                    GLenum internal_format, const void *data,
+                                    size_t size) {
+  if (level == 0) {
+    width_ = width;
+    height_ = height;
+    format_ = internal_format;
+    levels_ = 0;
+  }
+  levels_ = std::max(levels_, level + 1);
+  GlES2State::current().bindTexture(texture_);
+  glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format, width, height,
+                         0, size, data);
+  return checkGLES2Error();
+}
+
+void GlES2Texture::setLinearFilter(bool mipmapped) {
+  GlES2State::current().bindTexture(texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+bool GlES2Texture::generateMipmap() {
+  static const bool has_npot = hasGLES2Extension("GL_OES_texture_npot");
+  if (bytesPerPixel(format_) == 0 ||
+      (!has_npot && !(isPowerOfTwo(width_) && isPowerOfTwo(height_)))) {
+    LOG_W << "cannot generate mipmaps for " << width_ << "x" << height_
+          << " format " << format_;
+    return false;
+  }
+  GlES2State::current().bindTexture(texture_);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  levels_ = 1;
+  for (int size = std::max(width_, height_); size > 1; size /= 2)
+    ++levels_;
+  setLinearFilter(true);
+  return checkGLES2Error();
+}
+
+void GlES2Texture::setBuffer(unsigned char *data) {
+  TRACE_SCOPE("GlES2Texture::setBuffer");
+  const int frame_width = 256;
+  const int frame_height = 256;
+  if (width_ != frame_width || height_ != frame_height ||
+      format_ != GL_RGBA) {
+    allocate(frame_width, frame_height, GL_RGBA);
+  }
+  update(data);
+}
+
 void GlES2Texture::render() {
   // const int frame_width = 256;
   // const int frame_height = 256;
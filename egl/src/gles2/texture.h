@@ -1,23 +1,89 @@
 #ifndef EGL_SRC_GLES2_TEXTURE_H_
 #define EGL_SRC_GLES2_TEXTURE_H_
 
+#include <cstddef>
 #include <optional>
+#include <vector>
 
 #include <GLES2/gl2.h>
 
+// owns one texture name
 class GlES2Texture {
 public:
+  struct Rect {
+    int x, y, width, height;
+  };
+
   // GlES2Texture(GLuint texture = 0) : texture_(texture){};
   static std::optional<GlES2Texture> create();
+  ~GlES2Texture();
+  GlES2Texture(GlES2Texture &&other);
+  GlES2Texture &operator=(GlES2Texture &&other);
+  GlES2Texture(const GlES2Texture &) = delete;
+  GlES2Texture &operator=(const GlES2Texture &) = delete;
 
   void initialize();
 
+  // allocates the storage once. |format| is GL_RGBA, GL_RGB,
+  // GL_LUMINANCE_ALPHA, GL_LUMINANCE or GL_ALPHA (unsigned bytes).
+  bool allocate(int width, int height, GLenum format = GL_RGBA);
+  // replaces the whole image. |stride| is the row pitch of |data| in bytes;
+  // 0 means tightly packed.
+  void update(const unsigned char *data, int stride = 0);
+  // replaces only |rects|. |data| points at the full source frame.
+  void update(const unsigned char *data, int stride,
+              const std::vector<Rect> &rects);
+  // writes |data|, which holds only the texels of |rect|, into |rect|.
+  // |stride| 0 means tightly packed.
+  void updateRegion(const Rect &rect, const unsigned char *data,
+                    int stride = 0);
+
+  // mip |level| of |width| x |height| tightly packed texels; level 0 sets
+  // the size and format
+  bool uploadLevel(int level, int width, int height, GLenum format,
+                   const unsigned char *data);
+  // mip |level| in a compressed |internal_format| (e.g. GL_ETC1_RGB8_OES).
+  // Such textures cannot be updated afterwards.
+  bool uploadCompressed(int level, int width, int height,
+                        GLenum internal_format, const void *data,
+                        size_t size);
+  // linear filtering, trilinear when |mipmapped|
+  void setLinearFilter(bool mipmapped);
+  // fills the mip chain below level 0 and switches to trilinear filtering.
+  // Fails for compressed textures, and for NPOT ones without
+  // GL_OES_texture_npot.
+  bool generateMipmap();
+
+  // estimated video memory of the uploaded levels
+  size_t memoryBytes() const;
+
+  // 256x256 RGBA; allocates on the first call and sub-updates afterwards
   void setBuffer(unsigned char *data);
   void render();
 
+  GLuint texture() const { return texture_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  GLenum format() const { return format_; }
+  int levels() const { return levels_; }
+  static int bytesPerPixel(GLenum format);
+  // one |width| x |height| level in |format|, compressed formats included
+  static size_t levelBytes(int width, int height, GLenum format);
+
 private:
   GlES2Texture(GLuint texture) : texture_(texture){};
+  // |origin| is the first texel of |rect| in client memory
+  void updateRect(const unsigned char *origin, int stride, const Rect &rect);
+
+  void release();
+
   GLuint texture_;
+  int width_ = 0;
+  int height_ = 0;
+  GLenum format_ = GL_RGBA;
+  int levels_ = 0;
+  // repacked rows for partial-width updates without GL_UNPACK_ROW_LENGTH
+  std::vector<unsigned char> scratch_;
 };
 
-#endif // EGL_SRC_GLES2_TEXTURE_H_
\ No newline at end of file
+#endif // EGL_SRC_GLES2_TEXTURE_H_
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/texture_atlas.h"
+
+bool GlES2TextureAtlas::initialize(const Config &config) {
+  if (GlES2Texture::bytesPerPixel(config.format) == 0 ||
+      config.page_size <= 2 * config.padding || config.max_pages < 1) {
+    LOG_E << "invalid atlas config";
+    return false;
+  }
+  config_ = config;
+  pages_.clear();
+  regions_.clear();
+  free_slots_.clear();
+  stats_ = Stats();
+  return true;
+}
+
+int GlES2TextureAtlas::place(int width, int height, int *x, int *y) {
+  for (size_t p = 0; p < pages_.size(); ++p) {
+    if (pages_[p].packer.insert(width, height, x, y))
+      return p;
+  }
+  int page = pages_.size();
+  if (page < config_.max_pages) {
+    auto texture = GlES2Texture::create();
+    if (!texture || !texture->allocate(config_.page_size, config_.page_size,
+                                       config_.format))
+      return -1;
+    if (config_.linear_filter)
+      texture->setLinearFilter(false);
+    pages_.push_back({std::move(*texture), SkylinePacker(config_.page_size,
+                                              config_.page_size)});
+    stats_.pages = pages_.size();
+    stats_.page_area +=
+        static_cast<int64_t>(config_.page_size) * config_.page_size;
+  } else {
+    page = std::min_element(pages_.begin(), pages_.end(),
+                            [](const Page &a, const Page &b) {
+                              return a.last_use < b.last_use;
+                            }) -
+           pages_.begin();
+    evict(page);
+  }
+  return pages_[page].packer.insert(width, height, x, y) ? page : -1;
+}
+
+void GlES2TextureAtlas::evict(int page) {
+  Page &p = pages_[page];
+  VLOG(1) << "atlas page " << page << " evicted with " << p.slots.size()
+          << " images";
+  for (uint32_t slot : p.slots) {
+    regions_[slot].page = -1;
+    ++regions_[slot].generation;
+    free_slots_.push_back(slot);
+  }
+  stats_.evicted_regions += p.slots.size();
+  ++stats_.evicted_pages;
+  stats_.image_area -= p.image_area;
+  stats_.allocated_area -= p.packer.usedArea();
+  p.slots.clear();
+  p.image_area = 0;
+  p.packer.reset(config_.page_size, config_.page_size);
+}
+
+GlES2TextureAtlas::Handle GlES2TextureAtlas::insert(const unsigned char *data,
+                                                    int width, int height,
+                                                    int stride) {
+  TRACE_SCOPE("GlES2TextureAtlas::insert");
+  const int pad = config_.padding;
+  const int padded_width = width + 2 * pad;
+  const int padded_height = height + 2 * pad;
+  if (width <= 0 || height <= 0 || padded_width > config_.page_size ||
+      padded_height > config_.page_size) {
+    LOG_W << "image does not fit an atlas page: " << width << "x" << height;
+    return kInvalid;
+  }
+  int x = 0, y = 0;
+  const int page = place(padded_width, padded_height, &x, &y);
+  if (page < 0)
+    return kInvalid;
+
+  // the image with its edge texels repeated into the padding
+  const int bpp = GlES2Texture::bytesPerPixel(config_.format);
+  if (stride == 0)
+    stride = width * bpp;
+  const int row_bytes = padded_width * bpp;
+  scratch_.resize(static_cast<size_t>(row_bytes) * padded_height);
+  for (int py = 0; py < padded_height; ++py) {
+    const unsigned char *src =
+        data + std::clamp(py - pad, 0, height - 1) * stride;
+    unsigned char *dst = scratch_.data() + py * row_bytes;
+    for (int px = 0; px < pad; ++px) {
+      memcpy(dst + px * bpp, src, bpp);
+      memcpy(dst + (pad + width + px) * bpp, src + (width - 1) * bpp, bpp);
+    }
+    memcpy(dst + pad * bpp, src, width * bpp);
+  }
+  Page &p = pages_[page];
+  p.texture.updateRegion({x, y, padded_width, padded_height}, scratch_.data());
+
+  const float size = config_.page_size;
+  Region region;
+  region.texture = p.texture.texture();
+  region.page = page;
+  region.x = x + pad;
+  region.y = y + pad;
+  region.width = width;
+  region.height = height;
+  region.u0 = region.x / size;
+  region.v0 = region.y / size;
+  region.u1 = (region.x + width) / size;
+  region.v1 = (region.y + height) / size;
+
+  uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = regions_.size();
+    regions_.push_back(region);
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+    region.generation = regions_[slot].generation;
+    regions_[slot] = region;
+  }
+  p.slots.push_back(slot);
+  p.last_use = ++use_clock_;
+  p.image_area += static_cast<int64_t>(width) * height;
+  ++stats_.inserts;
+  stats_.image_area += static_cast<int64_t>(width) * height;
+  stats_.allocated_area +=
+      static_cast<int64_t>(padded_width) * padded_height;
+  return static_cast<Handle>(region.generation) << 32 | slot;
+}
+
+const GlES2TextureAtlas::Region &GlES2TextureAtlas::region(Handle handle) {
+  const Region &r = regions_[handle & 0xffffffff];
+  if (r.page >= 0)
+    pages_[r.page].last_use = ++use_clock_;
+  return r;
+}
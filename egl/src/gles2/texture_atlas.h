@@ -0,0 +1,100 @@
+#ifndef EGL_SRC_GLES2_TEXTURE_ATLAS_H_
+#define EGL_SRC_GLES2_TEXTURE_ATLAS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/skyline_packer.h"
+#include "gles2/texture.h"
+
+// Packs many small images into a few large pages, so that sprites using
+// them share a texture binding. Each image gets |padding| texels of its own
+// edge pixels around it, so that filtering at the border never samples a
+// neighbour.
+//
+// Pages are added as they fill up, up to max_pages; after that the least
+// recently used page is emptied and its handles become invalid (callers
+// re-insert on a miss). The slots of evicted handles are reused by later
+// inserts with a new generation, so the handle table stays as large as
+// the most images resident at once and stale handles stay invalid.
+class GlES2TextureAtlas {
+public:
+  struct Config {
+    int page_size = 1024;
+    int max_pages = 4;
+    int padding = 1;
+    GLenum format = GL_RGBA;
+    // filter the pages linearly, e.g. for distance fields; nearest by
+    // default
+    bool linear_filter = false;
+  };
+
+  // slot index in the low 32 bits, its generation in the high ones
+  using Handle = uint64_t;
+  static constexpr Handle kInvalid = UINT64_MAX;
+
+  struct Region {
+    GLuint texture = 0;
+    float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+    int page = -1; // -1 once evicted
+    int x = 0, y = 0, width = 0, height = 0;
+    // bumped when the slot is freed
+    uint32_t generation = 0;
+  };
+
+  struct Stats {
+    uint64_t inserts = 0;
+    uint64_t evicted_pages = 0;
+    uint64_t evicted_regions = 0;
+    int pages = 0;
+    int64_t image_area = 0;     // texels of live images
+    int64_t allocated_area = 0; // including padding
+    int64_t page_area = 0;
+    // live image texels per page texel
+    double efficiency() const {
+      return page_area ? static_cast<double>(image_area) / page_area : 0;
+    }
+  };
+
+  bool initialize(const Config &config);
+
+  // uploads |width| x |height| texels of |data| (|stride| bytes per row, 0
+  // when tightly packed) into a page. kInvalid when the image is larger
+  // than a page.
+  Handle insert(const unsigned char *data, int width, int height,
+                int stride = 0);
+  bool valid(Handle handle) const {
+    const uint32_t slot = handle & 0xffffffff;
+    return slot < regions_.size() && regions_[slot].page >= 0 &&
+           regions_[slot].generation == handle >> 32;
+  }
+  // also marks the page as used for eviction. |handle| must be valid.
+  const Region &region(Handle handle);
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  struct Page {
+    GlES2Texture texture;
+    SkylinePacker packer;
+    uint64_t last_use = 0;
+    int64_t image_area = 0;
+    std::vector<uint32_t> slots;
+  };
+
+  // a page with room for |width| x |height|, or -1
+  int place(int width, int height, int *x, int *y);
+  void evict(int page);
+
+  Config config_;
+  std::vector<Page> pages_;
+  std::vector<Region> regions_;
+  std::vector<uint32_t> free_slots_;
+  uint64_t use_clock_ = 0;
+  std::vector<unsigned char> scratch_;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_TEXTURE_ATLAS_H_
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "base/clock.h"
+#include "base/logging.h"
+#include "base/mapped_file.h"
+#include "base/trace.h"
+#include "gles2/etc1.h"
+#include "gles2/texture_loader.h"
+#include "gles2/utils.h"
+
+bool hasEtc1Support() {
+  static const bool has =
+      hasGLES2Extension("GL_OES_compressed_ETC1_RGB8_texture");
+  return has;
+}
+
+bool loadEtc1Texture(const std::string &path, GlES2Texture *texture,
+                     Etc1LoadInfo *info, const Etc1LoadOptions &options) {
+  TRACE_SCOPE("loadEtc1Texture");
+  const int64_t begin = monotonicNowNs();
+  MappedFile file;
+  if (!file.open(path))
+    return false;
+  std::vector<Etc1::Level> levels;
+  if (!Etc1::parse(file.data(), file.size(), &levels)) {
+    LOG_E << "cannot load " << path;
+    return false;
+  }
+
+  Etc1LoadInfo result;
+  result.compressed = options.allow_compressed && hasEtc1Support();
+  result.width = levels[0].width;
+  result.height = levels[0].height;
+  result.levels = levels.size();
+  result.file_bytes = file.size();
+  const int threads =
+      options.decode_threads > 0
+          ? options.decode_threads
+          : std::max(1u, std::thread::hardware_concurrency());
+  std::vector<uint8_t, PoolAllocator<uint8_t>> rgba(
+      PoolAllocator<uint8_t>(options.pixel_pool));
+  // one buffer for the whole chain, level 0 being the largest
+  if (!result.compressed)
+    rgba.reserve(static_cast<size_t>(result.width) * result.height * 4);
+  for (size_t l = 0; l < levels.size(); ++l) {
+    const Etc1::Level &level = levels[l];
+    const size_t level_rgba =
+        static_cast<size_t>(level.width) * level.height * 4;
+    result.rgba_bytes += level_rgba;
+    bool ok;
+    if (result.compressed) {
+      ok = texture->uploadCompressed(l, level.width, level.height,
+                                     Etc1::kInternalFormat, level.data,
+                                     Etc1::encodedSize(level.width,
+                                                       level.height));
+      result.gpu_bytes += Etc1::encodedSize(level.width, level.height);
+    } else {
+      rgba.resize(level_rgba);
+      Etc1::decode(level, rgba.data(), threads);
+      ok = texture->uploadLevel(l, level.width, level.height, GL_RGBA,
+                                rgba.data());
+      result.gpu_bytes += level_rgba;
+    }
+    if (!ok) {
+      LOG_E << "cannot upload " << path << " level " << l;
+      return false;
+    }
+  }
+  // GLES2 samples mipmaps only from a complete chain
+  const bool complete_chain = levels.size() > 1 &&
+                              levels.back().width == 1 &&
+                              levels.back().height == 1;
+  texture->setLinearFilter(complete_chain);
+  result.load_ns = monotonicNowNs() - begin;
+  if (info)
+    *info = result;
+  return true;
+}
@@ -0,0 +1,40 @@
+#ifndef EGL_SRC_GLES2_TEXTURE_LOADER_H_
+#define EGL_SRC_GLES2_TEXTURE_LOADER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "base/block_pool.h"
+#include "gles2/texture.h"
+
+struct Etc1LoadOptions {
+  // upload the mapped blocks as they are when the GPU takes ETC1
+  bool allow_compressed = true;
+  // CPU decode threads otherwise; 0 means one per core
+  int decode_threads = 0;
+  // recycles the decode buffer across loads when set
+  BlockPool *pixel_pool = nullptr;
+};
+
+struct Etc1LoadInfo {
+  bool compressed = false;
+  int width = 0;
+  int height = 0;
+  int levels = 0;
+  size_t file_bytes = 0;
+  // texture memory of all levels, and what the same levels take as RGBA
+  size_t gpu_bytes = 0;
+  size_t rgba_bytes = 0;
+  int64_t load_ns = 0;
+};
+
+// GL_OES_compressed_ETC1_RGB8_texture; needs a current context
+bool hasEtc1Support();
+
+// loads a .ktx (ETC1) or .pkm file into |texture| straight from the mapped
+// file; falls back to decoding to RGBA. |info| may be null.
+bool loadEtc1Texture(const std::string &path, GlES2Texture *texture,
+                     Etc1LoadInfo *info = nullptr,
+                     const Etc1LoadOptions &options = {});
+
+#endif // EGL_SRC_GLES2_TEXTURE_LOADER_H_
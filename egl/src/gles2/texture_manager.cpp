@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <utility>
+
+#include "base/clock.h"
+#include "base/logging.h"
+#include "base/trace.h"
+#include "gles2/texture_manager.h"
+
+bool GlES2TextureManager::initialize(const Config &config) {
+  if (config.budget_bytes == 0) {
+    LOG_E << "texture budget must not be 0";
+    return false;
+  }
+  config_ = config;
+  entries_.clear();
+  use_clock_ = 0;
+  frame_start_ = 0;
+  frame_ = 0;
+  stats_ = Stats();
+  return true;
+}
+
+GlES2TextureManager::Handle
+GlES2TextureManager::add(Loader loader, bool mipmaps, size_t size_hint) {
+  Entry entry;
+  entry.loader = std::move(loader);
+  entry.mipmaps = mipmaps;
+  entry.bytes = size_hint;
+  entries_.push_back(std::move(entry));
+  return entries_.size() - 1;
+}
+
+void GlES2TextureManager::beginFrame() {
+  frame_start_ = ++use_clock_;
+  ++frame_;
+  frame_over_budget_ = false;
+}
+
+GLuint GlES2TextureManager::use(Handle handle) {
+  if (handle >= entries_.size())
+    return 0;
+  Entry &entry = entries_[handle];
+  entry.last_use = ++use_clock_;
+  if (entry.texture) {
+    ++stats_.hits;
+    return entry.texture->texture();
+  }
+  if (frame_ < entry.retry_frame) {
+    ++stats_.retries_deferred;
+    return 0;
+  }
+
+  TRACE_SCOPE("GlES2TextureManager::load");
+  ++stats_.misses;
+  // the size of an earlier load, or the hint, is a good guess for this one
+  makeRoom(entry.bytes);
+  const int64_t begin = monotonicNowNs();
+  entry.texture = GlES2Texture::create();
+  bool ok = entry.loader(&*entry.texture);
+  if (ok && entry.mipmaps)
+    ok = entry.texture->generateMipmap();
+  stats_.load_ns += monotonicNowNs() - begin;
+  if (!ok) {
+    ++stats_.load_failures;
+    entry.texture.reset();
+    // 1, 2, 4... frames
+    const uint64_t backoff = uint64_t{1} << std::min(entry.failures, 31u);
+    entry.retry_frame = frame_ + std::min(backoff, kMaxRetryFrames);
+    ++entry.failures;
+    return 0;
+  }
+  entry.failures = 0;
+  entry.retry_frame = 0;
+  entry.bytes = entry.texture->memoryBytes();
+  VLOG(1) << "texture " << handle << " loaded, " << entry.bytes << " bytes";
+  ++stats_.resident;
+  stats_.resident_bytes += entry.bytes;
+  stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.resident_bytes);
+  if (stats_.resident_bytes > config_.budget_bytes)
+    stats_.max_overshoot_bytes =
+        std::max(stats_.max_overshoot_bytes,
+                 stats_.resident_bytes - config_.budget_bytes);
+  makeRoom(0);
+  return entry.texture->texture();
+}
+
+void GlES2TextureManager::makeRoom(size_t incoming) {
+  while (stats_.resident_bytes + incoming > config_.budget_bytes) {
+    Entry *lru = nullptr;
+    for (Entry &e : entries_) {
+      if (e.texture && e.last_use < frame_start_ &&
+          (!lru || e.last_use < lru->last_use))
+        lru = &e;
+    }
+    if (!lru) {
+      // everything resident is drawn this frame
+      if (!frame_over_budget_)
+        ++stats_.over_budget_frames;
+      frame_over_budget_ = true;
+      return;
+    }
+    evict(lru);
+  }
+}
+
+void GlES2TextureManager::evict(Entry *entry) {
+  VLOG(1) << "texture " << entry - entries_.data() << " evicted";
+  stats_.resident_bytes -= entry->bytes;
+  --stats_.resident;
+  ++stats_.evictions;
+  entry->texture.reset();
+}
@@ -0,0 +1,102 @@
+#ifndef EGL_SRC_GLES2_TEXTURE_MANAGER_H_
+#define EGL_SRC_GLES2_TEXTURE_MANAGER_H_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "gles2/texture.h"
+
+// Keeps registered textures within a video memory budget. A texture is
+// loaded by its loader on the first use() and, once resident textures
+// exceed the budget, the least recently used ones are deleted; the next
+// use() loads them again.
+//
+// Textures used since beginFrame() are never evicted, since pending draws
+// still reference their names; such a frame may go over budget.
+//
+// A loader that fails is not called again for a number of frames that
+// doubles with each consecutive failure, up to kMaxRetryFrames.
+class GlES2TextureManager {
+public:
+  struct Config {
+    size_t budget_bytes = 64 << 20;
+  };
+
+  using Handle = uint32_t;
+  static constexpr Handle kInvalid = UINT32_MAX;
+  static constexpr uint64_t kMaxRetryFrames = 256;
+  // fills a freshly created |texture|; false leaves it unloaded
+  using Loader = std::function<bool(GlES2Texture *texture)>;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0; // loads, first ones included
+    uint64_t evictions = 0;
+    uint64_t load_failures = 0;
+    // use() calls answered 0 without trying, after a failure
+    uint64_t retries_deferred = 0;
+    uint64_t over_budget_frames = 0;
+    // most bytes a load went over the budget before the evictions that
+    // follow it; loads without a size hint make room only afterwards
+    size_t max_overshoot_bytes = 0;
+    int64_t load_ns = 0;
+    int resident = 0;
+    size_t resident_bytes = 0;
+    size_t peak_bytes = 0;
+    double hitRate() const {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+    }
+  };
+
+  bool initialize(const Config &config);
+
+  // nothing is uploaded until the first use(). |mipmaps| runs
+  // glGenerateMipmap after every load. |size_hint|, the expected bytes,
+  // lets the first load evict before it uploads, as later ones do.
+  Handle add(Loader loader, bool mipmaps = false, size_t size_hint = 0);
+  // call at the start of every frame; nothing is evicted before the first
+  void beginFrame();
+  // the name to draw |handle| with, loading it on a miss; 0 when the load
+  // fails. Call it where the texture is drawn: it is what keeps the
+  // texture resident.
+  GLuint use(Handle handle);
+  bool resident(Handle handle) const {
+    return handle < entries_.size() && entries_[handle].texture;
+  }
+  // estimated bytes of the last load (mip chain included); the size hint
+  // before it
+  size_t bytes(Handle handle) const { return entries_[handle].bytes; }
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  struct Entry {
+    Loader loader;
+    bool mipmaps = false;
+    std::optional<GlES2Texture> texture;
+    size_t bytes = 0;
+    uint64_t last_use = 0;
+    // consecutive failed loads, and the frame to try again in
+    uint32_t failures = 0;
+    uint64_t retry_frame = 0;
+  };
+
+  // evicts until |incoming| more bytes fit, sparing this frame's textures
+  void makeRoom(size_t incoming);
+  void evict(Entry *entry);
+
+  Config config_;
+  std::vector<Entry> entries_;
+  uint64_t use_clock_ = 0;
+  // use_clock_ at beginFrame()
+  uint64_t frame_start_ = 0;
+  uint64_t frame_ = 0;
+  bool frame_over_budget_ = false;
+  Stats stats_;
+};
+
+#endif // EGL_SRC_GLES2_TEXTURE_MANAGER_H_
@@ -1,4 +1,6 @@
 
+#include <cstring>
+
 #include <GLES2/gl2.h>
 
 #include "base/logging.h"
@@ -30,4 +32,17 @@ bool checkGLES2Error() {
     break;
   }
   return false;
-}
\ No newline at end of file
+}
+
+bool hasGLES2Extension(const char *name) {
+  const char *exts =
+      reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+  if (!exts)
+    return false;
+  const size_t len = strlen(name);
+  for (const char *p = exts; (p = strstr(p, name)) != nullptr; p += len) {
+    if ((p == exts || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+      return true;
+  }
+  return false;
+}
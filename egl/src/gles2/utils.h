@@ -4,5 +4,7 @@
 #include <cassert>
 
 bool checkGLES2Error();
+// needs a current context
+bool hasGLES2Extension(const char *name);
 
 #endif // EGL_SRC_GLES2_UTILS_H_
\ No newline at end of file
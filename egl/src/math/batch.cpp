@@ -0,0 +1,242 @@
+#include "math/batch.h"
+#include "math/simd.h"
+
+namespace Math {
+
+namespace Scalar {
+
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const float *o = b[i].m;
+    float *r = out[i].m;
+    for (int col = 0; col < 4; ++col) {
+      for (int row = 0; row < 4; ++row) {
+        r[col * 4 + row] =
+            a.m[row] * o[col * 4] + a.m[4 + row] * o[col * 4 + 1] +
+            a.m[8 + row] * o[col * 4 + 2] + a.m[12 + row] * o[col * 4 + 3];
+      }
+    }
+  }
+}
+
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = m * v[i];
+}
+
+void fromRotationTranslation(const Quat *q, const Vec3 *t, Mat4 *out,
+                             size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = Mat4::fromRotationTranslation(q[i], t[i]);
+}
+
+void affineRows(const float *q, const float *t, float *out, size_t n) {
+  for (size_t i = 0; i < n; ++i, q += 4, t += 3, out += 12) {
+    const float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+    const float xx = q[0] * x2, xy = q[0] * y2, xz = q[0] * z2;
+    const float yy = q[1] * y2, yz = q[1] * z2, zz = q[2] * z2;
+    const float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+    out[0] = 1 - (yy + zz);
+    out[1] = xy - wz;
+    out[2] = xz + wy;
+    out[3] = t[0];
+    out[4] = xy + wz;
+    out[5] = 1 - (xx + zz);
+    out[6] = yz - wx;
+    out[7] = t[1];
+    out[8] = xz - wy;
+    out[9] = yz + wx;
+    out[10] = 1 - (xx + yy);
+    out[11] = t[2];
+  }
+}
+
+} // namespace Scalar
+
+#if defined(MATH_SCALAR)
+
+const char *simdPath() { return "scalar"; }
+
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n) {
+  Scalar::multiply(a, b, out, n);
+}
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n) {
+  Scalar::transform(m, v, out, n);
+}
+void fromRotationTranslation(const Quat *q, const Vec3 *t, Mat4 *out,
+                             size_t n) {
+  Scalar::fromRotationTranslation(q, t, out, n);
+}
+void affineRows(const float *q, const float *t, float *out, size_t n) {
+  Scalar::affineRows(q, t, out, n);
+}
+
+#else
+
+namespace {
+
+using namespace Simd;
+
+// the rotation matrices of four quaternions given lane-wise, r[col * 3 + row]
+void rotation4(F4 x, F4 y, F4 z, F4 w, F4 r[9]) {
+  const F4 one = splat(1);
+  const F4 x2 = add(x, x), y2 = add(y, y), z2 = add(z, z);
+  const F4 xx = mul(x, x2), xy = mul(x, y2), xz = mul(x, z2);
+  const F4 yy = mul(y, y2), yz = mul(y, z2), zz = mul(z, z2);
+  const F4 wx = mul(w, x2), wy = mul(w, y2), wz = mul(w, z2);
+  r[0] = sub(one, add(yy, zz));
+  r[1] = add(xy, wz);
+  r[2] = sub(xz, wy);
+  r[3] = sub(xy, wz);
+  r[4] = sub(one, add(xx, zz));
+  r[5] = add(yz, wx);
+  r[6] = add(xz, wy);
+  r[7] = sub(yz, wx);
+  r[8] = sub(one, add(xx, yy));
+}
+
+// four quaternions from consecutive records of 4 floats, lane-wise
+void loadQuat4(const float *q, F4 *x, F4 *y, F4 *z, F4 *w) {
+  *x = load(q);
+  *y = load(q + 4);
+  *z = load(q + 8);
+  *w = load(q + 12);
+  transpose(*x, *y, *z, *w);
+}
+
+// lane k of a, b, c, d to out + k * stride
+void storeTransposed(F4 a, F4 b, F4 c, F4 d, float *out, size_t stride) {
+  transpose(a, b, c, d);
+  store(out, a);
+  store(out + stride, b);
+  store(out + 2 * stride, c);
+  store(out + 3 * stride, d);
+}
+
+} // namespace
+
+#if defined(MATH_AVX2)
+const char *simdPath() { return "avx2"; }
+
+// two columns (or two vectors) per 256-bit register: the columns of |a| are
+// broadcast to both halves, the factors picked per half by shuffles
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n) {
+  const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m));
+  const __m256 a1 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 4));
+  const __m256 a2 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 8));
+  const __m256 a3 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 12));
+  for (size_t i = 0; i < n; ++i) {
+    for (int half = 0; half < 16; half += 8) {
+      const __m256 o = _mm256_loadu_ps(b[i].m + half);
+      __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(o, o, 0x00));
+      r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(o, o, 0x55), r);
+      r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(o, o, 0xaa), r);
+      r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(o, o, 0xff), r);
+      _mm256_storeu_ps(out[i].m + half, r);
+    }
+  }
+}
+
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n) {
+  const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m.m));
+  const __m256 a1 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m.m + 4));
+  const __m256 a2 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m.m + 8));
+  const __m256 a3 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m.m + 12));
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const __m256 o = _mm256_loadu_ps(&v[i].x);
+    __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(o, o, 0x00));
+    r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(o, o, 0x55), r);
+    r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(o, o, 0xaa), r);
+    r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(o, o, 0xff), r);
+    _mm256_storeu_ps(&out[i].x, r);
+  }
+  for (; i < n; ++i)
+    out[i] = m * v[i];
+}
+#else
+const char *simdPath() {
+#if defined(MATH_NEON)
+  return "neon";
+#else
+  return "sse2";
+#endif
+}
+
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n) {
+  const F4 a0 = load(a.m), a1 = load(a.m + 4), a2 = load(a.m + 8),
+           a3 = load(a.m + 12);
+  for (size_t i = 0; i < n; ++i) {
+    const float *o = b[i].m;
+    for (int j = 0; j < 16; j += 4) {
+      F4 r = mul(a0, splat(o[j]));
+      r = add(r, mul(a1, splat(o[j + 1])));
+      r = add(r, mul(a2, splat(o[j + 2])));
+      r = add(r, mul(a3, splat(o[j + 3])));
+      store(out[i].m + j, r);
+    }
+  }
+}
+
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n) {
+  const F4 a0 = load(m.m), a1 = load(m.m + 4), a2 = load(m.m + 8),
+           a3 = load(m.m + 12);
+  for (size_t i = 0; i < n; ++i) {
+    const Vec4 o = v[i];
+    F4 r = mul(a0, splat(o.x));
+    r = add(r, mul(a1, splat(o.y)));
+    r = add(r, mul(a2, splat(o.z)));
+    r = add(r, mul(a3, splat(o.w)));
+    store(&out[i].x, r);
+  }
+}
+#endif
+
+// four quaternions per step on every SIMD path (AVX2 included: the
+// transposes dominate and do not widen well)
+void fromRotationTranslation(const Quat *q, const Vec3 *t, Mat4 *out,
+                             size_t n) {
+  const F4 zero = splat(0), one = splat(1);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    F4 x, y, z, w, r[9];
+    loadQuat4(&q[i].x, &x, &y, &z, &w);
+    rotation4(x, y, z, w, r);
+    F4 tx, ty, tz, unused;
+    loadQuat4(&t[i].x, &tx, &ty, &tz, &unused);
+    float *o = out[i].m;
+    storeTransposed(r[0], r[1], r[2], zero, o, 16);
+    storeTransposed(r[3], r[4], r[5], zero, o + 4, 16);
+    storeTransposed(r[6], r[7], r[8], zero, o + 8, 16);
+    storeTransposed(tx, ty, tz, one, o + 12, 16);
+  }
+  Scalar::fromRotationTranslation(q + i, t + i, out + i, n - i);
+}
+
+void affineRows(const float *q, const float *t, float *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    F4 x, y, z, w, r[9];
+    loadQuat4(q + i * 4, &x, &y, &z, &w);
+    rotation4(x, y, z, w, r);
+    const float *p = t + i * 3;
+    const F4 tx = set(p[0], p[3], p[6], p[9]);
+    const F4 ty = set(p[1], p[4], p[7], p[10]);
+    const F4 tz = set(p[2], p[5], p[8], p[11]);
+    float *o = out + i * 12;
+    storeTransposed(r[0], r[3], r[6], tx, o, 12);
+    storeTransposed(r[1], r[4], r[7], ty, o + 4, 12);
+    storeTransposed(r[2], r[5], r[8], tz, o + 8, 12);
+  }
+  Scalar::affineRows(q + i * 4, t + i * 3, out + i * 12, n - i);
+}
+
+#endif
+
+} // namespace Math
@@ -0,0 +1,39 @@
+#ifndef EGL_SRC_MATH_BATCH_H_
+#define EGL_SRC_MATH_BATCH_H_
+
+#include <cstddef>
+
+#include "math/mat4.h"
+#include "math/quat.h"
+#include "math/vec.h"
+
+// Kernels over arrays, built for the SIMD path picked in math/simd.h.
+// Math::Scalar has the same functions without SIMD, as the reference the
+// benchmarks compare with. Outputs must not alias inputs unless noted.
+namespace Math {
+
+// "avx2", "sse2", "neon" or "scalar"
+const char *simdPath();
+
+// out[i] = a * b[i], e.g. view-projection times model matrices
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n);
+// out[i] = m * v[i]; |out| may be |v|
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n);
+// out[i] = Mat4::fromRotationTranslation(q[i], t[i])
+void fromRotationTranslation(const Quat *q, const Vec3 *t, Mat4 *out,
+                             size_t n);
+// the same from packed floats (4 per rotation, 3 per translation), written
+// as the top three rows of each matrix: 12 floats, row-major
+void affineRows(const float *q, const float *t, float *out, size_t n);
+
+namespace Scalar {
+void multiply(const Mat4 &a, const Mat4 *b, Mat4 *out, size_t n);
+void transform(const Mat4 &m, const Vec4 *v, Vec4 *out, size_t n);
+void fromRotationTranslation(const Quat *q, const Vec3 *t, Mat4 *out,
+                             size_t n);
+void affineRows(const float *q, const float *t, float *out, size_t n);
+} // namespace Scalar
+
+} // namespace Math
+
+#endif // EGL_SRC_MATH_BATCH_H_
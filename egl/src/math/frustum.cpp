@@ -0,0 +1,180 @@
+#include <cmath>
+
+#include "math/frustum.h"
+#include "math/simd.h"
+
+namespace Math {
+
+Frustum Frustum::fromViewProjection(const float m[16]) {
+  // row i of the matrix is (m[i], m[4 + i], m[8 + i], m[12 + i]); a plane is
+  // row 3 plus or minus row 0 (x), 1 (y) or 2 (z)
+  Frustum f;
+  for (int p = 0; p < kPlaneCount; ++p) {
+    const int row = p / 2;
+    const float sign = p % 2 ? -1.0f : 1.0f;
+    float *plane = f.planes[p];
+    for (int c = 0; c < 4; ++c)
+      plane[c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+    const float length = std::sqrt(plane[0] * plane[0] +
+                                   plane[1] * plane[1] + plane[2] * plane[2]);
+    if (length > 0) {
+      for (int c = 0; c < 4; ++c)
+        plane[c] /= length;
+    }
+  }
+  return f;
+}
+
+namespace {
+
+// per lane, the bits of the planes whose |straddle| mask has the lane set
+void lanePlanes(const uint8_t straddle[Frustum::kPlaneCount],
+                uint32_t outside, Box4Test *result) {
+  for (int lane = 0; lane < 4; ++lane) {
+    uint8_t planes = 0;
+    for (int p = 0; p < Frustum::kPlaneCount; ++p) {
+      if (straddle[p] & (1 << lane))
+        planes |= 1 << p;
+    }
+    result->planes[lane] = outside & (1 << lane) ? 0 : planes;
+  }
+  result->outside = outside;
+}
+
+} // namespace
+
+namespace Scalar {
+
+void testBoxes(const Frustum &frustum, const Box4 &boxes, uint32_t plane_mask,
+               int first_plane, Box4Test *result) {
+  uint8_t straddle[Frustum::kPlaneCount] = {};
+  uint32_t outside = 0;
+  for (int i = 0; i < Frustum::kPlaneCount && outside != 0xf; ++i) {
+    const int p = (first_plane + i) % Frustum::kPlaneCount;
+    if (!(plane_mask & (1 << p)))
+      continue;
+    const float *n = frustum.planes[p];
+    for (int lane = 0; lane < 4; ++lane) {
+      if (outside & (1 << lane))
+        continue;
+      float d = n[3], r = 0;
+      for (int axis = 0; axis < 3; ++axis) {
+        d += n[axis] * boxes.center[axis][lane];
+        r += std::fabs(n[axis]) * boxes.extent[axis][lane];
+      }
+      if (d + r < 0) {
+        outside |= 1 << lane;
+        result->culled_by[lane] = p;
+      } else if (d < r) {
+        straddle[p] |= 1 << lane;
+      }
+    }
+  }
+  lanePlanes(straddle, outside, result);
+}
+
+size_t testSpheres(const Frustum &frustum, const float *centers,
+                   const float *radii, size_t n, uint8_t *inside) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const float *c = centers + i * 3;
+    bool in = true;
+    for (int p = 0; p < Frustum::kPlaneCount && in; ++p) {
+      const float *n = frustum.planes[p];
+      in = n[0] * c[0] + n[1] * c[1] + n[2] * c[2] + n[3] >= -radii[i];
+    }
+    inside[i] = in;
+    count += in;
+  }
+  return count;
+}
+
+} // namespace Scalar
+
+#if defined(MATH_SCALAR)
+
+void testBoxes(const Frustum &frustum, const Box4 &boxes, uint32_t plane_mask,
+               int first_plane, Box4Test *result) {
+  Scalar::testBoxes(frustum, boxes, plane_mask, first_plane, result);
+}
+
+size_t testSpheres(const Frustum &frustum, const float *centers,
+                   const float *radii, size_t n, uint8_t *inside) {
+  return Scalar::testSpheres(frustum, centers, radii, n, inside);
+}
+
+#else
+
+using namespace Simd;
+
+// the four lanes at once: d = n . center + w, r = |n| . extent per plane
+void testBoxes(const Frustum &frustum, const Box4 &boxes, uint32_t plane_mask,
+               int first_plane, Box4Test *result) {
+  const F4 cx = load(boxes.center[0]), cy = load(boxes.center[1]),
+           cz = load(boxes.center[2]);
+  const F4 ex = load(boxes.extent[0]), ey = load(boxes.extent[1]),
+           ez = load(boxes.extent[2]);
+  const F4 zero = splat(0);
+  uint8_t straddle[Frustum::kPlaneCount] = {};
+  uint32_t outside = 0;
+  for (int i = 0; i < Frustum::kPlaneCount && outside != 0xf; ++i) {
+    const int p = (first_plane + i) % Frustum::kPlaneCount;
+    if (!(plane_mask & (1 << p)))
+      continue;
+    const float *n = frustum.planes[p];
+    const F4 nx = splat(n[0]), ny = splat(n[1]), nz = splat(n[2]);
+    const F4 d = add(add(mul(cx, nx), mul(cy, ny)),
+                     add(mul(cz, nz), splat(n[3])));
+    const F4 r = add(add(mul(ex, abs(nx)), mul(ey, abs(ny))),
+                     mul(ez, abs(nz)));
+    const uint32_t rejected = lessMask(add(d, r), zero) & ~outside;
+    for (uint32_t bits = rejected; bits; bits &= bits - 1)
+      result->culled_by[__builtin_ctz(bits)] = p;
+    outside |= rejected;
+    straddle[p] = lessMask(d, r) & ~outside;
+  }
+  lanePlanes(straddle, outside, result);
+}
+
+// four spheres at once, every plane without early outs: the branch would
+// cost more than the two planes it saves on average
+size_t testSpheres(const Frustum &frustum, const float *centers,
+                   const float *radii, size_t n, uint8_t *inside) {
+  F4 nx[Frustum::kPlaneCount], ny[Frustum::kPlaneCount],
+      nz[Frustum::kPlaneCount], nw[Frustum::kPlaneCount];
+  for (int p = 0; p < Frustum::kPlaneCount; ++p) {
+    nx[p] = splat(frustum.planes[p][0]);
+    ny[p] = splat(frustum.planes[p][1]);
+    nz[p] = splat(frustum.planes[p][2]);
+    nw[p] = splat(frustum.planes[p][3]);
+  }
+  const F4 zero = splat(0);
+  size_t count = 0;
+  size_t i = 0;
+  // the last load of a group reads one float past its spheres, so the
+  // final group is left to the scalar loop
+  for (; i + 5 <= n; i += 4) {
+    const float *c = centers + i * 3;
+    F4 x = load(c), y = load(c + 3), z = load(c + 6), w = load(c + 9);
+    transpose(x, y, z, w);
+    const F4 negative_r = sub(zero, load(radii + i));
+    int outside = 0;
+    for (int p = 0; p < Frustum::kPlaneCount; ++p) {
+      // summed in the scalar order, so both agree on the boundary
+      const F4 d = add(add(add(mul(x, nx[p]), mul(y, ny[p])), mul(z, nz[p])),
+                       nw[p]);
+      outside |= lessMask(d, negative_r);
+    }
+    for (int lane = 0; lane < 4; ++lane) {
+      const bool in = !(outside & (1 << lane));
+      inside[i + lane] = in;
+      count += in;
+    }
+  }
+  return count + Scalar::testSpheres(frustum, centers + i * 3, radii + i,
+                                     n - i, inside + i);
+}
+
+#endif
+
+} // namespace Math
@@ -0,0 +1,61 @@
+#ifndef EGL_SRC_MATH_FRUSTUM_H_
+#define EGL_SRC_MATH_FRUSTUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Math {
+
+// The six clip planes of a view-projection matrix (Gribb and Hartmann),
+// each (nx, ny, nz, d) with a unit normal pointing inwards: a point p is
+// inside a plane when n . p + d >= 0.
+struct Frustum {
+  enum Plane { kLeft, kRight, kBottom, kTop, kNear, kFar, kPlaneCount };
+  static constexpr uint32_t kAllPlanes = (1u << kPlaneCount) - 1;
+
+  // |m| column-major, as Mat4
+  static Frustum fromViewProjection(const float m[16]);
+
+  float planes[kPlaneCount][4];
+};
+
+// four axis-aligned boxes lane-wise, as a 4-wide BVH node stores its
+// children. A lane with a negative extent is empty and always outside.
+struct alignas(16) Box4 {
+  float center[3][4];
+  float extent[3][4]; // half size
+};
+
+struct Box4Test {
+  uint32_t outside = 0; // bit per lane: entirely behind some plane
+  // per lane, the planes the box straddles, to test its contents against;
+  // 0 when it is entirely inside
+  uint8_t planes[4] = {};
+  // per outside lane, the plane that rejected it
+  uint8_t culled_by[4] = {};
+};
+
+// tests |boxes| against the planes of |frustum| in |plane_mask|, starting
+// at |first_plane| and wrapping around: a box rejected by some plane last
+// frame is likely to be rejected by it again, so passing that plane first
+// rejects after one test (plane coherency). Stops once all four lanes are
+// outside.
+void testBoxes(const Frustum &frustum, const Box4 &boxes, uint32_t plane_mask,
+               int first_plane, Box4Test *result);
+
+// inside[i] = 1 when the sphere at centers[3 * i] (x, y, z) of radius
+// radii[i] is not entirely behind some plane of |frustum|, 0 otherwise;
+// returns how many are inside
+size_t testSpheres(const Frustum &frustum, const float *centers,
+                   const float *radii, size_t n, uint8_t *inside);
+
+namespace Scalar {
+void testBoxes(const Frustum &frustum, const Box4 &boxes, uint32_t plane_mask,
+               int first_plane, Box4Test *result);
+size_t testSpheres(const Frustum &frustum, const float *centers,
+                   const float *radii, size_t n, uint8_t *inside);
+} // namespace Scalar
+
+} // namespace Math
+
+#endif // EGL_SRC_MATH_FRUSTUM_H_
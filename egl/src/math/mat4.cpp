@@ -0,0 +1,102 @@
+#include <cmath>
+
+#include "math/mat4.h"
+#include "math/simd.h"
+
+namespace Math {
+
+Mat4 Mat4::identity() {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+}
+
+Mat4 Mat4::translation(const Vec3 &t) {
+  Mat4 r = identity();
+  r.m[12] = t.x;
+  r.m[13] = t.y;
+  r.m[14] = t.z;
+  return r;
+}
+
+Mat4 Mat4::scale(const Vec3 &s) {
+  return {{s.x, 0, 0, 0, 0, s.y, 0, 0, 0, 0, s.z, 0, 0, 0, 0, 1}};
+}
+
+Mat4 Mat4::rotationX(float radians) {
+  const float c = std::cos(radians), s = std::sin(radians);
+  return {{1, 0, 0, 0, 0, c, s, 0, 0, -s, c, 0, 0, 0, 0, 1}};
+}
+
+Mat4 Mat4::rotationY(float radians) {
+  const float c = std::cos(radians), s = std::sin(radians);
+  return {{c, 0, -s, 0, 0, 1, 0, 0, s, 0, c, 0, 0, 0, 0, 1}};
+}
+
+Mat4 Mat4::rotationZ(float radians) {
+  const float c = std::cos(radians), s = std::sin(radians);
+  return {{c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+}
+
+Mat4 Mat4::fromRotationTranslation(const Quat &q, const Vec3 &t) {
+  const float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+  const float xx = q.x * x2, xy = q.x * y2, xz = q.x * z2;
+  const float yy = q.y * y2, yz = q.y * z2, zz = q.z * z2;
+  const float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+  return {{1 - (yy + zz), xy + wz, xz - wy, 0,
+           xy - wz, 1 - (xx + zz), yz + wx, 0,
+           xz + wy, yz - wx, 1 - (xx + yy), 0,
+           t.x, t.y, t.z, 1}};
+}
+
+Mat4 Mat4::perspective(float fovy, float aspect, float near, float far) {
+  const float f = 1.0f / std::tan(fovy / 2);
+  const float nf = 1.0f / (near - far);
+  return {{f / aspect, 0, 0, 0,
+           0, f, 0, 0,
+           0, 0, (far + near) * nf, -1,
+           0, 0, 2 * far * near * nf, 0}};
+}
+
+Mat4 Mat4::lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up) {
+  const Vec3 z = (eye - center).normalized();
+  const Vec3 x = up.cross(z).normalized();
+  const Vec3 y = z.cross(x);
+  return {{x.x, y.x, z.x, 0,
+           x.y, y.y, z.y, 0,
+           x.z, y.z, z.z, 0,
+           -x.dot(eye), -y.dot(eye), -z.dot(eye), 1}};
+}
+
+Mat4 Mat4::operator*(const Mat4 &o) const {
+  Mat4 r;
+#if defined(MATH_SCALAR)
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      r.m[col * 4 + row] = m[row] * o.m[col * 4] +
+                           m[4 + row] * o.m[col * 4 + 1] +
+                           m[8 + row] * o.m[col * 4 + 2] +
+                           m[12 + row] * o.m[col * 4 + 3];
+    }
+  }
+#else
+  Simd::multiply4x4(m, o.m, r.m);
+#endif
+  return r;
+}
+
+Vec4 Mat4::operator*(const Vec4 &v) const {
+  return {m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+          m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+          m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+          m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w};
+}
+
+Mat4 Mat4::transposed() const {
+  Mat4 r;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j)
+      r.m[i * 4 + j] = m[j * 4 + i];
+  }
+  return r;
+}
+
+} // namespace Math
@@ -0,0 +1,37 @@
+#ifndef EGL_SRC_MATH_MAT4_H_
+#define EGL_SRC_MATH_MAT4_H_
+
+#include "math/quat.h"
+#include "math/vec.h"
+
+namespace Math {
+
+// column-major, as glUniformMatrix4fv(transpose = GL_FALSE) takes it:
+// m[column * 4 + row]
+struct alignas(16) Mat4 {
+  float m[16];
+
+  static Mat4 identity();
+  static Mat4 translation(const Vec3 &t);
+  static Mat4 scale(const Vec3 &s);
+  static Mat4 rotationX(float radians);
+  static Mat4 rotationY(float radians);
+  static Mat4 rotationZ(float radians);
+  // mat4.fromRotationTranslation
+  static Mat4 fromRotationTranslation(const Quat &q, const Vec3 &t);
+  static Mat4 perspective(float fovy, float aspect, float near, float far);
+  static Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up);
+
+  Mat4 operator*(const Mat4 &o) const;
+  Vec4 operator*(const Vec4 &v) const;
+  Mat4 transposed() const;
+
+  float operator()(int row, int column) const { return m[column * 4 + row]; }
+  const float *data() const { return m; }
+};
+
+static_assert(sizeof(Mat4) == 64, "Mat4 layout");
+
+} // namespace Math
+
+#endif // EGL_SRC_MATH_MAT4_H_
@@ -0,0 +1,41 @@
+#include <cmath>
+
+#include "math/quat.h"
+
+namespace Math {
+
+Quat Quat::fromEuler(float x, float y, float z) {
+  const float half = kPi / 360;
+  const float sx = std::sin(x * half), cx = std::cos(x * half);
+  const float sy = std::sin(y * half), cy = std::cos(y * half);
+  const float sz = std::sin(z * half), cz = std::cos(z * half);
+  return {sx * cy * cz - cx * sy * sz, cx * sy * cz + sx * cy * sz,
+          cx * cy * sz - sx * sy * cz, cx * cy * cz + sx * sy * sz};
+}
+
+Quat Quat::fromAxisAngle(const Vec3 &axis, float radians) {
+  const Vec3 a = axis.normalized();
+  const float s = std::sin(radians / 2);
+  return {a.x * s, a.y * s, a.z * s, std::cos(radians / 2)};
+}
+
+Quat Quat::operator*(const Quat &o) const {
+  return {w * o.x + x * o.w + y * o.z - z * o.y,
+          w * o.y - x * o.z + y * o.w + z * o.x,
+          w * o.z + x * o.y - y * o.x + z * o.w,
+          w * o.w - x * o.x - y * o.y - z * o.z};
+}
+
+Quat Quat::normalized() const {
+  const float l = std::sqrt(x * x + y * y + z * z + w * w);
+  return l > 0 ? Quat(x / l, y / l, z / l, w / l) : Quat();
+}
+
+Vec3 Quat::rotate(const Vec3 &v) const {
+  // v + 2w(u x v) + 2u x (u x v)
+  const Vec3 u(x, y, z);
+  const Vec3 t = u.cross(v) * 2;
+  return v + t * w + u.cross(t);
+}
+
+} // namespace Math
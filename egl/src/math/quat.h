@@ -0,0 +1,32 @@
+#ifndef EGL_SRC_MATH_QUAT_H_
+#define EGL_SRC_MATH_QUAT_H_
+
+#include "math/vec.h"
+
+namespace Math {
+
+// unit quaternion (x, y, z, w); the layout of gl-matrix's quat
+struct alignas(16) Quat {
+  float x = 0, y = 0, z = 0, w = 1;
+
+  Quat() = default;
+  constexpr Quat(float x, float y, float z, float w)
+      : x(x), y(y), z(z), w(w) {}
+
+  // rotation about x, then y, then z, in degrees (quat.fromEuler)
+  static Quat fromEuler(float x, float y, float z);
+  static Quat fromAxisAngle(const Vec3 &axis, float radians);
+
+  // the rotation |o| followed by this one
+  Quat operator*(const Quat &o) const;
+  Quat normalized() const;
+  Vec3 rotate(const Vec3 &v) const;
+
+  const float *data() const { return &x; }
+};
+
+static_assert(sizeof(Quat) == 16, "Quat layout");
+
+} // namespace Math
+
+#endif // EGL_SRC_MATH_QUAT_H_
@@ -0,0 +1,100 @@
+#ifndef EGL_SRC_MATH_SIMD_H_
+#define EGL_SRC_MATH_SIMD_H_
+
+// Picks the kernel set at build time from what the compiler targets
+// (-DMATH_SIMD=avx2|scalar in CMake changes that). Only the math
+// translation units include this.
+
+#if defined(MATH_FORCE_SCALAR)
+#define MATH_SCALAR 1
+#elif defined(__AVX2__) && defined(__FMA__)
+#define MATH_AVX2 1
+#define MATH_SSE2 1
+#elif defined(__SSE2__)
+#define MATH_SSE2 1
+#elif defined(__ARM_NEON)
+#define MATH_NEON 1
+#else
+#define MATH_SCALAR 1
+#endif
+
+#if defined(MATH_AVX2)
+#include <immintrin.h>
+#elif defined(MATH_SSE2)
+#include <emmintrin.h>
+#elif defined(MATH_NEON)
+#include <arm_neon.h>
+#endif
+
+#if !defined(MATH_SCALAR)
+namespace Math {
+namespace Simd {
+
+// four floats, so that the SSE2 and NEON kernels share one source
+#if defined(MATH_SSE2)
+using F4 = __m128;
+inline F4 load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, F4 v) { _mm_storeu_ps(p, v); }
+inline F4 splat(float f) { return _mm_set1_ps(f); }
+inline F4 set(float a, float b, float c, float d) {
+  return _mm_setr_ps(a, b, c, d);
+}
+inline F4 add(F4 a, F4 b) { return _mm_add_ps(a, b); }
+inline F4 sub(F4 a, F4 b) { return _mm_sub_ps(a, b); }
+inline F4 mul(F4 a, F4 b) { return _mm_mul_ps(a, b); }
+inline F4 abs(F4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+// bit i set where a[i] < b[i]
+inline int lessMask(F4 a, F4 b) {
+  return _mm_movemask_ps(_mm_cmplt_ps(a, b));
+}
+inline void transpose(F4 &a, F4 &b, F4 &c, F4 &d) {
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+#else
+using F4 = float32x4_t;
+inline F4 load(const float *p) { return vld1q_f32(p); }
+inline void store(float *p, F4 v) { vst1q_f32(p, v); }
+inline F4 splat(float f) { return vdupq_n_f32(f); }
+inline F4 set(float a, float b, float c, float d) {
+  const float v[] = {a, b, c, d};
+  return vld1q_f32(v);
+}
+inline F4 add(F4 a, F4 b) { return vaddq_f32(a, b); }
+inline F4 sub(F4 a, F4 b) { return vsubq_f32(a, b); }
+inline F4 mul(F4 a, F4 b) { return vmulq_f32(a, b); }
+inline F4 abs(F4 a) { return vabsq_f32(a); }
+// bit i set where a[i] < b[i]
+inline int lessMask(F4 a, F4 b) {
+  const uint32x4_t bits = {1, 2, 4, 8};
+  const uint32x4_t set = vandq_u32(vcltq_f32(a, b), bits);
+  const uint32x2_t half = vadd_u32(vget_low_u32(set), vget_high_u32(set));
+  return vget_lane_u32(vpadd_u32(half, half), 0);
+}
+inline void transpose(F4 &a, F4 &b, F4 &c, F4 &d) {
+  const float32x4x2_t ab = vtrnq_f32(a, b);
+  const float32x4x2_t cd = vtrnq_f32(c, d);
+  a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+  b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+  c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+  d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#endif
+
+// a * b for column-major 4x4 |a| and |b|, writing to |out|
+inline void multiply4x4(const float *a, const float *b, float *out) {
+  const F4 a0 = load(a), a1 = load(a + 4), a2 = load(a + 8),
+           a3 = load(a + 12);
+  for (int j = 0; j < 16; j += 4) {
+    F4 r = mul(a0, splat(b[j]));
+    r = add(r, mul(a1, splat(b[j + 1])));
+    r = add(r, mul(a2, splat(b[j + 2])));
+    r = add(r, mul(a3, splat(b[j + 3])));
+    store(out + j, r);
+  }
+}
+
+} // namespace Simd
+} // namespace Math
+#endif
+
+#endif // EGL_SRC_MATH_SIMD_H_
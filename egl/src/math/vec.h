@@ -0,0 +1,48 @@
+#ifndef EGL_SRC_MATH_VEC_H_
+#define EGL_SRC_MATH_VEC_H_
+
+#include <cmath>
+
+namespace Math {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+constexpr float radians(float degrees) { return degrees * (kPi / 180.0f); }
+
+// padded to 16 bytes so that arrays of them load as whole registers
+struct alignas(16) Vec3 {
+  float x = 0, y = 0, z = 0;
+  float unused = 0;
+
+  Vec3() = default;
+  constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+  Vec3 operator+(const Vec3 &o) const { return {x + o.x, y + o.y, z + o.z}; }
+  Vec3 operator-(const Vec3 &o) const { return {x - o.x, y - o.y, z - o.z}; }
+  Vec3 operator*(float s) const { return {x * s, y * s, z * s}; }
+  float dot(const Vec3 &o) const { return x * o.x + y * o.y + z * o.z; }
+  Vec3 cross(const Vec3 &o) const {
+    return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+  }
+  float length() const { return std::sqrt(dot(*this)); }
+  // the zero vector stays zero
+  Vec3 normalized() const {
+    const float l = length();
+    return l > 0 ? *this * (1 / l) : *this;
+  }
+};
+
+struct alignas(16) Vec4 {
+  float x = 0, y = 0, z = 0, w = 0;
+
+  Vec4() = default;
+  constexpr Vec4(float x, float y, float z, float w)
+      : x(x), y(y), z(z), w(w) {}
+  constexpr Vec4(const Vec3 &v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+};
+
+static_assert(sizeof(Vec3) == 16 && sizeof(Vec4) == 16, "vector padding");
+
+} // namespace Math
+
+#endif // EGL_SRC_MATH_VEC_H_
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "base/clock.h"
+#include "base/trace.h"
+#include "scene/entity_bvh.h"
+
+namespace {
+
+// the extent of an empty lane: outside of any plane
+constexpr float kEmptyExtent = -1e30f;
+
+double surfaceArea(const float extent[3]) {
+  return 8.0 * (extent[0] * extent[1] + extent[1] * extent[2] +
+                extent[2] * extent[0]);
+}
+
+} // namespace
+
+EntityBvh::~EntityBvh() { setThreads(1); }
+
+void EntityBvh::setThreads(int threads) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::thread &worker : workers_)
+    worker.join();
+  workers_.clear();
+  stopping_ = false;
+  threads = std::max(1, threads);
+  counters_.resize(threads);
+  parallel_ns_ = 0;
+  for (int i = 1; i < threads; ++i)
+    workers_.emplace_back(&EntityBvh::work, this, i, generation_);
+}
+
+void EntityBvh::update(EntityList *entities, const ShapeList &shapes) {
+  TRACE_SCOPE("EntityBvh::update");
+  radii_.resize(shapes.size());
+  for (int shape = 0; shape < shapes.size(); ++shape)
+    radii_[shape] = shapes.radius(shape);
+
+  const size_t n = entities->size();
+  const float *positions = entities->positions();
+  const uint16_t *shapes_of = entities->shapes();
+  entities->takeMoved(&moved_);
+  if (n != leaves_.size()) {
+    linear_ = false;
+    rebuild(*entities);
+    return;
+  }
+  // with this many moves the refit costs more than testing every sphere;
+  // back to the tree, built again, once they drop well under that
+  if (moved_.size() > linear_fraction_ * n) {
+    linear_ = true;
+    ++stats_.linear_updates;
+    return;
+  }
+  if (linear_) {
+    if (moved_.size() > linear_fraction_ / 2 * n) {
+      ++stats_.linear_updates;
+      return;
+    }
+    linear_ = false;
+    rebuild(*entities);
+    return;
+  }
+
+  // the leaves of the entities that moved, then their ancestors whose
+  // boxes change, each node once and after all of its children: one list
+  // per depth, deepest first
+  auto push = [this](int32_t node) {
+    if (dirty_[node])
+      return;
+    dirty_[node] = 1;
+    refit_[nodes_[node].depth].push_back(node);
+  };
+  for (const EntityList::Handle h : moved_) {
+    const uint32_t slot = entities->slot(h);
+    const float *p = positions + slot * 3;
+    const float r = radii_[shapes_of[slot]];
+    float *sphere = &spheres_[h * 4];
+    if (sphere[0] == p[0] && sphere[1] == p[1] && sphere[2] == p[2] &&
+        sphere[3] == r)
+      continue;
+    std::copy_n(p, 3, sphere);
+    sphere[3] = r;
+    const float extent[3] = {r, r, r};
+    const int32_t node = leaves_[h] / 4;
+    setLane(&nodes_[node], leaves_[h] % 4, ~static_cast<int32_t>(h), p,
+            extent);
+    push(node);
+    ++stats_.refits;
+  }
+  for (size_t depth = refit_.size(); depth-- > 0;) {
+    for (const int32_t index : refit_[depth]) {
+      dirty_[index] = 0;
+      if (index == 0)
+        continue;
+      const Node &node = nodes_[index];
+      float center[3], extent[3];
+      bounds(node, center, extent);
+      Node &parent = nodes_[node.parent];
+      bool same = true;
+      for (int axis = 0; axis < 3; ++axis) {
+        same = same && parent.boxes.center[axis][node.lane] == center[axis] &&
+               parent.boxes.extent[axis][node.lane] == extent[axis];
+      }
+      if (!same) {
+        setLane(&parent, node.lane, index, center, extent);
+        push(node.parent);
+      }
+    }
+    refit_[depth].clear();
+  }
+  stats_.area_ratio = build_area_ > 0 ? area_ / build_area_ : 1;
+  if (stats_.area_ratio > rebuild_ratio_)
+    build(*entities);
+}
+
+void EntityBvh::rebuild(const EntityList &entities) {
+  const size_t n = entities.size();
+  spheres_.resize(n * 4);
+  for (uint32_t slot = 0; slot < n; ++slot) {
+    float *sphere = &spheres_[entities.handle(slot) * 4];
+    std::copy_n(entities.positions() + slot * 3, 3, sphere);
+    sphere[3] = radii_[entities.shapes()[slot]];
+  }
+  build(entities);
+}
+
+void EntityBvh::build(const EntityList &entities) {
+  TRACE_SCOPE("EntityBvh::build");
+  const size_t n = entities.size();
+  nodes_.clear();
+  leaves_.assign(n, 0);
+  area_ = 0;
+  if (n > 0) {
+    scratch_.resize(n);
+    std::iota(scratch_.begin(), scratch_.end(), 0);
+    buildNode(scratch_.data(), n, -1, 0);
+  }
+  dirty_.assign(nodes_.size(), 0);
+  build_area_ = area_;
+  ++stats_.builds;
+  stats_.nodes = nodes_.size();
+  stats_.area_ratio = 1;
+}
+
+int32_t EntityBvh::buildNode(uint32_t *handles, size_t count, int32_t parent,
+                             int lane) {
+  const int32_t index = nodes_.size();
+  nodes_.emplace_back();
+  {
+    Node &node = nodes_[index];
+    node.parent = parent;
+    node.lane = lane;
+    node.depth = parent < 0 ? 0 : nodes_[parent].depth + 1;
+    if (node.depth >= refit_.size())
+      refit_.resize(node.depth + 1);
+    node.last_plane = 0;
+    for (int l = 0; l < 4; ++l) {
+      node.child[l] = kEmpty;
+      for (int axis = 0; axis < 3; ++axis) {
+        node.boxes.center[axis][l] = 0;
+        node.boxes.extent[axis][l] = kEmptyExtent;
+      }
+    }
+  }
+
+  // median splits along the longest axis of the centers: in two, then each
+  // half in two again
+  auto split = [this](uint32_t *h, size_t count) {
+    float lo[3], hi[3];
+    for (int axis = 0; axis < 3; ++axis)
+      lo[axis] = hi[axis] = spheres_[h[0] * 4 + axis];
+    for (size_t i = 1; i < count; ++i) {
+      for (int axis = 0; axis < 3; ++axis) {
+        lo[axis] = std::min(lo[axis], spheres_[h[i] * 4 + axis]);
+        hi[axis] = std::max(hi[axis], spheres_[h[i] * 4 + axis]);
+      }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a) {
+      if (hi[a] - lo[a] > hi[axis] - lo[axis])
+        axis = a;
+    }
+    std::nth_element(h, h + count / 2, h + count,
+                     [this, axis](uint32_t a, uint32_t b) {
+                       return spheres_[a * 4 + axis] < spheres_[b * 4 + axis];
+                     });
+    return count / 2;
+  };
+  size_t begin[5] = {0, 1, 2, 3, 4};
+  if (count > 4) {
+    const size_t half = split(handles, count);
+    begin[1] = split(handles, half);
+    begin[2] = half;
+    begin[3] = half + split(handles + half, count - half);
+  }
+  begin[4] = count;
+
+  for (int group = 0; group < 4; ++group) {
+    const size_t size =
+        std::min(begin[group + 1], count) - std::min(begin[group], count);
+    if (size == 0)
+      continue;
+    if (size == 1) {
+      const uint32_t h = handles[begin[group]];
+      const float *sphere = &spheres_[h * 4];
+      const float extent[3] = {sphere[3], sphere[3], sphere[3]};
+      setLane(&nodes_[index], group, ~static_cast<int32_t>(h), sphere,
+              extent);
+      leaves_[h] = index * 4 + group;
+      continue;
+    }
+    const int32_t child =
+        buildNode(handles + begin[group], size, index, group);
+    float center[3], extent[3];
+    bounds(nodes_[child], center, extent);
+    setLane(&nodes_[index], group, child, center, extent);
+  }
+  return index;
+}
+
+void EntityBvh::setLane(Node *node, int lane, int32_t child,
+                        const float center[3], const float extent[3]) {
+  if (node->child[lane] != kEmpty) {
+    const float old[3] = {node->boxes.extent[0][lane],
+                          node->boxes.extent[1][lane],
+                          node->boxes.extent[2][lane]};
+    area_ -= surfaceArea(old);
+  }
+  node->child[lane] = child;
+  for (int axis = 0; axis < 3; ++axis) {
+    node->boxes.center[axis][lane] = center[axis];
+    node->boxes.extent[axis][lane] = extent[axis];
+  }
+  area_ += surfaceArea(extent);
+}
+
+void EntityBvh::bounds(const Node &node, float center[3],
+                       float extent[3]) const {
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (int lane = 0; lane < 4; ++lane) {
+    if (node.child[lane] == kEmpty)
+      continue;
+    for (int axis = 0; axis < 3; ++axis) {
+      const float c = node.boxes.center[axis][lane];
+      const float e = node.boxes.extent[axis][lane];
+      lo[axis] = std::min(lo[axis], c - e);
+      hi[axis] = std::max(hi[axis], c + e);
+    }
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    center[axis] = (lo[axis] + hi[axis]) / 2;
+    extent[axis] = (hi[axis] - lo[axis]) / 2;
+  }
+}
+
+void EntityBvh::cull(const Math::Frustum &frustum, const EntityList &entities,
+                     std::vector<uint8_t> *visible, CullStats *stats) {
+  TRACE_SCOPE("EntityBvh::cull");
+  const int64_t begin = monotonicNowNs();
+  const size_t n = entities.size();
+  if (counters_.empty())
+    counters_.resize(1);
+  for (Counters &c : counters_) {
+    c.visible = 0;
+    c.node_tests = 0;
+  }
+  bool parallel = false;
+  if (linear_) {
+    visible->resize(n);
+    counters_[0].visible = cullLinear(frustum, entities, visible->data());
+  } else {
+    visible->assign(n, 0);
+    if (!nodes_.empty()) {
+      frustum_ = &frustum;
+      entities_ = &entities;
+      visible_ = visible->data();
+      // the faster so far, or the other one now and then: either may
+      // change as the scene does
+      if (!workers_.empty() && n >= kParallelEntities) {
+        const bool probe = ++culls_ % kProbeInterval == 0;
+        if (serial_ns_ == 0 || parallel_ns_ == 0)
+          parallel = parallel_ns_ == 0;
+        else
+          parallel = (parallel_ns_ < serial_ns_) != probe;
+      }
+      const int64_t tree_begin = monotonicNowNs();
+      cullTree(parallel);
+      const int64_t ns = monotonicNowNs() - tree_begin;
+      int64_t &average = parallel ? parallel_ns_ : serial_ns_;
+      average = average == 0 ? ns : (average * 3 + ns) / 4;
+    }
+  }
+
+  if (stats) {
+    CullStats s;
+    for (const Counters &c : counters_) {
+      s.visible += c.visible;
+      s.node_tests += c.node_tests;
+    }
+    s.culled = n - s.visible;
+    s.threads = parallel ? threads() : 1;
+    s.linear = linear_;
+    s.ns = monotonicNowNs() - begin;
+    *stats = s;
+  }
+}
+
+size_t EntityBvh::cullLinear(const Math::Frustum &frustum,
+                             const EntityList &entities, uint8_t *visible) {
+  const size_t n = entities.size();
+  const uint16_t *shapes = entities.shapes();
+  slot_radii_.resize(n);
+  for (size_t slot = 0; slot < n; ++slot)
+    slot_radii_[slot] = radii_[shapes[slot]];
+  return Math::testSpheres(frustum, entities.positions(), slot_radii_.data(),
+                           n, visible);
+}
+
+void EntityBvh::cullTree(bool parallel) {
+  tasks_.assign(1, Task{0, Math::Frustum::kAllPlanes});
+  next_task_ = 0;
+  if (!parallel) {
+    drain(&counters_[0]);
+    return;
+  }
+  // breadth-first on this thread until every thread can take a few
+  // subtrees; the subtrees found entirely inside go down a level as they
+  // are, to be marked by whoever takes them
+  const size_t wanted = counters_.size() * 8;
+  std::vector<Task> level;
+  while (tasks_.size() < wanted) {
+    level.clear();
+    bool expanded = false;
+    for (const Task &task : tasks_) {
+      if (task.planes == 0) {
+        level.push_back(task);
+        continue;
+      }
+      expanded = true;
+      visit(task, &counters_[0],
+            [&level](const Task &child) { level.push_back(child); });
+    }
+    tasks_.swap(level);
+    if (!expanded || tasks_.empty())
+      break;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = workers_.size();
+    ++generation_;
+  }
+  start_.notify_all();
+  drain(&counters_[0]);
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return running_ == 0; });
+}
+
+template <typename Emit>
+void EntityBvh::visit(const Task &task, Counters *counters, Emit emit) {
+  if (task.planes == 0) {
+    markVisible(task.node, counters);
+    return;
+  }
+  // only one thread visits a node, so last_plane needs no synchronization
+  Node &node = nodes_[task.node];
+  Math::Box4Test test;
+  Math::testBoxes(*frustum_, node.boxes, task.planes, node.last_plane,
+                  &test);
+  ++counters->node_tests;
+  for (int lane = 0; lane < 4; ++lane) {
+    const int32_t child = node.child[lane];
+    if (child == kEmpty)
+      continue;
+    if (test.outside & (1 << lane)) {
+      node.last_plane = test.culled_by[lane];
+    } else if (child < 0) {
+      visible_[entities_->slot(~child)] = 1;
+      ++counters->visible;
+    } else {
+      emit(Task{child, test.planes[lane]});
+    }
+  }
+}
+
+void EntityBvh::markVisible(int32_t index, Counters *counters) {
+  const Node &node = nodes_[index];
+  for (int32_t child : node.child) {
+    if (child == kEmpty)
+      continue;
+    if (child < 0) {
+      visible_[entities_->slot(~child)] = 1;
+      ++counters->visible;
+    } else {
+      markVisible(child, counters);
+    }
+  }
+}
+
+void EntityBvh::drain(Counters *counters) {
+  std::vector<Task> &stack = counters->stack;
+  for (size_t i; (i = next_task_.fetch_add(1, std::memory_order_relaxed)) <
+                 tasks_.size();) {
+    stack.push_back(tasks_[i]);
+    while (!stack.empty()) {
+      const Task task = stack.back();
+      stack.pop_back();
+      visit(task, counters,
+            [&stack](const Task &child) { stack.push_back(child); });
+    }
+  }
+}
+
+void EntityBvh::work(int worker, uint64_t generation) {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+      if (stopping_)
+        return;
+      generation = generation_;
+    }
+    drain(&counters_[worker]);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0)
+      done_.notify_one();
+  }
+}
@@ -0,0 +1,169 @@
+#ifndef EGL_SRC_SCENE_ENTITY_BVH_H_
+#define EGL_SRC_SCENE_ENTITY_BVH_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "math/frustum.h"
+#include "scene/entity_list.h"
+#include "scene/shape_list.h"
+
+// A 4-wide bounding volume hierarchy over the entities of an EntityList,
+// for frustum culling. An entity is bounded by the sphere of its shape
+// around its position, which no rotation changes, kept as a box so that a
+// node tests its four children in one SIMD pass per plane
+// (Math::testBoxes).
+//
+// update() follows the entities: the boxes of those that moved (as listed
+// by EntityList::takeMoved()) are refit from their leaves up through the
+// ancestors whose boxes change, so it costs in proportion to the moves, not
+// the scene. That keeps the tree correct but lets the boxes grow and
+// overlap; once their summed surface area passes the rebuild ratio times
+// that of the last build, the tree is built again from scratch.
+//
+// Refitting costs a few cache misses per move, so past the linear fraction
+// of the entities moving in one frame the tree is left as it is and cull()
+// tests every entity's sphere in a linear SIMD pass (Math::testSpheres)
+// instead. The tree is built again once the moves drop under half that.
+//
+// cull() times itself, and with worker threads set it keeps whichever of
+// culling on the calling thread alone or on all of them has been faster,
+// trying the other again every kProbeInterval culls.
+class EntityBvh {
+public:
+  struct Stats {
+    uint64_t builds = 0;
+    uint64_t refits = 0; // entities whose bound was refit
+    uint64_t linear_updates = 0; // update()s that left the tree stale
+    size_t nodes = 0;
+    // summed box area over that of the last build
+    double area_ratio = 1;
+  };
+
+  struct CullStats {
+    size_t visible = 0;
+    size_t culled = 0;
+    uint64_t node_tests = 0; // Math::testBoxes calls
+    int threads = 1;
+    bool linear = false; // every sphere tested, not the tree
+    int64_t ns = 0;
+  };
+
+  // smaller scenes are culled on the calling thread alone
+  static constexpr size_t kParallelEntities = 8192;
+  // culls between tries of the slower of one and all threads
+  static constexpr int kProbeInterval = 64;
+
+  EntityBvh() = default;
+  ~EntityBvh();
+  EntityBvh(const EntityBvh &) = delete;
+  EntityBvh &operator=(const EntityBvh &) = delete;
+
+  void setRebuildRatio(double ratio) { rebuild_ratio_ = ratio; }
+  // of the entities moving in one update(); more, and cull() goes linear
+  void setLinearFraction(double fraction) { linear_fraction_ = fraction; }
+  // threads that cull(), the caller included
+  void setThreads(int threads);
+  int threads() const { return workers_.size() + 1; }
+
+  // brings the tree up to date with |entities|, whose shapes are in
+  // |shapes|, and takes their moved list; builds it when the entity count
+  // changed. One tree per list: another taker would miss moves.
+  void update(EntityList *entities, const ShapeList &shapes);
+  // visible[slot] = 1 when the bound of the entity in |slot| is not
+  // entirely outside |frustum|, 0 otherwise. Slots as of the last update():
+  // |entities| must not be sorted in between. |stats| may be null.
+  void cull(const Math::Frustum &frustum, const EntityList &entities,
+            std::vector<uint8_t> *visible, CullStats *stats = nullptr);
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  static constexpr int32_t kEmpty = INT32_MIN;
+
+  struct Node {
+    Math::Box4 boxes;
+    int32_t child[4]; // a node, ~handle of an entity, or kEmpty
+    int32_t parent;   // -1 at the root
+    uint8_t lane;     // in the parent
+    uint8_t depth;    // 0 at the root
+    uint8_t last_plane; // the last to reject a child
+  };
+  // a subtree to cull against |planes|
+  struct Task {
+    int32_t node;
+    uint32_t planes;
+  };
+  // per thread, apart so that the threads do not share cache lines
+  struct alignas(64) Counters {
+    size_t visible = 0;
+    uint64_t node_tests = 0;
+    std::vector<Task> stack;
+  };
+
+  // copies every entity's sphere and builds the tree over them
+  void rebuild(const EntityList &entities);
+  void build(const EntityList &entities);
+  // the visible count
+  size_t cullLinear(const Math::Frustum &frustum, const EntityList &entities,
+                    uint8_t *visible);
+  // the cull() in progress, through the tree
+  void cullTree(bool parallel);
+  int32_t buildNode(uint32_t *handles, size_t count, int32_t parent,
+                    int lane);
+  void setLane(Node *node, int lane, int32_t child, const float center[3],
+               const float extent[3]);
+  void bounds(const Node &node, float center[3], float extent[3]) const;
+
+  // tests |task| and hands the subtrees to cull further to |emit|
+  template <typename Emit>
+  void visit(const Task &task, Counters *counters, Emit emit);
+  void markVisible(int32_t node, Counters *counters);
+  void drain(Counters *counters);
+  void work(int worker, uint64_t generation);
+
+  double rebuild_ratio_ = 1.5;
+  double linear_fraction_ = 1.0 / 50;
+  // the tree is stale; cull() tests every sphere
+  bool linear_ = false;
+  std::vector<Node> nodes_;
+  std::vector<float> spheres_;     // per handle: x, y, z, radius
+  std::vector<int32_t> leaves_;    // per handle: node * 4 + lane
+  std::vector<float> radii_;       // per shape
+  std::vector<float> slot_radii_;  // cullLinear() scratch, per slot
+  std::vector<uint8_t> dirty_;     // per node: in |refit_|
+  // update() scratch: nodes to refit, per depth
+  std::vector<std::vector<int32_t>> refit_;
+  std::vector<EntityList::Handle> moved_;
+  std::vector<uint32_t> scratch_;
+  double area_ = 0;
+  double build_area_ = 0;
+  Stats stats_;
+
+  // the cull() in progress, for the workers
+  const Math::Frustum *frustum_ = nullptr;
+  const EntityList *entities_ = nullptr;
+  uint8_t *visible_ = nullptr;
+  std::vector<Task> tasks_;
+  std::atomic<size_t> next_task_{0};
+  std::vector<Counters> counters_;
+  // average ns of a tree cull on the calling thread alone and on all
+  // threads; 0 until measured
+  int64_t serial_ns_ = 0;
+  int64_t parallel_ns_ = 0;
+  uint64_t culls_ = 0;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  uint64_t generation_ = 0;
+  int running_ = 0;
+  bool stopping_ = false;
+};
+
+#endif // EGL_SRC_SCENE_ENTITY_BVH_H_
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <numeric>
+
+#include "scene/entity_list.h"
+
+namespace {
+
+// out[i] = in[order[i]] for records of |n| floats
+void gather(const std::vector<uint32_t> &order, int n, std::vector<float> *v,
+            std::vector<float> *scratch) {
+  scratch->resize(v->size());
+  for (size_t i = 0; i < order.size(); ++i)
+    std::copy_n(v->data() + order[i] * n, n, scratch->data() + i * n);
+  v->swap(*scratch);
+}
+
+} // namespace
+
+EntityList::Handle EntityList::add(int shape, float x, float y, float z) {
+  const Handle handle = slots_.size();
+  const uint32_t slot = shapes_.size();
+  if (!shapes_.empty() && shapes_.back() > shape)
+    sorted_ = false;
+  positions_.insert(positions_.end(), {x, y, z});
+  rotations_.insert(rotations_.end(), {0, 0, 0, 1});
+  shapes_.push_back(shape);
+  slots_.push_back(slot);
+  handles_.push_back(handle);
+  moving_.push_back(0);
+  return handle;
+}
+
+void EntityList::markMoved(Handle handle) {
+  if (moving_[handle])
+    return;
+  moving_[handle] = 1;
+  moved_.push_back(handle);
+}
+
+void EntityList::setPosition(Handle handle, float x, float y, float z) {
+  markMoved(handle);
+  float *p = positions_.data() + slots_[handle] * 3;
+  p[0] = x;
+  p[1] = y;
+  p[2] = z;
+}
+
+void EntityList::setRotation(Handle handle, const float q[4]) {
+  std::copy_n(q, 4, rotations_.data() + slots_[handle] * 4);
+}
+
+void EntityList::setShape(Handle handle, int shape) {
+  markMoved(handle);
+  shapes_[slots_[handle]] = shape;
+  sorted_ = false;
+}
+
+void EntityList::takeMoved(std::vector<Handle> *moved) {
+  for (Handle handle : moved_)
+    moving_[handle] = 0;
+  moved->clear();
+  moved->swap(moved_);
+}
+
+void EntityList::sort() {
+  if (sorted_)
+    return;
+  order_.resize(shapes_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  std::stable_sort(order_.begin(), order_.end(), [this](uint32_t a, uint32_t b) {
+    return shapes_[a] < shapes_[b];
+  });
+
+  gather(order_, 3, &positions_, &scratch_);
+  gather(order_, 4, &rotations_, &scratch_);
+  std::vector<uint16_t> shapes(shapes_.size());
+  std::vector<Handle> handles(handles_.size());
+  for (size_t i = 0; i < order_.size(); ++i) {
+    shapes[i] = shapes_[order_[i]];
+    handles[i] = handles_[order_[i]];
+    slots_[handles[i]] = i;
+  }
+  shapes_.swap(shapes);
+  handles_.swap(handles);
+  sorted_ = true;
+}
@@ -0,0 +1,53 @@
+#ifndef EGL_SRC_SCENE_ENTITY_LIST_H_
+#define EGL_SRC_SCENE_ENTITY_LIST_H_
+
+#include <cstdint>
+#include <vector>
+
+// Entities (sample2's Entity) stored structure-of-arrays and kept sorted by
+// shape, so that a renderer walks each array linearly and finds all
+// entities of a shape next to each other. Handles stay valid across the
+// reordering.
+class EntityList {
+public:
+  using Handle = uint32_t;
+
+  Handle add(int shape, float x, float y, float z);
+  void setPosition(Handle handle, float x, float y, float z);
+  // (x, y, z, w)
+  void setRotation(Handle handle, const float q[4]);
+  void setShape(Handle handle, int shape);
+
+  // restores the shape order after add() or setShape()
+  void sort();
+  bool sorted() const { return sorted_; }
+
+  size_t size() const { return shapes_.size(); }
+  // indexed by slot, not by handle: 3 floats per entity
+  const float *positions() const { return positions_.data(); }
+  // 4 floats per entity
+  const float *rotations() const { return rotations_.data(); }
+  const uint16_t *shapes() const { return shapes_.data(); }
+  uint32_t slot(Handle handle) const { return slots_[handle]; }
+  Handle handle(uint32_t slot) const { return handles_[slot]; }
+
+  // the handles given to setPosition() or setShape() since the last call,
+  // each once, in |moved| (cleared first)
+  void takeMoved(std::vector<Handle> *moved);
+
+private:
+  void markMoved(Handle handle);
+
+  std::vector<float> positions_;
+  std::vector<float> rotations_;
+  std::vector<uint16_t> shapes_;
+  std::vector<uint32_t> slots_;   // handle -> slot
+  std::vector<Handle> handles_;   // slot -> handle
+  std::vector<Handle> moved_;
+  std::vector<uint8_t> moving_;   // per handle: in |moved_|
+  std::vector<uint32_t> order_;   // sort() scratch
+  std::vector<float> scratch_;
+  bool sorted_ = true;
+};
+
+#endif // EGL_SRC_SCENE_ENTITY_LIST_H_
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+
+#include "math/mat4.h"
+#include "scene/sample_scene.h"
+
+namespace {
+
+// RGBA8, R in the lowest byte
+constexpr uint32_t rgba(float r, float g, float b) {
+  return static_cast<uint32_t>(r * 255) |
+         static_cast<uint32_t>(g * 255) << 8 |
+         static_cast<uint32_t>(b * 255) << 16 | 0xff000000u;
+}
+
+const std::array<uint32_t, 6> kCubeColor1 = {
+    rgba(0, 0, 1), rgba(0, 1, 0), rgba(0, 1, 1),
+    rgba(1, 0, 0), rgba(1, 0, 1), rgba(1, 1, 0)};
+const std::array<uint32_t, 6> kCubeColor2 = {
+    rgba(0.2f, 0.2f, 0.2f), rgba(0.3f, 0.3f, 0.3f), rgba(0.4f, 0.4f, 0.4f),
+    rgba(0.6f, 0.6f, 0.6f), rgba(0.7f, 0.7f, 0.7f), rgba(0.8f, 0.8f, 0.8f)};
+
+constexpr float kGridSpacing = 0.75f;
+
+} // namespace
+
+void SampleScene::build(int entities) {
+  const int cube1 = shapes_.push(createCubeShape(1.0f, kCubeColor1));
+  const int cube2 = shapes_.push(createCubeShape(0.2f, kCubeColor2));
+  const int cube3 = shapes_.push(createCubeShape(0.4f, kCubeColor1));
+
+  struct Placement {
+    int shape;
+    float x, y, z;
+    bool spins;
+  };
+  const Placement sample[] = {{cube1, -1.5f, 0, 0, true},
+                              {cube2, 1.5f, 0, 0, true},
+                              {cube3, 0, 0, 0, false},
+                              {cube2, 0, 0, 1.5f, false}};
+  for (int i = 0; i < entities && i < 4; ++i) {
+    const Placement &p = sample[i];
+    const EntityList::Handle h = entities_.add(p.shape, p.x, p.y, p.z);
+    if (p.spins)
+      spinning_.push_back(h);
+  }
+
+  // the rest on a square grid in the y = -1 plane, shapes interleaved so
+  // that the list has to be sorted
+  const int rest = entities - 4;
+  if (rest <= 0)
+    return;
+  const int side = static_cast<int>(std::ceil(std::sqrt(rest)));
+  const float half = (side - 1) * kGridSpacing / 2;
+  for (int i = 0; i < rest; ++i) {
+    const float x = (i % side) * kGridSpacing - half;
+    const float z = (i / side) * kGridSpacing - half;
+    spinning_.push_back(entities_.add(i % 2 ? cube3 : cube2, x, -1.0f, z));
+  }
+  camera_distance_ = std::max(5.0f, half * 1.5f);
+}
+
+void SampleScene::animate(double time_sec) {
+  const double ms = time_sec * 1000;
+  const Math::Quat q =
+      Math::Quat::fromEuler(0, static_cast<float>(fmod(0.06 * ms, 360.0)),
+                            static_cast<float>(fmod(0.1 * ms, 360.0)));
+  for (EntityList::Handle h : spinning_)
+    entities_.setRotation(h, q.data());
+}
+
+void SampleScene::viewProjection(double time_sec, float aspect,
+                                 float out[16]) const {
+  const float r = static_cast<float>(time_sec);
+  const Math::Vec3 eye(camera_distance_ * std::cos(r),
+                       2.0f * std::sin(0.2f * r) + camera_distance_ / 5 - 1,
+                       camera_distance_ * std::sin(r));
+  const Math::Mat4 view_projection =
+      Math::Mat4::perspective(Math::radians(45), aspect, 0.1f,
+                              100.0f + camera_distance_) *
+      Math::Mat4::lookAt(eye, Math::Vec3(0, 0, 0), Math::Vec3(0, 1, 0));
+  std::copy_n(view_projection.data(), 16, out);
+}
@@ -0,0 +1,28 @@
+#ifndef EGL_SRC_SCENE_SAMPLE_SCENE_H_
+#define EGL_SRC_SCENE_SAMPLE_SCENE_H_
+
+#include <vector>
+
+#include "scene/entity_list.h"
+#include "scene/shape_list.h"
+
+// The cubes of webgl/src/sample2/main.ts. Entities past sample2's four are
+// spread over a grid around them, every one spinning.
+class SampleScene {
+public:
+  void build(int entities);
+  void animate(double time_sec);
+  // camera orbiting the origin at |time_sec|
+  void viewProjection(double time_sec, float aspect, float out[16]) const;
+
+  const ShapeList &shapes() const { return shapes_; }
+  EntityList *entities() { return &entities_; }
+
+private:
+  ShapeList shapes_;
+  EntityList entities_;
+  std::vector<EntityList::Handle> spinning_;
+  float camera_distance_ = 5.0f;
+};
+
+#endif // EGL_SRC_SCENE_SAMPLE_SCENE_H_
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cmath>
+
+#include "scene/shape_list.h"
+#include "base/logging.h"
+
+int ShapeList::push(const Shape &shape) {
+  if (shape.vertices.size() != shape.colors.size()) {
+    LOG_E << "shape has " << shape.vertices.size() << " vertices but "
+          << shape.colors.size() << " colors";
+    return -1;
+  }
+  const size_t base = vertices_.size();
+  if (base + shape.vertices.size() > 0x10000) {
+    LOG_E << "shape list exceeds 16-bit indices";
+    return -1;
+  }
+  for (const auto &triangle : shape.indices) {
+    for (uint16_t i : triangle) {
+      if (i >= shape.vertices.size()) {
+        LOG_E << "shape index out of range: " << i;
+        return -1;
+      }
+    }
+  }
+
+  ranges_.push_back({static_cast<uint32_t>(indices_.size()),
+                     static_cast<uint32_t>(shape.indices.size() * 3)});
+  vertex_offsets_.push_back(static_cast<uint32_t>(base));
+  vertices_.insert(vertices_.end(), shape.vertices.begin(),
+                   shape.vertices.end());
+  colors_.insert(colors_.end(), shape.colors.begin(), shape.colors.end());
+  for (const auto &triangle : shape.indices) {
+    for (uint16_t i : triangle)
+      indices_.push_back(static_cast<uint16_t>(base + i));
+  }
+  return size() - 1;
+}
+
+uint32_t ShapeList::vertexCount(int shape) const {
+  const uint32_t end = shape + 1 < size() ? vertex_offsets_[shape + 1]
+                                          : vertices_.size();
+  return end - vertex_offsets_[shape];
+}
+
+float ShapeList::radius(int shape) const {
+  float squared = 0;
+  const uint32_t begin = vertex_offsets_[shape];
+  for (uint32_t i = begin; i < begin + vertexCount(shape); ++i) {
+    const std::array<float, 3> &v = vertices_[i];
+    squared = std::max(squared, v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  }
+  return std::sqrt(squared);
+}
+
+Shape createCubeShape(float width, const std::array<uint32_t, 6> &colors) {
+  Shape shape;
+  const float a[] = {-width / 2, width / 2};
+  // per-face vertices so that every face gets its own color
+  for (int axis = 0; axis < 3; ++axis) {
+    for (float s : a) {
+      const uint16_t k = shape.vertices.size();
+      for (float x : a) {
+        for (float y : a) {
+          std::array<float, 3> v;
+          v[axis] = s;
+          v[axis == 0 ? 1 : 0] = x;
+          v[axis == 2 ? 1 : 2] = y;
+          shape.vertices.push_back(v);
+          shape.colors.push_back(colors[shape.colors.size() / 4]);
+        }
+      }
+      shape.indices.push_back({k, static_cast<uint16_t>(k + 1),
+                               static_cast<uint16_t>(k + 2)});
+      shape.indices.push_back({static_cast<uint16_t>(k + 2),
+                               static_cast<uint16_t>(k + 1),
+                               static_cast<uint16_t>(k + 3)});
+    }
+  }
+  return shape;
+}
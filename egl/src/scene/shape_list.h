@@ -0,0 +1,53 @@
+#ifndef EGL_SRC_SCENE_SHAPE_LIST_H_
+#define EGL_SRC_SCENE_SHAPE_LIST_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// native counterpart of webgl/src/sample2/shape.ts
+struct Shape {
+  std::vector<std::array<float, 3>> vertices;
+  std::vector<uint32_t> colors; // RGBA8 per vertex, R in the lowest byte
+  std::vector<std::array<uint16_t, 3>> indices;
+};
+
+// Concatenates shapes into one vertex and one index array so that a single
+// VBO/IBO pair holds all of them; a shape is then a range of indices.
+class ShapeList {
+public:
+  struct IndexRange {
+    uint32_t offset; // in indices
+    uint32_t length;
+  };
+
+  // returns the shape id, or -1 when the shape is malformed
+  int push(const Shape &shape);
+
+  const std::vector<std::array<float, 3>> &vertices() const {
+    return vertices_;
+  }
+  const std::vector<uint32_t> &colors() const { return colors_; }
+  // already offset into the concatenated vertices
+  const std::vector<uint16_t> &indices() const { return indices_; }
+  const IndexRange &range(int shape) const { return ranges_[shape]; }
+  // first vertex and vertex count of |shape|
+  uint32_t vertexOffset(int shape) const { return vertex_offsets_[shape]; }
+  uint32_t vertexCount(int shape) const;
+  // of the smallest sphere around the shape's origin that holds it
+  float radius(int shape) const;
+  int size() const { return static_cast<int>(ranges_.size()); }
+
+private:
+  std::vector<std::array<float, 3>> vertices_;
+  std::vector<uint32_t> colors_;
+  std::vector<uint16_t> indices_;
+  std::vector<IndexRange> ranges_;
+  std::vector<uint32_t> vertex_offsets_;
+};
+
+// an axis aligned cube of edge |width|, one color per face
+// (-x, +x, -y, +y, -z, +z), as createCubeShape in shape_factory.ts
+Shape createCubeShape(float width, const std::array<uint32_t, 6> &colors);
+
+#endif // EGL_SRC_SCENE_SHAPE_LIST_H_
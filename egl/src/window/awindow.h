@@ -1,6 +1,18 @@
 #ifndef EGL_SRC_WINDOW_AWINDOW_H_
 #define EGL_SRC_WINDOW_AWINDOW_H_
 
+struct WindowEvent {
+  enum class Type {
+    kExpose, // contents lost, redraw
+    kResize,
+    kClose,
+  };
+  Type type = Type::kExpose;
+  // kResize only
+  int width = 0;
+  int height = 0;
+};
+
 class AWindow {
 public:
   AWindow() = default;
@@ -10,6 +22,11 @@ public:
   virtual void *getNativeDisplay() const = 0;
   virtual void *getNativeWindow() const = 0;
 
+  // readable when events may be pending; -1 when there is none
+  virtual int eventFd() const { return -1; }
+  // the next pending event, without blocking
+  virtual bool pollEvent(WindowEvent *event) { return false; }
+
 private:
 };
 
@@ -15,7 +15,7 @@ public:
 
 private:
   Display *xdisplay_ = nullptr;
-} g_display;
+};
 
 DisplayX11::DisplayX11() {
   //
@@ -32,6 +32,12 @@ DisplayX11::~DisplayX11() {
   }
 }
 
+// opened on first use so that headless runs never touch X
+DisplayX11 &getDisplayX11() {
+  static DisplayX11 display;
+  return display;
+}
+
 } // namespace
 
 //
@@ -39,35 +45,90 @@ DisplayX11::~DisplayX11() {
 AWindowX11::AWindowX11() {}
 
 AWindowX11::~AWindowX11() {
-  Display *display = g_display.getXDisplay();
+  if (!window_)
+    return;
+
+  Display *display = getDisplayX11().getXDisplay();
 
   if (display == nullptr) {
     return;
   }
 
-  if (window_)
-    XDestroyWindow(display, window_);
+  XDestroyWindow(display, window_);
 }
 
 bool AWindowX11::initialize() {
 
-  Display *display = g_display.getXDisplay();
+  Display *display = getDisplayX11().getXDisplay();
 
   if (display == nullptr) {
     return false;
   }
 
+  width_ = 1024;
+  height_ = 768;
   window_ = XCreateSimpleWindow(display, DefaultRootWindow(display), 100, 100,
-                                1024, 768, 1, BlackPixel(display, 0),
+                                width_, height_, 1, BlackPixel(display, 0),
                                 WhitePixel(display, 0));
+  XSelectInput(display, window_, ExposureMask | StructureNotifyMask);
+  // the close button sends WM_DELETE_WINDOW instead of killing the client
+  wm_delete_window_ = XInternAtom(display, "WM_DELETE_WINDOW", False);
+  XSetWMProtocols(display, window_, &wm_delete_window_, 1);
 
   XMapWindow(display, window_);
 
   return true;
 }
 
-void *AWindowX11::getNativeDisplay() const { return g_display.getXDisplay(); }
+void *AWindowX11::getNativeDisplay() const {
+  return getDisplayX11().getXDisplay();
+}
 
 void *AWindowX11::getNativeWindow() const {
   return reinterpret_cast<void *>(window_);
 }
+
+int AWindowX11::eventFd() const {
+  Display *display = getDisplayX11().getXDisplay();
+  return display ? ConnectionNumber(display) : -1;
+}
+
+bool AWindowX11::pollEvent(WindowEvent *event) {
+  Display *display = getDisplayX11().getXDisplay();
+  if (!display || !window_)
+    return false;
+  // XPending also reads what arrived on the socket, so the fd may stay
+  // quiet while events are queued: drain before polling again
+  while (XPending(display)) {
+    XEvent xevent;
+    XNextEvent(display, &xevent);
+    switch (xevent.type) {
+    case Expose:
+      // the last of a series covers the whole damage
+      if (xevent.xexpose.count > 0)
+        continue;
+      event->type = WindowEvent::Type::kExpose;
+      return true;
+    case ConfigureNotify:
+      if (xevent.xconfigure.width == width_ &&
+          xevent.xconfigure.height == height_)
+        continue; // moved only
+      width_ = xevent.xconfigure.width;
+      height_ = xevent.xconfigure.height;
+      event->type = WindowEvent::Type::kResize;
+      event->width = width_;
+      event->height = height_;
+      return true;
+    case ClientMessage:
+      if (static_cast<Atom>(xevent.xclient.data.l[0]) != wm_delete_window_)
+        continue;
+      event->type = WindowEvent::Type::kClose;
+      return true;
+    case DestroyNotify:
+      window_ = 0;
+      event->type = WindowEvent::Type::kClose;
+      return true;
+    }
+  }
+  return false;
+}
@@ -14,8 +14,14 @@ public:
   void *getNativeDisplay() const override;
   void *getNativeWindow() const override;
 
+  int eventFd() const override;
+  bool pollEvent(WindowEvent *event) override;
+
 private:
   Window window_ = 0;
+  Atom wm_delete_window_ = 0;
+  int width_ = 0;
+  int height_ = 0;
 };
 
 #endif // EGL_SRC_WINDOW_AWINDOW_X11_H_